@@ -22,3 +22,15 @@ static FORCEINLINE FVector SnapToGrid(const FVector& InLocation)
 	float Y = FMath::RoundToFloat(InLocation.Y / TileSize) * TileSize;
 	return FVector(X, Y, InLocation.Z);
 }
+
+// Integer grid cell of a position, the key used by FSnakeGrid
+static FORCEINLINE FIntPoint WorldToCell(const FVector& InLocation)
+{
+	return FIntPoint(FMath::RoundToInt(InLocation.X / TileSize), FMath::RoundToInt(InLocation.Y / TileSize));
+}
+
+// Center of a grid cell, the inverse of WorldToCell
+static FORCEINLINE FVector CellToWorld(const FIntPoint& InCell, float Z = 0.0f)
+{
+	return FVector(InCell.X * TileSize, InCell.Y * TileSize, Z);
+}
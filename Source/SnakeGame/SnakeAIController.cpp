@@ -1,24 +1,41 @@
 #include "SnakeAIController.h"
 
-#include <queue>
-
+#include "SnakeAIPlanner.h"
 #include "SnakePawn.h"
+#include "SnakeSimSubsystem.h"
 #include "SnakeWorld.h"
-#include "SnakeFood.h"
 #include "Definitions.h"
 #include "Kismet/GameplayStatics.h"
 #include "DrawDebugHelpers.h"
-#include "SnakeTailSegment.h"
+#include "EngineUtils.h"
 
 ASnakeAIController::ASnakeAIController()
 {
     PrimaryActorTick.bCanEverTick = true;
 }
 
-void ASnakeAIController::Tick(float DeltaTime)
+void ASnakeAIController::BeginPlay()
 {
-    Super::Tick(DeltaTime);
+    Super::BeginPlay();
+
+    // Decide once per simulation step, however many of them fall into a frame
+    if (USnakeSimSubsystem* Sim = GetWorld()->GetSubsystem<USnakeSimSubsystem>())
+    {
+        SimStepHandle = Sim->OnPreStep.AddUObject(this, &ASnakeAIController::OnSimStep);
+    }
+}
 
+void ASnakeAIController::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (USnakeSimSubsystem* Sim = GetWorld()->GetSubsystem<USnakeSimSubsystem>())
+    {
+        Sim->OnPreStep.Remove(SimStepHandle);
+    }
+    Super::EndPlay(EndPlayReason);
+}
+
+void ASnakeAIController::OnSimStep(uint32 Step)
+{
     ASnakePawn* Snake = Cast<ASnakePawn>(GetPawn());
     if (!Snake) return;
 
@@ -27,41 +44,39 @@ void ASnakeAIController::Tick(float DeltaTime)
         return;
     PrevTilePosition = Snake->LastTilePosition;
 
-    // Find & snap the closest apple
-    TArray<AActor*> Foods;
-    UGameplayStatics::GetAllActorsOfClass(GetWorld(), ASnakeFood::StaticClass(), Foods);
-    if (Foods.Num() == 0) return;
+    ASnakeWorld* World = GetSnakeWorld();
+    if (!World) return;
 
-    AActor* Closest = Foods[0];
-    float Best = FVector::Dist(PrevTilePosition, Closest->GetActorLocation());
-    for (AActor* F : Foods)
+    ESnakeDirection Dir = ESnakeDirection::None;
+    if (PathMode == ESnakePathMode::FlowField)
+        Dir = ChooseFlowFieldDirection(*Snake, *World);
+    else if (PathMode == ESnakePathMode::MonteCarlo)
+        Dir = ChooseMonteCarloDirection(*Snake, *World);
+    else if (PathMode == ESnakePathMode::Incremental || PathMode == ESnakePathMode::Hierarchical || PathMode == ESnakePathMode::SpaceTime)
+        Dir = ChooseSearchDirection(*World);
+    else if (bUseCentralPlanner)
     {
-        float D = FVector::Dist(PrevTilePosition, F->GetActorLocation());
-        if (D < Best) { Best = D; Closest = F; }
+        // Answered before the snakes move through ApplyPlannedDirection
+        RequestCentralPlan(*Snake, *World);
+        return;
     }
-    FVector Goal = SnapToGrid(Closest->GetActorLocation());
+    else if (bPlanAhead)
+        Dir = TakePlannedDirection(*World);
+    else
+        Dir = ChooseSearchDirection(*World);
 
-    // Run BFS
-    TArray<FVector> Path;
-    if (!FindPath(PrevTilePosition, Goal, Path) || Path.Num() < 2)
-        return;
+    if (bSurvivalCheck)
+        Dir = CheckSurvival(*Snake, *World, Dir);
 
-    // Debug draw
-    for (int32 i = 0; i < Path.Num(); ++i)
-    {
-        DrawDebugSphere(GetWorld(), Path[i], TileSize * 0.2f, 8, FColor::Yellow, false, 0.1f);
-        if (i < Path.Num() - 1)
-            DrawDebugLine(GetWorld(), Path[i], Path[i+1], FColor::Blue, false, 0.1f, 0, 5.f);
-    }
+    if (Dir != ESnakeDirection::None)
+        ApplyDirection(*Snake, Dir);
 
-    // Next step delta
-    FVector Delta = Path[1] - PrevTilePosition;
-    ESnakeDirection Dir = ESnakeDirection::None;
-    if (FMath::Abs(Delta.X) > FMath::Abs(Delta.Y))
-        Dir = (Delta.X > 0) ? ESnakeDirection::Up : ESnakeDirection::Down;
-    else
-        Dir = (Delta.Y > 0) ? ESnakeDirection::Right : ESnakeDirection::Left;
+    if ((PathMode == ESnakePathMode::Search || PathMode == ESnakePathMode::JumpPoint) && bPlanAhead)
+        LaunchPlan(*Snake, *World);
+}
 
+void ASnakeAIController::ApplyDirection(ASnakePawn& Snake, ESnakeDirection Dir) const
+{
     // NO U-turn: only skip the *set* if it’s opposite, but do NOT abort the rest of the tick
     auto IsOpposite = [](ESnakeDirection A, ESnakeDirection B){
         return (A == ESnakeDirection::Up    && B == ESnakeDirection::Down)  ||
@@ -70,13 +85,13 @@ void ASnakeAIController::Tick(float DeltaTime)
                (A == ESnakeDirection::Right && B == ESnakeDirection::Left);
     };
 
-    if (!IsOpposite(Snake->Direction, Dir))
+    if (!IsOpposite(Snake.Direction, Dir))
     {
         // Queue & face
-        if (Snake->Direction != Dir)
+        if (Snake.Direction != Dir)
         {
-            Snake->SetNextDirection(Dir);
-            Snake->Direction = Dir;
+            Snake.SetNextDirection(Dir);
+            Snake.Direction = Dir;
 
             FRotator NewRot;
             switch (Dir)
@@ -85,16 +100,16 @@ void ASnakeAIController::Tick(float DeltaTime)
                 case ESnakeDirection::Right: NewRot = {0,  90,   0}; break;
                 case ESnakeDirection::Down:  NewRot = {0, 180,   0}; break;
                 case ESnakeDirection::Left:  NewRot = {0, 270,   0}; break;
-                default:                     NewRot = Snake->GetActorRotation(); break;
+                default:                     NewRot = Snake.GetActorRotation(); break;
             }
-            Snake->SetActorRotation(NewRot);
+            Snake.SetActorRotation(NewRot);
         }
     }
     else
     {
         UE_LOG(LogTemp, Verbose,
                TEXT("AI: skipping U-turn from %s to %s"),
-               *UEnum::GetValueAsString(Snake->Direction),
+               *UEnum::GetValueAsString(Snake.Direction),
                *UEnum::GetValueAsString(Dir));
     }
 }
@@ -104,94 +119,309 @@ FVector ASnakeAIController::SnapToGrid(const FVector& WorldPos)
     return ::SnapToGrid(WorldPos);
 }
 
-bool ASnakeAIController::FindPath(
-    const FVector& Start,
-    const FVector& Goal,
-    TArray<FVector>& OutPath
-) const
-{
-    // Get the world and its walkable tiles
-    ASnakeWorld* World = Cast<ASnakeWorld>(
-        UGameplayStatics::GetActorOfClass(GetWorld(), ASnakeWorld::StaticClass())
-    );
-    if (!World) return false;
-
-    TSet<FVector> Walkable(World->FloorTileLocations);
-
-    // Exclude tiles occupied by the snake’s tail
-    TSet<FVector> BodyTiles;
-    if (ASnakePawn* SnakePawn = Cast<ASnakePawn>(GetPawn()))
-    {
-        auto SnapGrid = [&](const FVector& V){
-            return FVector(
-                FMath::RoundToFloat(V.X / TileSize) * TileSize,
-                FMath::RoundToFloat(V.Y / TileSize) * TileSize,
-                V.Z
-            );
-        };
-        for (ASnakeTailSegment* Segment : SnakePawn->TailSegments)
+ESnakeDirection ASnakeAIController::ChooseFlowFieldDirection(const ASnakePawn& Snake, ASnakeWorld& World) const
+{
+    const FSnakeFlowField& Field = World.GetFlowField();
+    const FSnakeGrid& Grid = World.GetGrid();
+
+    // Never the way back, the snake can't turn around on the spot
+    const int32 Back = Snake.Direction != ESnakeDirection::None ? (int32(Snake.Direction) + 2) % FSnakeGrid::NumDirections : INDEX_NONE;
+    const int32 Best = Field.GetBestDirection(Grid, Grid.ToIndex(World.WorldToGridCell(PrevTilePosition)), Back);
+    return Best != INDEX_NONE ? ESnakeDirection(Best) : ESnakeDirection::None;
+}
+
+ESnakeDirection ASnakeAIController::ChooseSearchDirection(ASnakeWorld& World)
+{
+    const FSnakeGrid& Grid = World.GetGrid();
+    const int32 Start = Grid.ToIndex(World.WorldToGridCell(PrevTilePosition));
+    if (!FindPath(World, Start) || PathCells.Num() < 2)
+        return ESnakeDirection::None;
+
+    DrawPath(World, PathCells);
+    const int32 Dir = Grid.GetDirectionTo(PathCells[0], PathCells[1]);
+    return Dir != INDEX_NONE ? ESnakeDirection(Dir) : ESnakeDirection::None;
+}
+
+ESnakeDirection ASnakeAIController::ChooseMonteCarloDirection(const ASnakePawn& Snake, const ASnakeWorld& World)
+{
+    const FSnakeGrid& Grid = World.GetGrid();
+    const int32 Head = Grid.ToIndex(World.WorldToGridCell(PrevTilePosition));
+    if (Head == INDEX_NONE)
+        return ESnakeDirection::None;
+
+    // One tile on from the last search, the tree below the move we made is still good
+    const int32 Moved = MonteCarloHead != INDEX_NONE ? Grid.GetDirectionTo(MonteCarloHead, Head) : INDEX_NONE;
+    if (Moved != INDEX_NONE)
+        MonteCarlo.Advance(Moved);
+    else
+        MonteCarlo.Reset();
+    MonteCarloHead = Head;
+
+    // Our snake first, then everyone else on the board
+    SimState.Init(Grid);
+    TArray<int32, TInlineAllocator<64>> Body;
+    auto AddSnake = [&](const ASnakePawn& Pawn)
+    {
+        Body.Reset();
+        Body.Add(Grid.ToIndex(World.WorldToGridCell(Pawn.LastTilePosition)));
+        for (const FIntPoint& Tile : Pawn.TailCells)
+            Body.Add(Grid.ToIndex(World.WorldToGridCell(CellToWorld(Tile))));
+        SimState.AddSnake(Body, Pawn.Direction != ESnakeDirection::None ? int32(Pawn.Direction) : INDEX_NONE);
+    };
+    AddSnake(Snake);
+    for (TActorIterator<ASnakePawn> It(GetWorld()); It; ++It)
+    {
+        if (*It != &Snake && It->HasActorBegunPlay())
+            AddSnake(**It);
+    }
+
+    FSnakeMonteCarlo::FSettings Settings;
+    Settings.TimeBudget = MonteCarloBudgetMs * 0.001;
+    Settings.RolloutDepth = MonteCarloRolloutDepth;
+    const int32 Move = MonteCarlo.Search(SimState, 0, Settings);
+
+    UE_LOG(LogTemp, Verbose, TEXT("AI: Monte Carlo played %d games, %d nodes kept"), MonteCarlo.GetNumRollouts(), MonteCarlo.GetNumNodes());
+    return Move != INDEX_NONE ? ESnakeDirection(Move) : ESnakeDirection::None;
+}
+
+ESnakeDirection ASnakeAIController::CheckSurvival(const ASnakePawn& Snake, ASnakeWorld& World, ESnakeDirection Dir)
+{
+    // No new direction means carrying on the way we're going
+    if (Dir == ESnakeDirection::None)
+        Dir = Snake.Direction;
+    if (Dir == ESnakeDirection::None)
+        return Dir;
+
+    const FSnakeGrid& Grid = World.GetGrid();
+    const int32 Head = Grid.ToIndex(World.WorldToGridCell(PrevTilePosition));
+    if (Head == INDEX_NONE)
+        return Dir;
+
+    Bitboard.Sync(Grid, World.GetGridJournal());
+
+    // Enough room to uncoil the whole body, or our tail end in reach, which frees up as we go
+    const int32 Needed = Snake.TailCells.Num() + 1;
+    const int32 Tail = Snake.TailCells.Num() > 0
+        ? Grid.ToIndex(World.WorldToGridCell(CellToWorld(Snake.TailCells.Last())))
+        : INDEX_NONE;
+    const int32 Back = Snake.Direction != ESnakeDirection::None ? (int32(Snake.Direction) + 2) % FSnakeGrid::NumDirections : INDEX_NONE;
+
+    // The planned move first, the other two only if it's a trap
+    int32 Candidates[FSnakeGrid::NumDirections] = { int32(Dir), 0, 0, 0 };
+    int32 NumCandidates = 1;
+    for (int32 Direction = 0; Direction < FSnakeGrid::NumDirections; Direction++)
+    {
+        if (Direction != int32(Dir))
+            Candidates[NumCandidates++] = Direction;
+    }
+
+    int32 Best = INDEX_NONE;
+    int32 BestRoom = 0;
+    for (const int32 Direction : Candidates)
+    {
+        const int32 Next = Grid.GetNeighbour(Head, Direction);
+        if (Direction == Back || Next == INDEX_NONE || !Bitboard.IsFree(Next))
+            continue;
+
+        const int32 Room = Bitboard.FillFrom(Next, Needed);
+        if (Room >= Needed || (Tail != INDEX_NONE && Bitboard.IsNextToReached(Tail)))
+            return ESnakeDirection(Direction);
+
+        if (Room > BestRoom)
         {
-            BodyTiles.Add(SnapGrid(Segment->GetActorLocation()));
+            BestRoom = Room;
+            Best = Direction;
         }
-        BodyTiles.Remove(Start);
     }
-    auto Snap = [&](const FVector& V){
-        return FVector(
-            FMath::RoundToFloat(V.X / TileSize) * TileSize,
-            FMath::RoundToFloat(V.Y / TileSize) * TileSize,
-            V.Z
-        );
-    };
-    FVector S = Snap(Start), G = Snap(Goal);
-    if (!Walkable.Contains(G)) return false;
-
-    // BFS setup
-    std::queue<FVector> Q;
-    Q.push(S);
-    TMap<FVector, FVector> CameFrom;
-    CameFrom.Add(S, S);
-
-    static const TArray<FVector> Directions = {
-        FVector(TileSize, 0, 0),
-        FVector(-TileSize, 0, 0),
-        FVector(0, TileSize, 0),
-        FVector(0, -TileSize, 0)
-    };
 
-    // BFS loop, skips any body‐occupied tile
-    while (!Q.empty())
+    if (Best != INDEX_NONE && Best != int32(Dir))
+        UE_LOG(LogTemp, Verbose, TEXT("AI: %s would trap us, taking the direction with the most room"), *UEnum::GetValueAsString(Dir));
+    return Best != INDEX_NONE ? ESnakeDirection(Best) : Dir;
+}
+
+void ASnakeAIController::RequestCentralPlan(const ASnakePawn& Snake, const ASnakeWorld& World)
+{
+    USnakeAIPlanner* Planner = GetWorld()->GetSubsystem<USnakeAIPlanner>();
+    if (!Planner) return;
+
+    const FSnakeGrid& Grid = World.GetGrid();
+    const int32 Back = Snake.Direction != ESnakeDirection::None ? (int32(Snake.Direction) + 2) % FSnakeGrid::NumDirections : INDEX_NONE;
+    Planner->RequestPlan(*this, Grid.ToIndex(World.WorldToGridCell(PrevTilePosition)), Back,
+                         PathMode == ESnakePathMode::JumpPoint, bRankFoodByPath);
+}
+
+void ASnakeAIController::ApplyPlannedDirection(ESnakeDirection Dir)
+{
+    ASnakePawn* Snake = Cast<ASnakePawn>(GetPawn());
+    if (!Snake) return;
+
+    ASnakeWorld* World = GetSnakeWorld();
+    if (bSurvivalCheck && World)
+        Dir = CheckSurvival(*Snake, *World, Dir);
+
+    if (Dir != ESnakeDirection::None)
+        ApplyDirection(*Snake, Dir);
+}
+
+ESnakeDirection ASnakeAIController::TakePlannedDirection(ASnakeWorld& World)
+{
+    // Nothing planned yet (first tile, or the snake stood still), decide on the spot
+    if (!PlanTask.IsValid())
+        return ChooseSearchDirection(World);
+
+    if (!PlanTask.IsCompleted())
+    {
+        // Late: keep going rather than wait on the game thread. The task keeps its plan alive until it's done.
+        UE_LOG(LogTemp, Verbose, TEXT("AI: plan for this tile isn't ready, keeping direction"));
+        Plan.Reset();
+        PlanTask = {};
+        return ESnakeDirection::None;
+    }
+    PlanTask = {};
+
+    // The plan guessed the tile from the direction we had, it's void if the snake ended up elsewhere
+    const FSnakeGrid& Grid = World.GetGrid();
+    if (Plan->Start != Grid.ToIndex(World.WorldToGridCell(PrevTilePosition)) || Plan->Direction == INDEX_NONE)
+        return ESnakeDirection::None;
+
+    DrawPath(World, Plan->Path);
+    return ESnakeDirection(Plan->Direction);
+}
+
+void ASnakeAIController::LaunchPlan(const ASnakePawn& Snake, ASnakeWorld& World)
+{
+    if (Snake.Direction == ESnakeDirection::None)
+        return;
+
+    // The snake is committed to its direction on this tile, so the next tile is known already
+    const FSnakeGrid& Grid = World.GetGrid();
+    const int32 Current = Grid.ToIndex(World.WorldToGridCell(PrevTilePosition));
+    const int32 Next = Current != INDEX_NONE ? Grid.GetNeighbour(Current, int32(Snake.Direction)) : INDEX_NONE;
+    if (Next == INDEX_NONE)
+        return;
+
+    if (!Plan.IsValid())
+        Plan = MakeShared<FSnakeAIPlan>();
+
+    Plan->Grid = World.GetGridSnapshot();
+    World.GetFoodCells(Plan->FoodCells);
+    Plan->Start = Next;
+    Plan->bJumpPoint = PathMode == ESnakePathMode::JumpPoint;
+    Plan->bRankFoodByPath = bRankFoodByPath;
+    Plan->NextHops = World.GetNextHopTable();
+
+    PlanTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Plan = Plan]()
+    {
+        Plan->Run();
+    });
+}
+
+void FSnakeAIPlan::Run()
+{
+    Direction = INDEX_NONE;
+    if (!Grid.IsValid()) return;
+    const FSnakeGrid& Board = *Grid;
+
+    bool bFound = false;
+    if (bRankFoodByPath)
+    {
+        bFound = Pathfinder.FindPathToNearest(Board, Start, ESnakeCell::Food, Path);
+    }
+    else
     {
-        FVector Curr = Q.front(); Q.pop();
-        if (Curr == G) break;
+        // Off the game thread, a scan of the snapshot's food is fine
+        const int32 Goal = Board.FindClosest(Start, FoodCells);
+        if (Goal == INDEX_NONE) return;
 
-        for (const FVector& Dir : Directions)
+        // The walls-only shortest path from the table when no snake is on it, a search otherwise
+        bFound = NextHops.IsValid() && NextHops->FindFreePath(Board, Start, Goal, Path);
+        if (!bFound)
         {
-            FVector Next = Curr + Dir;
-            if (!Walkable.Contains(Next)
-             || CameFrom.Contains(Next)
-             || BodyTiles.Contains(Next))
-            {
-                continue;
-            }
-            CameFrom.Add(Next, Curr);
-            Q.push(Next);
+            bFound = bJumpPoint
+                ? Pathfinder.FindPathJumpPoint(Board, Start, Goal, Path)
+                : Pathfinder.FindPath(Board, Start, Goal, Path);
         }
     }
+    if (bFound && Path.Num() >= 2)
+        Direction = Board.GetDirectionTo(Path[0], Path[1]);
+}
 
-    // Reconstruct path after goal reached
-    if (!CameFrom.Contains(G))
-        return false;
+void ASnakeAIController::DrawPath(const ASnakeWorld& World, const TArray<int32>& Cells) const
+{
+    const FSnakeGrid& Grid = World.GetGrid();
+    for (int32 i = 0; i < Cells.Num(); ++i)
+    {
+        const FVector Point = World.GridCellToWorld(Grid.ToCell(Cells[i]), PrevTilePosition.Z);
+        DrawDebugSphere(GetWorld(), Point, TileSize * 0.2f, 8, FColor::Yellow, false, 0.1f);
+        if (i < Cells.Num() - 1)
+            DrawDebugLine(GetWorld(), Point, World.GridCellToWorld(Grid.ToCell(Cells[i+1]), PrevTilePosition.Z), FColor::Blue, false, 0.1f, 0, 5.f);
+    }
+}
+
+ASnakeWorld* ASnakeAIController::GetSnakeWorld()
+{
+    if (!SnakeWorld.IsValid())
+    {
+        SnakeWorld = Cast<ASnakeWorld>(
+            UGameplayStatics::GetActorOfClass(GetWorld(), ASnakeWorld::StaticClass())
+        );
+    }
+    return SnakeWorld.Get();
+}
 
-    // Build reversed path
-    TArray<FVector> ReversePath;
-    for (FVector At = G; At != S; At = CameFrom[At])
-        ReversePath.Add(At);
-    ReversePath.Add(S);
+bool ASnakeAIController::FindPath(ASnakeWorld& World, int32 Start)
+{
+    // Snake bodies (ours and everyone else's) are already marked on the grid
+    const FSnakeGrid& Grid = World.GetGrid();
+    if (PathMode == ESnakePathMode::Incremental)
+    {
+        // Stick with the apple we're repairing the path to for as long as it's there
+        int32 Goal = IncrementalPath.GetGoal();
+        if (Goal == INDEX_NONE || Goal >= Grid.Num() || !Grid.HasFlagAt(Goal, ESnakeCell::Food))
+            Goal = World.GetFoodIndex().FindNearest(Start);
+        return IncrementalPath.FindPath(Grid, World.GetGridJournal(), Start, Goal, PathCells);
+    }
+
+    if (PathMode == ESnakePathMode::Hierarchical)
+    {
+        const int32 Goal = World.GetFoodIndex().FindNearest(Start);
+        if (Goal == INDEX_NONE)
+            return false;
 
-    // Flip into OutPath
-    for (int32 i = ReversePath.Num() - 1; i >= 0; --i)
-        OutPath.Add(ReversePath[i]);
+        // Only the next step is used, refining a couple of clusters' worth is plenty to draw
+        FSnakeClusterGraph& Graph = World.GetClusterGraph();
+        if (Graph.FindPath(Grid, World.GetGridJournal(), Start, Goal, PathCells, FSnakeClusterGraph::ClusterSize * 2))
+            return true;
+        return Pathfinder.FindPathJumpPoint(Grid, Start, Goal, PathCells);
+    }
 
-    return true;
-}
+    if (PathMode == ESnakePathMode::SpaceTime)
+    {
+        const ASnakePawn* Snake = Cast<ASnakePawn>(GetPawn());
+        if (!Snake)
+            return false;
 
+        // Without food there's still the way that stays clear the longest
+        const int32 Goal = World.GetFoodIndex().FindNearest(Start);
+        const int32 Back = Snake->Direction != ESnakeDirection::None ? (int32(Snake->Direction) + 2) % FSnakeGrid::NumDirections : INDEX_NONE;
+        const bool bReached = SpaceTimeSearch.FindPath(Grid, World.GetReservations(), Start, Goal, int32(Snake->GetUniqueID()),
+                                                       Back, Snake->GetTailLength(), ReservationHorizon, PathCells);
+        World.ReservePath(*Snake, PathCells);
+        return bReached || PathCells.Num() >= 2;
+    }
+
+    if (bRankFoodByPath)
+        return Pathfinder.FindPathToNearest(Grid, Start, ESnakeCell::Food, PathCells);
+
+    const int32 Goal = World.GetFoodIndex().FindNearest(Start);
+    if (Goal == INDEX_NONE)
+        return false;
+    if (const FSnakeNextHopTable* NextHops = World.GetNextHopTable().Get())
+    {
+        if (NextHops->FindFreePath(Grid, Start, Goal, PathCells))
+            return true;
+    }
+    if (PathMode == ESnakePathMode::JumpPoint)
+        return Pathfinder.FindPathJumpPoint(Grid, Start, Goal, PathCells);
+    return Pathfinder.FindPath(Grid, Start, Goal, PathCells);
+}
@@ -4,8 +4,62 @@
 #include "CoreMinimal.h"
 #include "AIController.h"
 #include "Definitions.h"          // for TileSize & ESnakeDirection
+#include "SnakeGrid.h"
+#include "SnakePathfinder.h"
+#include "SnakeIncrementalPath.h"
+#include "SnakeBitboard.h"
+#include "SnakeNextHopTable.h"
+#include "SnakeMonteCarlo.h"
+#include "SnakeReservationTable.h"
+#include "Tasks/Task.h"
 #include "SnakeAIController.generated.h"
 
+class ASnakePawn;
+class ASnakeWorld;
+
+UENUM(BlueprintType)
+enum class ESnakePathMode : uint8
+{
+    // Own breadth first search to the closest apple on every tile
+    Search,
+    // Shared distance field kept by the world, one neighbour lookup per tile
+    FlowField,
+    // Like Search but with jump point search, same path lengths with far fewer cells expanded on open levels
+    JumpPoint,
+    // Keeps its search and repairs it as cells are blocked or freed, a new search only when the target apple changes.
+    // Always plans on the game thread, the search state belongs to the controller.
+    Incremental,
+    // Searches the world's cluster graph (HPA*) for big levels, close to shortest paths at a fraction of the cells.
+    // Game thread only, like Incremental; a full search only when snakes block every entrance on the way.
+    Hierarchical,
+    // Searches cells over time against the world's reservation table, so tails that will have moved on don't block
+    // and other heads are steered around. Publishes its path for the others. Game thread only, for matches with several snakes.
+    SpaceTime,
+    // Hard opponent: Monte Carlo tree search over a copy of the board, playing games forward on all workers for
+    // MonteCarloBudgetMs on every tile. Keeps the part of the tree for the move it made.
+    MonteCarlo
+};
+
+/** Everything a worker needs to decide the direction at one tile, planned while the snake is still on the tile before. */
+struct FSnakeAIPlan
+{
+    // Snapshot of the board when the plan was launched, shared with the other snakes planning on the same step
+    TSharedPtr<const FSnakeGrid> Grid;
+    TArray<int32> FoodCells;
+    int32 Start = INDEX_NONE;
+    bool bJumpPoint = false;
+    bool bRankFoodByPath = false;
+    TSharedPtr<const FSnakeNextHopTable> NextHops;
+
+    FSnakePathfinder Pathfinder;
+    TArray<int32> Path;
+
+    // Result, a grid direction or INDEX_NONE
+    int32 Direction = INDEX_NONE;
+
+    void Run();
+};
+
 UCLASS()
 class SNAKEGAME_API ASnakeAIController : public AAIController
 {
@@ -13,11 +67,88 @@ class SNAKEGAME_API ASnakeAIController : public AAIController
 
 public:
     ASnakeAIController();
-    virtual void Tick(float DeltaTime) override;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+    ESnakePathMode PathMode = ESnakePathMode::FlowField;
+
+    // Search and JumpPoint modes plan the next tile on a worker while the snake crosses the current one.
+    // A plan that isn't done when the snake gets there is dropped and the snake keeps its direction.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+    bool bPlanAhead = true;
+
+    // Search and JumpPoint modes hand the search to USnakeAIPlanner, which plans all such snakes in one parallel batch.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+    bool bUseCentralPlanner = false;
+
+    // Go for the apple with the shortest walk rather than the closest one on the grid. One search
+    // that stops at the first apple it reaches, it doesn't matter how many there are. Not used by Incremental or Hierarchical.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+    bool bRankFoodByPath = false;
+
+    // Before every turn, make sure the move leaves room for the whole body or a way to our own tail.
+    // If it doesn't, take the move that does, or the one with the most room.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+    bool bSurvivalCheck = true;
+
+    // How many tiles ahead the SpaceTime mode looks. Further apples are approached as far as this goes.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI", meta=(ClampMin="1", ClampMax="64"))
+    int32 ReservationHorizon = 16;
+
+    // Time the MonteCarlo mode searches for each tile, the game thread waits for it.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI", meta=(ClampMin="0.5", ClampMax="50"))
+    float MonteCarloBudgetMs = 4.0f;
+
+    // Steps each MonteCarlo game is played beyond the tree.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI", meta=(ClampMin="1"))
+    int32 MonteCarloRolloutDepth = 30;
+
+    // USnakeAIPlanner's answer, None when it found nothing; the survival check runs either way.
+    void ApplyPlannedDirection(ESnakeDirection Dir);
+
+protected:
+    virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 private:
-    bool FindPath(const FVector& Start, const FVector& Goal, TArray<FVector>& OutPath) const;
+    // Picks the direction for the next tile, see USnakeSimSubsystem::OnPreStep
+    void OnSimStep(uint32 Step);
+    FDelegateHandle SimStepHandle;
+
+    void RequestCentralPlan(const ASnakePawn& Snake, const ASnakeWorld& World);
+    void ApplyDirection(ASnakePawn& Snake, ESnakeDirection Dir) const;
+    ESnakeDirection TakePlannedDirection(ASnakeWorld& World);
+    void LaunchPlan(const ASnakePawn& Snake, ASnakeWorld& World);
+    void DrawPath(const ASnakeWorld& World, const TArray<int32>& Cells) const;
+
+    ESnakeDirection ChooseFlowFieldDirection(const ASnakePawn& Snake, ASnakeWorld& World) const;
+    ESnakeDirection ChooseSearchDirection(ASnakeWorld& World);
+    ESnakeDirection ChooseMonteCarloDirection(const ASnakePawn& Snake, const ASnakeWorld& World);
+    ESnakeDirection CheckSurvival(const ASnakePawn& Snake, ASnakeWorld& World, ESnakeDirection Dir);
+
+    // Fills PathCells with grid indices from Start to the food this controller goes for
+    bool FindPath(ASnakeWorld& World, int32 Start);
+    ASnakeWorld* GetSnakeWorld();
     static FVector SnapToGrid(const FVector& WorldPos);
     
     FVector PrevTilePosition = FVector(FLT_MAX);
+
+    // Search buffers are kept between tiles so pathfinding doesn't allocate
+    FSnakePathfinder Pathfinder;
+    FSnakeIncrementalPath IncrementalPath;
+    FSnakeSpaceTimeSearch SpaceTimeSearch;
+
+    // Board copy and search trees of the MonteCarlo mode, and the tile the last search was for
+    FSnakeSimState SimState;
+    FSnakeMonteCarlo MonteCarlo;
+    int32 MonteCarloHead = INDEX_NONE;
+    TArray<int32> PathCells;
+
+    // Free cells for the survival check, kept in sync through the world's grid journal
+    FSnakeBitboard Bitboard;
+
+    // Reused once its task is done, a late task keeps its plan alive on its own
+    TSharedPtr<FSnakeAIPlan> Plan;
+    UE::Tasks::FTask PlanTask;
+
+    TWeakObjectPtr<ASnakeWorld> SnakeWorld;
 };
@@ -0,0 +1,125 @@
+#include "SnakeAIPlanner.h"
+
+#include "Async/ParallelFor.h"
+#include "Kismet/GameplayStatics.h"
+#include "SnakeAIController.h"
+#include "SnakeWorld.h"
+
+void USnakeAIPlanner::RequestPlan(ASnakeAIController& Controller, int32 Start, int32 ExcludedDirection, bool bJumpPoint, bool bRankFoodByPath)
+{
+    FRequest& Request = Requests.AddDefaulted_GetRef();
+    Request.Controller = &Controller;
+    Request.Start = Start;
+    Request.ExcludedDirection = ExcludedDirection;
+    Request.bJumpPoint = bJumpPoint;
+    Request.bRankFoodByPath = bRankFoodByPath;
+}
+
+TStatId USnakeAIPlanner::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(USnakeAIPlanner, STATGROUP_Tickables);
+}
+
+ASnakeWorld* USnakeAIPlanner::GetSnakeWorld()
+{
+    if (!SnakeWorld.IsValid())
+    {
+        SnakeWorld = Cast<ASnakeWorld>(UGameplayStatics::GetActorOfClass(GetWorld(), ASnakeWorld::StaticClass()));
+    }
+    return SnakeWorld.Get();
+}
+
+void USnakeAIPlanner::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    if (Requests.Num() > 0)
+    {
+        PlanRequests();
+    }
+}
+
+void USnakeAIPlanner::PlanRequests()
+{
+    LastBatchSize = Requests.Num();
+    ASnakeWorld* World = GetSnakeWorld();
+    if (Requests.Num() == 0)
+    {
+        return;
+    }
+    if (World)
+    {
+        PlanBatches(*World);
+    }
+
+    // Every requester hears back, None when nothing was found or the path starts back the way it came:
+    // the controller's survival check still picks a safe way on
+    for (const FRequest& Request : Requests)
+    {
+        if (ASnakeAIController* Controller = Request.Controller.Get())
+        {
+            Controller->ApplyPlannedDirection(Request.Direction != INDEX_NONE ? ESnakeDirection(Request.Direction) : ESnakeDirection::None);
+        }
+    }
+    Requests.Reset();
+}
+
+void USnakeAIPlanner::PlanBatches(ASnakeWorld& World)
+{
+    const FSnakeGrid& Grid = World.GetGrid();
+    const FSnakeFoodIndex& FoodIndex = World.GetFoodIndex();
+    const TSharedPtr<const FSnakeNextHopTable> NextHops = World.GetNextHopTable();
+
+    // One batch per worker, pathfinders are kept between frames so the searches don't allocate.
+    const int32 NumBatches = FMath::Min(Requests.Num(), FTaskGraphInterface::Get().GetNumWorkerThreads() + 1);
+    if (Contexts.Num() < NumBatches)
+    {
+        Contexts.SetNum(NumBatches);
+    }
+
+    ParallelFor(NumBatches, [this, &Grid, &FoodIndex, &NextHops, NumBatches](int32 Batch)
+    {
+        FBatchContext& Context = Contexts[Batch];
+        const int32 First = Requests.Num() * Batch / NumBatches;
+        const int32 Last = Requests.Num() * (Batch + 1) / NumBatches;
+
+        for (int32 i = First; i < Last; i++)
+        {
+            FRequest& Request = Requests[i];
+            if (Request.Start == INDEX_NONE)
+            {
+                continue;
+            }
+
+            bool bFound = false;
+            if (Request.bRankFoodByPath)
+            {
+                bFound = Context.Pathfinder.FindPathToNearest(Grid, Request.Start, ESnakeCell::Food, Context.Path);
+            }
+            else
+            {
+                const int32 Goal = FoodIndex.FindNearest(Request.Start);
+                if (Goal == INDEX_NONE)
+                {
+                    continue;
+                }
+                // Table lookups while no snake is in the way, a search when one is
+                bFound = NextHops.IsValid() && NextHops->FindFreePath(Grid, Request.Start, Goal, Context.Path);
+                if (!bFound)
+                {
+                    bFound = Request.bJumpPoint
+                        ? Context.Pathfinder.FindPathJumpPoint(Grid, Request.Start, Goal, Context.Path)
+                        : Context.Pathfinder.FindPath(Grid, Request.Start, Goal, Context.Path);
+                }
+            }
+            if (bFound && Context.Path.Num() >= 2)
+            {
+                const int32 Direction = Grid.GetDirectionTo(Context.Path[0], Context.Path[1]);
+                if (Direction != Request.ExcludedDirection)
+                {
+                    Request.Direction = Direction;
+                }
+            }
+        }
+    });
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SnakePathfinder.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SnakeAIPlanner.generated.h"
+
+class ASnakeAIController;
+class ASnakeWorld;
+
+/**
+ * Plans every AI snake that entered a new tile in one batch. Controllers with bUseCentralPlanner
+ * queue a request when the simulation steps; before the snakes move (or at the end of the frame) the
+ * requests are split across the worker threads with ParallelFor, each batch with its own pathfinder,
+ * and the chosen directions are applied back on the game thread.
+ *
+ * The grid isn't copied: nothing moves while the game thread waits on the ParallelFor.
+ */
+UCLASS()
+class SNAKEGAME_API USnakeAIPlanner : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	void RequestPlan(ASnakeAIController& Controller, int32 Start, int32 ExcludedDirection, bool bJumpPoint, bool bRankFoodByPath);
+
+	/** Runs the queued requests now and answers every one through ASnakeAIController::ApplyPlannedDirection, see USnakeSimSubsystem::Step. */
+	void PlanRequests();
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	int32 GetLastBatchSize() const { return LastBatchSize; }
+
+private:
+	struct FRequest
+	{
+		TWeakObjectPtr<ASnakeAIController> Controller;
+		int32 Start = INDEX_NONE;
+		int32 ExcludedDirection = INDEX_NONE;
+		bool bJumpPoint = false;
+		bool bRankFoodByPath = false;
+		int32 Direction = INDEX_NONE;
+	};
+
+	struct FBatchContext
+	{
+		FSnakePathfinder Pathfinder;
+		TArray<int32> Path;
+	};
+
+	// Fills in each request's Direction, searching on the workers.
+	void PlanBatches(ASnakeWorld& World);
+
+	ASnakeWorld* GetSnakeWorld();
+
+	TArray<FRequest> Requests;
+	TArray<FBatchContext> Contexts;
+	TWeakObjectPtr<ASnakeWorld> SnakeWorld;
+	int32 LastBatchSize = 0;
+};
@@ -0,0 +1,483 @@
+#include "SnakeBenchmarkCommandlet.h"
+
+#include "Definitions.h"
+#include "SnakeFoodIndex.h"
+#include "SnakeFreeCellIndex.h"
+#include "SnakeGrid.h"
+#include "SnakeLevelPack.h"
+#include "SnakePathfinder.h"
+#include "SnakeWorld.h"
+#include "HAL/FileManager.h"
+#include "HAL/MemoryBase.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeExit.h"
+#include "Serialization/JsonWriter.h"
+
+namespace SnakeBenchmark
+{
+    // Counts what the benchmark thread allocates while enabled, everything is passed on to the allocator it wraps.
+    class FAllocCounter : public FMalloc
+    {
+    public:
+        explicit FAllocCounter(FMalloc* InInner)
+            : Inner(InInner)
+            , ThreadId(FPlatformTLS::GetCurrentThreadId())
+        {
+        }
+
+        virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+        {
+            Record(Count);
+            return Inner->Malloc(Count, Alignment);
+        }
+
+        virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+        {
+            Record(Count);
+            return Inner->TryMalloc(Count, Alignment);
+        }
+
+        virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+        {
+            Record(Count);
+            return Inner->Realloc(Original, Count, Alignment);
+        }
+
+        virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+        {
+            Record(Count);
+            return Inner->TryRealloc(Original, Count, Alignment);
+        }
+
+        virtual void Free(void* Original) override { Inner->Free(Original); }
+        virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+        virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+        virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+        virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+        virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+        virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+        virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+        virtual const TCHAR* GetDescriptiveName() override { return Inner->GetDescriptiveName(); }
+
+        FMalloc* GetInner() const { return Inner; }
+
+        bool bEnabled = false;
+        uint64 NumAllocs = 0;
+        uint64 NumBytes = 0;
+
+    private:
+        void Record(SIZE_T Count)
+        {
+            // Realloc to zero is a free
+            if (bEnabled && Count > 0 && FPlatformTLS::GetCurrentThreadId() == ThreadId)
+            {
+                NumAllocs++;
+                NumBytes += Count;
+            }
+        }
+
+        FMalloc* Inner;
+        uint32 ThreadId;
+    };
+
+    struct FResult
+    {
+        FString Name;
+        FString Level;
+        int32 SizeX = 0;
+        int32 SizeY = 0;
+        int32 SnakeLength = 0;
+        TArray<double> Nanoseconds;
+        uint64 NumAllocs = 0;
+        uint64 NumBytes = 0;
+    };
+
+    struct FRunner
+    {
+        FAllocCounter* Counter = nullptr;
+        double MinTime = 0.2;
+        int32 MinIterations = 3;
+        int32 MaxIterations = 1000;
+        TArray<FResult> Results;
+
+        // Setup runs before every op, neither timed nor counted
+        template <typename SetupType, typename OpType>
+        void Run(FResult&& Result, SetupType&& Setup, OpType&& Op)
+        {
+            // One call first: buffers that live between calls are grown by then, as they are in a running game
+            Setup();
+            Op();
+
+            Counter->NumAllocs = 0;
+            Counter->NumBytes = 0;
+            const double EndTime = FPlatformTime::Seconds() + MinTime;
+            while (Result.Nanoseconds.Num() < MinIterations
+                || (Result.Nanoseconds.Num() < MaxIterations && FPlatformTime::Seconds() < EndTime))
+            {
+                Setup();
+                Counter->bEnabled = true;
+                const uint64 StartCycles = FPlatformTime::Cycles64();
+                Op();
+                const uint64 Cycles = FPlatformTime::Cycles64() - StartCycles;
+                Counter->bEnabled = false;
+                Result.Nanoseconds.Add(FPlatformTime::ToSeconds64(Cycles) * 1.0e9);
+            }
+            Result.NumAllocs = Counter->NumAllocs;
+            Result.NumBytes = Counter->NumBytes;
+
+            Result.Nanoseconds.Sort();
+            UE_LOG(LogTemp, Display, TEXT("[Benchmark] %-18s %-16s length %5d: %12.0f ns/op p50, %6.1f allocs/op (%d ops)"),
+                   *Result.Name, *Result.Level, Result.SnakeLength, GetPercentile(Result, 0.5),
+                   double(Result.NumAllocs) / Result.Nanoseconds.Num(), Result.Nanoseconds.Num());
+            Results.Add(MoveTemp(Result));
+        }
+
+        static double GetPercentile(const FResult& Result, double Percentile)
+        {
+            const int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile * Result.Nanoseconds.Num()) - 1, 0, Result.Nanoseconds.Num() - 1);
+            return Result.Nanoseconds[Index];
+        }
+    };
+
+    // Walls round the edge and scattered over about Density of the inside, floor everywhere else
+    static void MakeLevelText(int32 Size, float Density, FRandomStream& Random, TArray<FString>& OutLines)
+    {
+        OutLines.SetNum(Size);
+        for (int32 Row = 0; Row < Size; Row++)
+        {
+            FString& Line = OutLines[Row];
+            Line.Reset(Size);
+            for (int32 Column = 0; Column < Size; Column++)
+            {
+                const bool bEdge = Row == 0 || Column == 0 || Row == Size - 1 || Column == Size - 1;
+                Line.AppendChar(bEdge || Random.FRand() < Density ? TEXT('#') : TEXT('.'));
+            }
+        }
+    }
+
+    // A body curled up as a random walk over free cells, head first. Starts over elsewhere when it walks into a dead end.
+    static void LaySnake(FSnakeGrid& Grid, int32 Length, FRandomStream& Random, TArray<int32>& OutBody)
+    {
+        TArray<int32> Free;
+        for (int32 Index = 0; Index < Grid.Num(); Index++)
+        {
+            if (Grid.IsFreeAt(Index))
+            {
+                Free.Add(Index);
+            }
+        }
+
+        OutBody.Reset();
+        int32 Cell = INDEX_NONE;
+        while (OutBody.Num() < Length && Free.Num() > OutBody.Num())
+        {
+            if (Cell == INDEX_NONE)
+            {
+                Cell = Free[Random.RandHelper(Free.Num())];
+                if (!Grid.IsFreeAt(Cell))
+                {
+                    Cell = INDEX_NONE;
+                    continue;
+                }
+            }
+            Grid.AddOccupant(Grid.ToCell(Cell));
+            OutBody.Add(Cell);
+
+            int32 Options[FSnakeGrid::NumDirections];
+            int32 NumOptions = 0;
+            for (int32 Direction = 0; Direction < FSnakeGrid::NumDirections; Direction++)
+            {
+                const int32 Next = Grid.GetNeighbour(Cell, Direction);
+                if (Next != INDEX_NONE && Grid.IsFreeAt(Next))
+                {
+                    Options[NumOptions++] = Next;
+                }
+            }
+            Cell = NumOptions > 0 ? Options[Random.RandHelper(NumOptions)] : INDEX_NONE;
+        }
+    }
+
+    static void RunLevelLoad(FRunner& Runner, const FString& LevelName, const FString& FilePath, const TArray<FString>& Lines, int32 ChunkSize)
+    {
+        // Text parse plus BuildLevel. Shipped levels are read from disk like LoadLevelFromText does without a pack, generated ones are parsed from memory
+        TSharedPtr<FSnakeLevelBuild> Build;
+        FResult Result;
+        Result.Name = TEXT("ParseTextAndBuild");
+        Result.Level = LevelName;
+        Runner.Run(MoveTemp(Result), [] {}, [&]
+        {
+            FSnakeLevelData Level;
+            const bool bParsed = FilePath.IsEmpty() ? Level.ParseText(Lines, TileSize) : Level.LoadFromTextFile(FilePath, TileSize);
+            Build = bParsed ? ASnakeWorld::BuildLevel(Level.GetView(), 0, ChunkSize) : nullptr;
+        });
+
+        FResult& Last = Runner.Results.Last();
+        Last.SizeX = Build.IsValid() ? Build->Grid.GetSizeX() : 0;
+        Last.SizeY = Build.IsValid() ? Build->Grid.GetSizeY() : 0;
+    }
+
+    static void RunPackLoad(FRunner& Runner, const FString& LevelName, const FSnakeLevelPack& Pack, int32 LevelIndex, int32 ChunkSize)
+    {
+        // FindLevel in the mapped pack plus BuildLevel, the pack is opened once beforehand as the game does
+        TSharedPtr<FSnakeLevelBuild> Build;
+        FResult Result;
+        Result.Name = TEXT("PackViewAndBuild");
+        Result.Level = LevelName;
+        Runner.Run(MoveTemp(Result), [] {}, [&]
+        {
+            FSnakeLevelView View;
+            Build = Pack.FindLevel(LevelIndex, View) ? ASnakeWorld::BuildLevel(View, 0, ChunkSize) : nullptr;
+        });
+
+        FResult& Last = Runner.Results.Last();
+        Last.SizeX = Build.IsValid() ? Build->Grid.GetSizeX() : 0;
+        Last.SizeY = Build.IsValid() ? Build->Grid.GetSizeY() : 0;
+    }
+
+    static void RunBoard(FRunner& Runner, const FString& LevelName, const FSnakeGrid& LevelGrid, TConstArrayView<int32> Lengths, FRandomStream& Random)
+    {
+        for (const int32 Length : Lengths)
+        {
+            if (Length < 1 || Length > LevelGrid.GetNumWalkable() / 2)
+                continue;
+
+            FSnakeGrid Grid = LevelGrid;
+            TArray<int32> Body;
+            LaySnake(Grid, Length, Random, Body);
+            if (Body.Num() == 0)
+                continue;
+
+            FSnakeFreeCellIndex FreeCells;
+            FreeCells.Init(Grid);
+            FSnakeFoodIndex FoodIndex;
+            FoodIndex.Init(Grid.GetSizeX(), Grid.GetSizeY());
+
+            auto MakeResult = [&](const TCHAR* Name)
+            {
+                FResult Result;
+                Result.Name = Name;
+                Result.Level = LevelName;
+                Result.SizeX = Grid.GetSizeX();
+                Result.SizeY = Grid.GetSizeY();
+                Result.SnakeLength = Body.Num();
+                return Result;
+            };
+
+            // From the head to a random free cell, like an AI snake heading for an apple
+            FSnakePathfinder Pathfinder;
+            TArray<int32> Path;
+            int32 Goal = INDEX_NONE;
+            auto PickGoal = [&] { Goal = FreeCells.Sample(Random); };
+            Runner.Run(MakeResult(TEXT("FindPath")), PickGoal, [&] { Pathfinder.FindPath(Grid, Body[0], Goal, Path); });
+            Runner.Run(MakeResult(TEXT("FindPathJumpPoint")), PickGoal, [&] { Pathfinder.FindPathJumpPoint(Grid, Body[0], Goal, Path); });
+
+            // The board side of ASnakeWorld::SpawnFood, the food actor itself needs a game world. Each apple is
+            // taken away again before the next one so the board stays the same.
+            int32 Food = INDEX_NONE;
+            auto RemoveFood = [&]
+            {
+                if (Food != INDEX_NONE)
+                {
+                    Grid.SetFood(Grid.ToCell(Food), false);
+                    FoodIndex.Remove(Food);
+                    FreeCells.Add(Food);
+                    Food = INDEX_NONE;
+                }
+            };
+            Runner.Run(MakeResult(TEXT("SpawnFood")), RemoveFood, [&]
+            {
+                Food = FreeCells.Sample(Random);
+                if (Food != INDEX_NONE)
+                {
+                    Grid.SetFood(Grid.ToCell(Food), true);
+                    FreeCells.Remove(Food);
+                    FoodIndex.Add(Food);
+                }
+            });
+            RemoveFood();
+        }
+    }
+
+    static FString ToJson(const FRunner& Runner, int32 Seed)
+    {
+        FString Json;
+        TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+        Writer->WriteObjectStart();
+        Writer->WriteValue(TEXT("seed"), Seed);
+        Writer->WriteValue(TEXT("min_time_s"), Runner.MinTime);
+        Writer->WriteValue(TEXT("max_iterations"), Runner.MaxIterations);
+        Writer->WriteArrayStart(TEXT("results"));
+        for (const FResult& Result : Runner.Results)
+        {
+            const int32 NumOps = Result.Nanoseconds.Num();
+            double Total = 0.0;
+            for (const double Nanoseconds : Result.Nanoseconds)
+            {
+                Total += Nanoseconds;
+            }
+
+            Writer->WriteObjectStart();
+            Writer->WriteValue(TEXT("name"), Result.Name);
+            Writer->WriteValue(TEXT("level"), Result.Level);
+            Writer->WriteValue(TEXT("size_x"), Result.SizeX);
+            Writer->WriteValue(TEXT("size_y"), Result.SizeY);
+            Writer->WriteValue(TEXT("snake_length"), Result.SnakeLength);
+            Writer->WriteValue(TEXT("ops"), NumOps);
+            Writer->WriteValue(TEXT("ns_per_op"), Total / NumOps);
+            Writer->WriteValue(TEXT("allocs_per_op"), double(Result.NumAllocs) / NumOps);
+            Writer->WriteValue(TEXT("bytes_per_op"), double(Result.NumBytes) / NumOps);
+            Writer->WriteValue(TEXT("min_ns"), Result.Nanoseconds[0]);
+            Writer->WriteValue(TEXT("p50_ns"), FRunner::GetPercentile(Result, 0.5));
+            Writer->WriteValue(TEXT("p90_ns"), FRunner::GetPercentile(Result, 0.9));
+            Writer->WriteValue(TEXT("p99_ns"), FRunner::GetPercentile(Result, 0.99));
+            Writer->WriteValue(TEXT("max_ns"), Result.Nanoseconds.Last());
+            Writer->WriteObjectEnd();
+        }
+        Writer->WriteArrayEnd();
+        Writer->WriteObjectEnd();
+        Writer->Close();
+        return Json;
+    }
+
+    static void ParseList(const FString& Text, TArray<int32>& OutValues)
+    {
+        TArray<FString> Items;
+        Text.ParseIntoArray(Items, TEXT(","));
+        OutValues.Reset();
+        for (const FString& Item : Items)
+        {
+            OutValues.Add(FCString::Atoi(*Item));
+        }
+    }
+}
+
+USnakeBenchmarkCommandlet::USnakeBenchmarkCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 USnakeBenchmarkCommandlet::Main(const FString& Params)
+{
+    using namespace SnakeBenchmark;
+
+    FString OutputPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks/SnakeBenchmark.json");
+    FString SourceDir = FPaths::ProjectContentDir() / TEXT("Levels");
+    FString SizesText = TEXT("16,32,64,128,256,512,1024,2048");
+    FString LengthsText = TEXT("1,64,1024");
+    int32 Seed = 1;
+    FRunner Runner;
+    FParse::Value(*Params, TEXT("Output="), OutputPath);
+    FParse::Value(*Params, TEXT("Source="), SourceDir);
+    FParse::Value(*Params, TEXT("Sizes="), SizesText);
+    FParse::Value(*Params, TEXT("Lengths="), LengthsText);
+    FParse::Value(*Params, TEXT("MinTime="), Runner.MinTime);
+    FParse::Value(*Params, TEXT("MaxIterations="), Runner.MaxIterations);
+    FParse::Value(*Params, TEXT("Seed="), Seed);
+    Runner.MaxIterations = FMath::Max(Runner.MaxIterations, Runner.MinIterations);
+
+    TArray<int32> Sizes;
+    TArray<int32> Lengths;
+    ParseList(SizesText, Sizes);
+    ParseList(LengthsText, Lengths);
+    const int32 ChunkSize = GetDefault<ASnakeWorld>()->ChunkSize;
+    FRandomStream Random(Seed);
+
+    // Only this thread's allocations are counted, the proxy stays installed until the end
+    static FAllocCounter* Counter = nullptr;
+    if (!Counter)
+    {
+        Counter = new FAllocCounter(GMalloc);
+    }
+    GMalloc = Counter;
+    Runner.Counter = Counter;
+    ON_SCOPE_EXIT
+    {
+        GMalloc = Counter->GetInner();
+    };
+
+    // Every level is loaded from a pack as well, numbered in the order they're run
+    TArray<FSnakeLevelData> PackLevels;
+    TArray<FString> PackLevelNames;
+
+    TArray<FString> Files;
+    IFileManager::Get().FindFiles(Files, *(SourceDir / TEXT("Level*.txt")), true, false);
+    Files.Sort();
+    for (const FString& File : Files)
+    {
+        const FString LevelName = FPaths::GetBaseFilename(File);
+        RunLevelLoad(Runner, LevelName, SourceDir / File, {}, ChunkSize);
+
+        FSnakeLevelData Level;
+        if (Level.LoadFromTextFile(SourceDir / File, TileSize))
+        {
+            FSnakeGrid Grid;
+            Grid.Init(Level.GetView());
+            RunBoard(Runner, LevelName, Grid, Lengths, Random);
+
+            Level.LevelIndex = PackLevels.Num();
+            PackLevels.Add(MoveTemp(Level));
+            PackLevelNames.Add(LevelName);
+        }
+    }
+
+    TArray<FString> Lines;
+    for (const int32 Size : Sizes)
+    {
+        if (Size < 4)
+            continue;
+
+        const FString LevelName = FString::Printf(TEXT("Generated%d"), Size);
+        MakeLevelText(Size, 0.08f, Random, Lines);
+        RunLevelLoad(Runner, LevelName, FString(), Lines, ChunkSize);
+
+        FSnakeLevelData Level;
+        if (Level.ParseText(Lines, TileSize))
+        {
+            FSnakeGrid Grid;
+            Grid.Init(Level.GetView());
+            RunBoard(Runner, LevelName, Grid, Lengths, Random);
+
+            Level.LevelIndex = PackLevels.Num();
+            PackLevels.Add(MoveTemp(Level));
+            PackLevelNames.Add(LevelName);
+        }
+    }
+
+    const FString PackPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks/SnakeBenchmark.snakepack");
+    if (PackLevels.Num() > 0 && FSnakeLevelPack::Write(PackPath, PackLevels, TileSize))
+    {
+        {
+            FSnakeLevelPack Pack;
+            if (Pack.Open(PackPath))
+            {
+                for (int32 Index = 0; Index < PackLevels.Num(); Index++)
+                {
+                    RunPackLoad(Runner, PackLevelNames[Index], Pack, Index, ChunkSize);
+                }
+            }
+        }
+        IFileManager::Get().Delete(*PackPath);
+    }
+    else if (PackLevels.Num() > 0)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("[Benchmark] Failed to write %s, skipping the pack loads"), *PackPath);
+    }
+
+    if (Runner.Results.Num() == 0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("[Benchmark] Nothing was run"));
+        return 1;
+    }
+
+    if (!FFileHelper::SaveStringToFile(ToJson(Runner, Seed), *OutputPath))
+    {
+        UE_LOG(LogTemp, Error, TEXT("[Benchmark] Failed to write %s"), *OutputPath);
+        return 1;
+    }
+    UE_LOG(LogTemp, Display, TEXT("[Benchmark] Wrote %d results to %s"), Runner.Results.Num(), *OutputPath);
+    return 0;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SnakeBenchmarkCommandlet.generated.h"
+
+/**
+ * Times the hot paths behind ASnakeWorld::LoadLevelFromText, ASnakeWorld::SpawnFood and
+ * ASnakeAIController::FindPath on the shipped levels and on generated square levels, with snake bodies
+ * of a few lengths on the board. Writes ns/op, allocations/op and percentiles as JSON.
+ *
+ * Run with: UnrealEditor-Cmd SnakeGame.uproject -run=SnakeBenchmark [-Output=<file>] [-Source=<dir>]
+ *           [-Sizes=16,32,...,2048] [-Lengths=1,64,1024] [-MinTime=0.2] [-MaxIterations=1000] [-Seed=1]
+ */
+UCLASS()
+class SNAKEGAME_API USnakeBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	USnakeBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
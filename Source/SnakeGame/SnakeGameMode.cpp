@@ -5,6 +5,7 @@
 #include "GameFramework/PlayerController.h"
 #include "SnakeWorld.h"
 #include "SnakeAIController.h"
+#include "SnakeSimState.h"
 #include "Engine/LocalPlayer.h"
 #include "GameFramework/PlayerStart.h"
 #include "EngineUtils.h"
@@ -104,6 +105,11 @@ void ASnakeGameMode::SetGameType(EGameType NewType)
                *UEnum::GetValueAsString(NewType));
     }
 
+    if (NewType != EGameType::Arena)
+    {
+        DestroyArenaSnakes();
+    }
+
     // Core spawn logic  
     CurrentGameType = NewType;
     UE_LOG(LogTemp, Log, TEXT("GameType set to %s"),
@@ -167,6 +173,10 @@ void ASnakeGameMode::SetGameType(EGameType NewType)
                         ASnakeAIController::StaticClass());
                     if (AICon)
                     {
+                        // Shares the board with a player, plan around where their head is going
+                        AICon->PathMode = bHardAI && NewType == EGameType::PvAI
+                            ? ESnakePathMode::MonteCarlo
+                            : ESnakePathMode::SpaceTime;
                         AICon->Possess(NewAI);
                         UE_LOG(LogTemp, Log,
                                TEXT("Spawned & possessed AI snake with %s"),
@@ -180,10 +190,104 @@ void ASnakeGameMode::SetGameType(EGameType NewType)
             UE_LOG(LogTemp, Warning, TEXT("AI snake already spawned; skipping."));
         }
     }
+
+    // Spawn the arena crowd
+    if (NewType == EGameType::Arena && ArenaSnakes.Num() == 0)
+    {
+        SpawnArenaSnakes();
+    }
     
     SetGameState(EGameState::Game);
 }
 
+void ASnakeGameMode::SpawnArenaSnakes()
+{
+    ASnakeWorld* World = Cast<ASnakeWorld>(
+        UGameplayStatics::GetActorOfClass(GetWorld(), ASnakeWorld::StaticClass())
+    );
+    if (!World) return;
+
+    // A crowd sized to the level, a full board would have nowhere to go. The simulation's board leaves room for the players.
+    const int32 MaxAISnakes = FSnakeSimState::MaxSnakes - 2;
+    const int32 NumSnakes = FMath::Min3(ArenaAISnakes, MaxAISnakes, FMath::FloorToInt(World->GetNumFreeCells() * ArenaFreeCellFraction));
+    for (int32 i = 0; i < NumSnakes; ++i)
+    {
+        if (!SpawnArenaSnake(*World))
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Arena is full after %d AI snakes"), i);
+            break;
+        }
+    }
+
+    for (int32 i = 1; i < ArenaFoodCount; ++i)
+    {
+        World->SpawnFood();
+    }
+    UE_LOG(LogTemp, Log, TEXT("Spawned %d arena AI snakes"), ArenaSnakes.Num());
+}
+
+ASnakePawn* ASnakeGameMode::SpawnArenaSnake(ASnakeWorld& World)
+{
+    UWorld* W = GetWorld();
+    auto& ChosenBP = AISnakePawnBP ? AISnakePawnBP : Player2PawnBP;
+    if (!ChosenBP) return nullptr;
+
+    // Every snake takes its cell in BeginPlay, so the next one lands elsewhere
+    FIntPoint Cell;
+    if (!World.FindSpawnCell(Cell)) return nullptr;
+
+    FActorSpawnParameters Params;
+    Params.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+    ASnakePawn* NewAI = W->SpawnActor<ASnakePawn>(ChosenBP, World.GridCellToWorld(Cell), FRotator::ZeroRotator, Params);
+    if (!NewAI) return nullptr;
+
+    ASnakeAIController* AICon = W->SpawnActor<ASnakeAIController>(ASnakeAIController::StaticClass());
+    if (AICon)
+    {
+        AICon->PathMode = ArenaPathMode;
+        AICon->bUseCentralPlanner = ArenaPathMode == ESnakePathMode::Search || ArenaPathMode == ESnakePathMode::JumpPoint;
+        AICon->Possess(NewAI);
+    }
+    ArenaSnakes.Add(NewAI);
+    return NewAI;
+}
+
+void ASnakeGameMode::NotifySnakeDied(ASnakePawn* Snake)
+{
+    if (CurrentGameType != EGameType::Arena || !ArenaSnakes.Contains(Snake))
+    {
+        SetGameState(EGameState::Outro);
+        return;
+    }
+
+    // Only this snake is out: its EndPlay gives its cells back, then a new one starts somewhere free
+    ArenaSnakes.Remove(Snake);
+    if (AController* AICon = Snake->GetController())
+    {
+        AICon->Destroy();
+    }
+    Snake->Destroy();
+
+    if (ASnakeWorld* World = Cast<ASnakeWorld>(UGameplayStatics::GetActorOfClass(GetWorld(), ASnakeWorld::StaticClass())))
+    {
+        SpawnArenaSnake(*World);
+    }
+}
+
+void ASnakeGameMode::DestroyArenaSnakes()
+{
+    for (ASnakePawn* Snake : ArenaSnakes)
+    {
+        if (!IsValid(Snake)) continue;
+        if (AController* AICon = Snake->GetController())
+        {
+            AICon->Destroy();
+        }
+        Snake->Destroy();
+    }
+    ArenaSnakes.Reset();
+}
+
 void ASnakeGameMode::PostLogin(APlayerController* NewPlayer)
 {
     Super::PostLogin(NewPlayer);
@@ -239,6 +343,9 @@ void ASnakeGameMode::PostLogin(APlayerController* NewPlayer)
 
 void ASnakeGameMode::NotifyAppleEaten(int32 ControllerId)
 {
+    // The arena crowd's apples keep the food coming but aren't the player's
+    const bool bArenaAI = CurrentGameType == EGameType::Arena && ControllerId != 0;
+
     // Update counters
     if (CurrentGameType == EGameType::PvP || CurrentGameType == EGameType::PvAI)
     {
@@ -253,15 +360,22 @@ void ASnakeGameMode::NotifyAppleEaten(int32 ControllerId)
             ++TotalApplesP2;
         }
     }
+    else if (bArenaAI)
+    {
+        ++ArenaAIApples;
+    }
     else
     {
         ++ApplesEaten;
     }
     
-    ++Score;
+    if (!bArenaAI)
+    {
+        ++Score;
+    }
 
     // Update UI
-    if (CurrentState == EGameState::Game && InGameWidget)
+    if (CurrentState == EGameState::Game && InGameWidget && !bArenaAI)
     {
         if (CurrentGameType == EGameType::PvP || CurrentGameType == EGameType::PvAI)
         {
@@ -277,6 +391,13 @@ void ASnakeGameMode::NotifyAppleEaten(int32 ControllerId)
         UGameplayStatics::GetActorOfClass(GetWorld(), ASnakeWorld::StaticClass())
     );
     if (!World) return;
+
+    // The arena doesn't advance levels, it keeps the food coming
+    if (CurrentGameType == EGameType::Arena)
+    {
+        World->SpawnFood();
+        return;
+    }
     
     int32 EatenThisLevel = (CurrentGameType == EGameType::PvP || CurrentGameType == EGameType::PvAI)
                            ? (LevelApplesP1 + LevelApplesP2)
@@ -297,8 +418,8 @@ void ASnakeGameMode::NotifyAppleEaten(int32 ControllerId)
             return;
         }
         
-        World->LevelIndex = Next;
-        World->LoadLevelFromText();
+        // Next level was prefetched when this one started, this is just a swap of instance sets.
+        World->SwapToLevel(Next);
         World->SpawnFood();
         
         LevelApplesP1 = 0;
@@ -2,6 +2,7 @@
 
 #include "CoreMinimal.h"
 #include "SnakePawn.h"
+#include "SnakeAIController.h"
 #include "Sound/SoundBase.h"
 #include "GameFramework/GameModeBase.h"
 #include "Internationalization/Text.h"
@@ -30,10 +31,14 @@ enum class EGameType : uint8
     PvPV2           UMETA(DisplayName="Player vs Player V2"),
     CoopV2          UMETA(DisplayName="Cooperative V2"),
     PvAIV2          UMETA(DisplayName="Player vs AI V2"),
-    CoopAIV2        UMETA(DisplayName="Cooperative + AI V2")
+    CoopAIV2        UMETA(DisplayName="Cooperative + AI V2"),
+
+    // Player against a crowd of AI snakes planned together by USnakeAIPlanner
+    Arena           UMETA(DisplayName="Arena")
 };
 
 class UMyUserWidget;
+class ASnakeWorld;
 
 UCLASS()
 class SNAKEGAME_API ASnakeGameMode : public AGameModeBase
@@ -93,6 +98,27 @@ public:
     UPROPERTY(EditDefaultsOnly, Category="Spawning")
     TSubclassOf<ASnakePawn> AISnakePawnBP;
 
+    // The PvAI opponent looks ahead with Monte Carlo tree search rather than heading for the nearest apple
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="AI")
+    bool bHardAI = false;
+
+    // Most AI snakes in the arena; fewer on small levels, see ArenaFreeCellFraction
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Arena", meta=(ClampMin="0"))
+    int32 ArenaAISnakes = 200;
+
+    // Share of the level's free cells the arena crowd starts on, leaving the rest to move and grow into
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Arena", meta=(ClampMin="0.0", ClampMax="1.0"))
+    float ArenaFreeCellFraction = 0.1f;
+
+    // How the arena crowd finds apples. FlowField has every snake read one distance field the world updates once
+    // per step, however many snakes there are; Search and JumpPoint plan each snake in USnakeAIPlanner's batch.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Arena")
+    ESnakePathMode ArenaPathMode = ESnakePathMode::FlowField;
+
+    // Apples kept on the board at once in the arena
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Arena", meta=(ClampMin="1"))
+    int32 ArenaFoodCount = 20;
+
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Level")
     int32 ApplesToFinish = 5;
 
@@ -102,6 +128,10 @@ public:
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Game")
     int32 Score = 0;
 
+    // Apples the arena's AI snakes ate, kept out of the player's Score and ApplesEaten
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Arena")
+    int32 ArenaAIApples = 0;
+
     UPROPERTY(EditAnywhere, Category="Audio")
     USoundBase* AmbientSound;
 
@@ -111,6 +141,9 @@ public:
     UFUNCTION()
     void NotifyAppleEaten(int32 ControllerId);
 
+    // A snake ran into something. Ends the game, except for arena AI snakes which are replaced by a new one.
+    void NotifySnakeDied(ASnakePawn* Snake);
+
     UFUNCTION(BlueprintCallable, Category="Game State")
     void SetGameState(EGameState NewState);
 
@@ -145,6 +178,13 @@ private:
 
     UPROPERTY()
     ASnakePawn* SpawnedAISnake = nullptr;
+
+    UPROPERTY()
+    TArray<ASnakePawn*> ArenaSnakes;
+
+    void SpawnArenaSnakes();
+    ASnakePawn* SpawnArenaSnake(ASnakeWorld& World);
+    void DestroyArenaSnakes();
     
     int32 LevelApplesP1 = 0;
     int32 LevelApplesP2 = 0;
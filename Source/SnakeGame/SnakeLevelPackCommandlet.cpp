@@ -0,0 +1,64 @@
+#include "SnakeLevelPackCommandlet.h"
+
+#include "Definitions.h"
+#include "SnakeLevelPack.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+USnakeLevelPackCommandlet::USnakeLevelPackCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 USnakeLevelPackCommandlet::Main(const FString& Params)
+{
+    FString SourceDir = FPaths::ProjectContentDir() / TEXT("Levels");
+    FString OutputPath = FSnakeLevelPack::GetDefaultPackPath();
+    FParse::Value(*Params, TEXT("Source="), SourceDir);
+    FParse::Value(*Params, TEXT("Output="), OutputPath);
+
+    TArray<FString> Files;
+    IFileManager::Get().FindFiles(Files, *(SourceDir / TEXT("Level*.txt")), true, false);
+
+    TArray<FSnakeLevelData> Levels;
+    for (const FString& File : Files)
+    {
+        FString Number = FPaths::GetBaseFilename(File);
+        Number.RemoveFromStart(TEXT("Level"));
+        if (!Number.IsNumeric())
+        {
+            UE_LOG(LogTemp, Warning, TEXT("[LevelPack] Skipping %s, expected LevelN.txt"), *File);
+            continue;
+        }
+
+        FSnakeLevelData& Level = Levels.AddDefaulted_GetRef();
+        Level.LevelIndex = FCString::Atoi(*Number);
+        if (!Level.LoadFromTextFile(SourceDir / File, TileSize))
+        {
+            UE_LOG(LogTemp, Error, TEXT("[LevelPack] Failed to parse %s"), *File);
+            return 1;
+        }
+
+        UE_LOG(LogTemp, Display, TEXT("[LevelPack] Level %d: %dx%d, %d walls, %d floors, %d doors"),
+               Level.LevelIndex, Level.Width, Level.Height,
+               Level.WallTranslations.Num(), Level.FloorTranslations.Num(), Level.DoorTranslations.Num());
+    }
+
+    if (Levels.Num() == 0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("[LevelPack] No levels found in %s"), *SourceDir);
+        return 1;
+    }
+
+    if (!FSnakeLevelPack::Write(OutputPath, Levels, TileSize))
+    {
+        UE_LOG(LogTemp, Error, TEXT("[LevelPack] Failed to write %s"), *OutputPath);
+        return 1;
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("[LevelPack] Wrote %d levels to %s"), Levels.Num(), *OutputPath);
+    return 0;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SnakeLevelPackCommandlet.generated.h"
+
+/**
+ * Compiles Content/Levels/Level*.txt into the memory mappable Levels.snakepack.
+ * Run with: UnrealEditor-Cmd SnakeGame.uproject -run=SnakeLevelPack [-Source=<dir>] [-Output=<file>]
+ */
+UCLASS()
+class SNAKEGAME_API USnakeLevelPackCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	USnakeLevelPackCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -1,10 +1,12 @@
 #include "SnakePawn.h"
 #include "SnakeTailSegment.h"
+#include "SnakeTailRendererComponent.h"
 #include "SnakeFood.h"
 #include "SnakeGameMode.h"
 #include "Components/StaticMeshComponent.h"
 #include "Materials/MaterialInterface.h"
 #include "SnakeWorld.h"
+#include "SnakeSimSubsystem.h"
 #include "Components/SphereComponent.h"
 #include "Components/WidgetComponent.h"
 #include "Sound/SoundBase.h"
@@ -14,6 +16,36 @@
 #include "Definitions.h"
 #include "SnakeAIController.h"
 
+namespace
+{
+	// Body cells are WorldToCell coordinates, the world takes locations and keeps its own indices up to date
+	struct FWorldCells
+	{
+		ASnakeWorld& World;
+
+		void AddOccupant(const FIntPoint& Cell) const { World.OccupyCell(CellToWorld(Cell)); }
+		void RemoveOccupant(const FIntPoint& Cell) const { World.ReleaseCell(CellToWorld(Cell)); }
+	};
+
+	// Without a world there's no grid to report the body to
+	struct FNoCells
+	{
+		void AddOccupant(const FIntPoint& Cell) const {}
+		void RemoveOccupant(const FIntPoint& Cell) const {}
+	};
+
+	// The body follows the board's step: a snake that grew keeps its tail end, the head takes the new tile
+	template <typename BoardType>
+	void FollowStep(BoardType& Board, FIntPoint& HeadCell, TSnakeBodyRing<FIntPoint>& TailCells, const FIntPoint& NewHeadCell, bool bGrew)
+	{
+		if (bGrew)
+		{
+			GrowSnake(Board, HeadCell, TailCells);
+		}
+		MoveSnake(Board, HeadCell, TailCells, NewHeadCell);
+	}
+}
+
 ASnakePawn::ASnakePawn()
 {
 	PrimaryActorTick.bCanEverTick = true;
@@ -46,6 +78,9 @@ ASnakePawn::ASnakePawn()
 	QuestionMarkWidget->SetWidgetSpace(EWidgetSpace::Screen);
 	QuestionMarkWidget->SetDrawAtDesiredSize(true);
 	QuestionMarkWidget->SetVisibility(false);
+
+	TailRenderer = CreateDefaultSubobject<USnakeTailRendererComponent>(TEXT("TailRenderer"));
+	TailRenderer->SetupAttachment(RootComponent);
 }
 
 void ASnakePawn::BeginPlay()
@@ -54,20 +89,62 @@ void ASnakePawn::BeginPlay()
 	
 	if (CollisionComponent)
 	{
-		CollisionComponent->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
-		CollisionComponent->SetCollisionObjectType(ECollisionChannel::ECC_Pawn);
-		CollisionComponent->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Overlap);
-		CollisionComponent->SetGenerateOverlapEvents(true);
+		// The simulation decides what the head runs into, see USnakeSimSubsystem
+		CollisionComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		CollisionComponent->SetGenerateOverlapEvents(false);
 	}
 	
 	FVector SnappedLocation = SnapToGrid(GetActorLocation());
 	SetActorLocation(SnappedLocation);
 	LastTilePosition = SnappedLocation;
-	
-	if (CollisionComponent)
+	HeadCell = WorldToCell(SnappedLocation);
+	PreviousHeadCell = HeadCell;
+	Trail.Reset(SnappedLocation);
+
+	// Every snake moves at Speed, the simulation steps one tile at that rate
+	if (USnakeSimSubsystem* Sim = GetWorld()->GetSubsystem<USnakeSimSubsystem>())
+	{
+		Sim->SetStepsPerSecond(Speed / TileSize);
+		Sim->RegisterSnake(*this);
+	}
+
+	SnakeWorld = Cast<ASnakeWorld>(UGameplayStatics::GetActorOfClass(GetWorld(), ASnakeWorld::StaticClass()));
+	if (SnakeWorld.IsValid())
+	{
+		SnakeWorld->OccupyCell(LastTilePosition);
+	}
+
+	// Segments wear the head's material, like the segment actors did
+	UMaterialInterface* HeadMaterial = nullptr;
+	TInlineComponentArray<UStaticMeshComponent*> Meshes(this);
+	for (UStaticMeshComponent* Mesh : Meshes)
 	{
-		CollisionComponent->OnComponentBeginOverlap.AddDynamic(this, &ASnakePawn::OnOverlapBegin);
+		if (Mesh != TailRenderer)
+		{
+			HeadMaterial = Mesh->GetMaterial(0);
+			break;
+		}
 	}
+	TailRenderer->CopyLookFrom(TailSegmentClass, HeadMaterial);
+}
+
+void ASnakePawn::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (USnakeSimSubsystem* Sim = GetWorld()->GetSubsystem<USnakeSimSubsystem>())
+	{
+		Sim->UnregisterSnake(*this);
+	}
+
+	if (SnakeWorld.IsValid())
+	{
+		SnakeWorld->ReleaseCell(LastTilePosition);
+		for (const FIntPoint& Tile : TailCells)
+		{
+			SnakeWorld->ReleaseCell(CellToWorld(Tile));
+		}
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 FVector ASnakePawn::SnapToGrid(const FVector& InLocation)
@@ -82,108 +159,136 @@ void ASnakePawn::Tick(float DeltaTime)
 	UpdateFalling(DeltaTime);
 	UpdateMovement(DeltaTime);
 
-	// Record the head's current 
-	const float RecordDistance = 10.0f;
-	FVector CurrentHeadPos = GetActorLocation();
-	if (HeadPositionHistory.Num() == 0 ||
-	    FVector::Dist(HeadPositionHistory.Last(), CurrentHeadPos) >= RecordDistance)
+	// Corners are added as the head passes them, this is the head's progress along the current line
+	Trail.Add(GetActorLocation());
+	const float Spacing = TailHistorySpacing * TrailSpacingUnit;
+	Trail.Trim((TailRenderer->GetNumSegments() + 1) * Spacing + TileSize);
+	Trail.Sample(Spacing, TailRenderer->GetNumSegments(), TrailSamples);
+
+	// Update tail to follow the head's trail
+	const float SmoothSpeed = 10.0f;
+	TailRenderer->FollowTargets(TrailSamples, DeltaTime, SmoothSpeed);
+}
+
+void ASnakePawn::ShowStep(const FSnakeStepResult& Result)
+{
+	PreviousHeadCell = HeadCell;
+	if (Result.bDied)
 	{
-		HeadPositionHistory.Add(CurrentHeadPos);
+		UE_LOG(LogTemp, Warning, TEXT("Collision detected! Game Over!"));
+		GameOver();
+		return;
 	}
-	
-	int32 MaxHistoryLength = (TailSegments.Num() + 1) * TailHistorySpacing + 10;
-	if (HeadPositionHistory.Num() > MaxHistoryLength)
+
+	if (Result.Direction != Direction && Result.Direction != ESnakeDirection::None)
+	{
+		// A quarter turn per direction, Up faces along +X
+		Direction = Result.Direction;
+		ForwardRotation = FRotator(0.0f, 90.0f * int32(Direction), 0.0f);
+	}
+	if (!Result.bMoved)
 	{
-		HeadPositionHistory.RemoveAt(0, HeadPositionHistory.Num() - MaxHistoryLength);
+		return;
 	}
 
-	// Update tail to follow the head history
-	const float SmoothSpeed = 10.0f;
-	for (int32 i = 0; i < TailSegments.Num(); i++)
+	// The head is drawn from the tile it left, that's where the trail turns
+	const FVector PreviousTile = LastTilePosition;
+	LastTilePosition = CellToWorld(Result.HeadCell, PreviousTile.Z);
+	Trail.Add(FVector(PreviousTile.X, PreviousTile.Y, GetActorLocation().Z));
+
+	if (SnakeWorld.IsValid())
 	{
-		int32 HistoryIndex = HeadPositionHistory.Num() - 1 - (i + 1) * TailHistorySpacing;
-		HistoryIndex = FMath::Clamp(HistoryIndex, 0, HeadPositionHistory.Num() - 1);
+		FWorldCells Cells{ *SnakeWorld };
+		FollowStep(Cells, HeadCell, TailCells, Result.HeadCell, Result.bGrew);
+	}
+	else
+	{
+		FNoCells Cells;
+		FollowStep(Cells, HeadCell, TailCells, Result.HeadCell, Result.bGrew);
+	}
 
-		FVector TargetPos = HeadPositionHistory[HistoryIndex];
-		FVector CurrentPos = TailSegments[i]->GetActorLocation();
-		FVector NewPos = FMath::VInterpTo(CurrentPos, TargetPos, DeltaTime, SmoothSpeed);
-		TailSegments[i]->SetActorLocation(NewPos);
+	if (Result.bGrew)
+	{
+		TailRenderer->AddSegment(CellToWorld(TailCells.Last(), LastTilePosition.Z));
+		UE_LOG(LogTemp, Warning, TEXT("Tail grown. Total segments: %d"), TailRenderer->GetNumSegments());
+	}
+
+	if (Result.bAte && SnakeWorld.IsValid())
+	{
+		if (AActor* Food = SnakeWorld->FindFoodAt(LastTilePosition))
+		{
+			EatFood(Food);
+		}
 	}
 }
 
-void ASnakePawn::OnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
-								UPrimitiveComponent* OtherComp, int32 OtherBodyIndex,
-								bool bFromSweep, const FHitResult& SweepResult)
+ESnakeDirection ASnakePawn::TakeNextDirection()
 {
-	if (!OtherActor)
+	if (DirectionQueue.IsEmpty())
 	{
-		return;
+		return ESnakeDirection::None;
 	}
 
-	// Collision with food
-	if (OtherActor->IsA(ASnakeFood::StaticClass()))
+	const ESnakeDirection Next = DirectionQueue[0];
+	DirectionQueue.RemoveAt(0);
+	return Next;
+}
+
+void ASnakePawn::EatFood(AActor* Food)
+{
+	if (EatParticle)
+	{
+		FVector SpawnLoc = Food->GetActorLocation();
+		UGameplayStatics::SpawnEmitterAtLocation(
+			GetWorld(), EatParticle, SpawnLoc
+		);
+	}
+
+	if (EatSound)
+	{
+		FVector SpawnLoc = Food->GetActorLocation();
+		UGameplayStatics::PlaySoundAtLocation(GetWorld(), EatSound, SpawnLoc);
+	}
+	
+	Food->Destroy();
+
+	// Notify GameMode
+	ASnakeGameMode* GM = Cast<ASnakeGameMode>(UGameplayStatics::GetGameMode(GetWorld()));
+	if (GM)
 	{
-		GrowTail();
+		int32 ControllerId = 0;
+		AController* Con = GetController();
 
-		if (EatParticle)
+		if (APlayerController* PC = Cast<APlayerController>(Con))
 		{
-			FVector SpawnLoc = OtherActor->GetActorLocation();
-			UGameplayStatics::SpawnEmitterAtLocation(
-				GetWorld(), EatParticle, SpawnLoc
-			);
+			ControllerId = PC->GetLocalPlayer()->GetControllerId();
 		}
-
-		if (EatSound)
+		else if (Cast<ASnakeAIController>(Con))
 		{
-			FVector SpawnLoc = OtherActor->GetActorLocation();
-			UGameplayStatics::PlaySoundAtLocation(GetWorld(), EatSound, SpawnLoc);
+			// AI always counts as player 2
+			ControllerId = 1;
 		}
-		
-		OtherActor->Destroy();
 
-		// Notify GameMode
-		ASnakeGameMode* GM = Cast<ASnakeGameMode>(UGameplayStatics::GetGameMode(GetWorld()));
-		if (GM)
+		// The apple may finish the level, which rebuilds the board from every snake's cells
+		RunAfterStep([WeakGM = TWeakObjectPtr<ASnakeGameMode>(GM), ControllerId]()
 		{
-			int32 ControllerId = 0;
-			AController* Con = GetController();
-
-			if (APlayerController* PC = Cast<APlayerController>(Con))
-			{
-				ControllerId = PC->GetLocalPlayer()->GetControllerId();
-			}
-			else if (Cast<ASnakeAIController>(Con))
+			if (WeakGM.IsValid())
 			{
-				// AI always counts as player 2
-				ControllerId = 1;
+				WeakGM->NotifyAppleEaten(ControllerId);
 			}
-
-			GM->NotifyAppleEaten(ControllerId);
-		}
+		});
 	}
+}
 
-	// Collision with Tail
-	if (OtherActor->IsA(ASnakeTailSegment::StaticClass()))
+void ASnakePawn::RunAfterStep(TFunction<void()> Event)
+{
+	if (USnakeSimSubsystem* Sim = GetWorld()->GetSubsystem<USnakeSimSubsystem>())
 	{
-		ASnakeTailSegment* TailSeg = Cast<ASnakeTailSegment>(OtherActor);
-		if (TailSeg && TailSeg->bCanCollide)
-		{
-			UE_LOG(LogTemp, Warning, TEXT("Collision with tail detected! Game Over!"));
-			GameOver();
-			return;
-		}
-		else
-		{
-			return;
-		}
+		Sim->RunAfterStep(MoveTemp(Event));
 	}
-
-	// Collision with Walls
-	if (OtherActor->ActorHasTag("Wall") || (OtherComp && OtherComp->ComponentHasTag("Wall")))
+	else
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Collision with wall detected! Game Over!"));
-		GameOver();
-		return;
+		Event();
 	}
 }
 
@@ -196,7 +301,14 @@ void ASnakePawn::GameOver()
 	ASnakeGameMode* GameMode = Cast<ASnakeGameMode>(UGameplayStatics::GetGameMode(GetWorld()));
 	if (GameMode)
 	{
-		GameMode->SetGameState(EGameState::Outro);
+		// The other snakes finish their step before the game ends or this one is taken off the board
+		RunAfterStep([WeakGameMode = TWeakObjectPtr<ASnakeGameMode>(GameMode), WeakThis = TWeakObjectPtr<ASnakePawn>(this)]()
+		{
+			if (WeakGameMode.IsValid() && WeakThis.IsValid())
+			{
+				WeakGameMode->NotifySnakeDied(WeakThis.Get());
+			}
+		});
 	}
 
 	/* // Restart the current level.
@@ -272,55 +384,15 @@ void ASnakePawn::HandlePauseToggle()
 	}
 }
 
-void ASnakePawn::MoveSnake(float Distance)
-{
-	FVector Position = GetActorLocation();
-	
-	switch (Direction)
-	{
-	case ESnakeDirection::Up:
-		Position.X += Distance;
-		break;
-	case ESnakeDirection::Right:
-		Position.Y += Distance;
-		break;
-	case ESnakeDirection::Down:
-		Position.X -= Distance;
-		break;
-	case ESnakeDirection::Left:
-		Position.Y -= Distance;
-		break;
-	}
-
-	SetActorLocation(Position);
-	MovedTileDistance += Distance;
-}
-
 void ASnakePawn::UpdateMovement(float DeltaTime)
 {
-	float DistanceToTravel = Speed * DeltaTime;
-	FVector CurrentPosition = GetActorLocation();
+	// Drawn between the last two tiles of the simulation, the height is left to UpdateFalling
+	const USnakeSimSubsystem* Sim = GetWorld()->GetSubsystem<USnakeSimSubsystem>();
+	const float Alpha = Sim ? Sim->GetInterpolationAlpha() : 1.0f;
+	FVector Position = FMath::Lerp(CellToWorld(PreviousHeadCell), CellToWorld(HeadCell), Alpha);
+	Position.Z = GetActorLocation().Z;
 
-	while (DistanceToTravel > 0.f)
-	{
-		float Step = FMath::Min(DistanceToTravel, TileSize - MovedTileDistance);
-		CurrentPosition += GetDirectionVector() * Step;
-		MovedTileDistance += Step;
-		DistanceToTravel -= Step;
-
-		if (MovedTileDistance >= TileSize - KINDA_SMALL_NUMBER)
-		{
-			// Snap exactly to grid, reset counters, update history
-			FVector Snapped = SnapToGrid(CurrentPosition);
-			LastTilePosition = Snapped;
-			CurrentPosition = Snapped;
-			MovedTileDistance = 0.f;
-
-			UpdateTailTargets(LastTilePosition);
-			UpdateDirection();
-		}
-	}
-	SetActorLocation(CurrentPosition);
+	SetActorLocation(Position);
 }
 
 void ASnakePawn::UpdateFalling(float DeltaTime)
@@ -358,50 +430,6 @@ void ASnakePawn::Jump()
 }
 
 
-void ASnakePawn::UpdateDirection()
-{
-	if (DirectionQueue.IsEmpty())
-	{
-		return;
-	}
-
-	Direction = DirectionQueue[0];
-	DirectionQueue.RemoveAt(0);
-	switch (Direction)
-	{
-	case ESnakeDirection::Up:
-		ForwardRotation = FRotator(0.0f, 0.0f, 0.0f);
-		break;
-	case ESnakeDirection::Right:
-		ForwardRotation = FRotator(0.0f, 90.0f, 0.0f);
-		break;
-	case ESnakeDirection::Down:
-		ForwardRotation = FRotator(0.0f, 180.0f, 0.0f);
-		break;
-	case ESnakeDirection::Left:
-		ForwardRotation = FRotator(0.0f, 270.0f, 0.0f);
-		break;
-	}
-}
-
-// Return unit vector based on the current direction
-FVector ASnakePawn::GetDirectionVector() const
-{
-	switch (Direction)
-	{
-	case ESnakeDirection::Up:
-		return FVector(1.0f, 0.0f, 0.0f);
-	case ESnakeDirection::Right:
-		return FVector(0.0f, 1.0f, 0.0f);
-	case ESnakeDirection::Down:
-		return FVector(-1.0f, 0.0f, 0.0f);
-	case ESnakeDirection::Left:
-		return FVector(0.0f, -1.0f, 0.0f);
-	default:
-		return FVector::ZeroVector;
-	}
-}
-
 // Add a new direction to the movement queue
 void ASnakePawn::SetNextDirection(ESnakeDirection InDirection)
 {
@@ -410,87 +438,9 @@ void ASnakePawn::SetNextDirection(ESnakeDirection InDirection)
 
 void ASnakePawn::GrowTail()
 {
-	if (!GetWorld())
+	// The simulation keeps the tail end where it is on the next step, ShowStep adds the segment then
+	if (USnakeSimSubsystem* Sim = GetWorld() ? GetWorld()->GetSubsystem<USnakeSimSubsystem>() : nullptr)
 	{
-		return;
+		Sim->GrowSnake(*this);
 	}
-
-	FActorSpawnParameters SpawnParams;
-	SpawnParams.Owner = this;  
-	UClass* SpawnClass = TailSegmentClass.Get() ? TailSegmentClass.Get()
-												: ASnakeTailSegment::StaticClass();
-
-	ASnakeTailSegment* NewSegment = GetWorld()->SpawnActor<ASnakeTailSegment>(
-		SpawnClass,
-		LastTilePosition,
-		FRotator::ZeroRotator,
-		SpawnParams
-	);
-
-	
-	if (NewSegment)
-	{
-		if (UStaticMeshComponent* HeadMesh = FindComponentByClass<UStaticMeshComponent>())
-		{
-			if (UMaterialInterface* HeadMat = HeadMesh->GetMaterial(0))
-			{
-				NewSegment->MeshComponent->SetMaterial(0, HeadMat);
-			}
-		}
-		
-		NewSegment->MeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-		NewSegment->bCanCollide = false;
-		
-		FTimerHandle TimerHandle;
-		FTimerDelegate TimerDel;
-		TimerDel.BindLambda([NewSegment]()
-		{
-			if (NewSegment)
-			{
-				NewSegment->MeshComponent->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
-				NewSegment->bCanCollide = true;
-			}
-		});
-		GetWorld()->GetTimerManager().SetTimer(TimerHandle, TimerDel, 0.3f, false);
-		
-		TailSegments.Add(NewSegment);
-		TailTargetPositions.Add(LastTilePosition);
-
-		UE_LOG(LogTemp, Warning, TEXT("Tail grown. Total segments: %d"), TailSegments.Num());
-	}
-}
-
-
-
-void ASnakePawn::UpdateTailTargets(const FVector& PreviousHeadPosition)
-{
-	if (TailSegments.Num() > 0)
-	{
-		TailTargetPositions[0] = PreviousHeadPosition;
-		for (int32 i = 1; i < TailSegments.Num(); i++)
-		{
-			TailTargetPositions[i] = TailTargetPositions[i - 1];
-		}
-	}
-}
-
-void ASnakePawn::UpdateTailPositions(const FVector& PreviousTilePosition)
-{
-	if (TailSegments.Num() > 0)
-	{
-		TArray<FVector> OldPositions;
-		OldPositions.SetNum(TailSegments.Num());
-
-		for (int32 i = 0; i < TailSegments.Num(); i++)
-		{
-			OldPositions[i] = TailSegments[i]->GetActorLocation();
-		}
-
-		TailSegments[0]->SetActorLocation(PreviousTilePosition);
-
-		for (int32 i = 1; i < TailSegments.Num(); i++)
-		{
-			TailSegments[i]->SetActorLocation(OldPositions[i - 1]);
-		}
-	}
-}
+}
\ No newline at end of file
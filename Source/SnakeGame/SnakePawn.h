@@ -6,9 +6,14 @@
 #include "Components/SphereComponent.h"
 #include "Components/WidgetComponent.h"    
 #include "Sound/SoundBase.h"
+#include "SnakeBodyRing.h"
+#include "SnakeTrail.h"
 #include "SnakePawn.generated.h"
 
 class ASnakeTailSegment;
+class USnakeTailRendererComponent;
+class ASnakeWorld;
+struct FSnakeStepResult;
 
 UCLASS()
 class SNAKEGAME_API ASnakePawn : public APawn
@@ -41,22 +46,32 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	ESnakeDirection Direction = ESnakeDirection::None;
 	
+	// Draws the tail segments, all of them as instances of one mesh.
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Snake")
-	TArray<ASnakeTailSegment*> TailSegments;
+	USnakeTailRendererComponent* TailRenderer;
 	
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Snake")
 	FVector LastTilePosition;
+
+	// Tile of the head in the simulation and the one it came from, the head is drawn between the two.
+	FIntPoint HeadCell = FIntPoint::ZeroValue;
+	FIntPoint PreviousHeadCell = FIntPoint::ZeroValue;
+
+	/** Shows what USnakeSimSubsystem's step did to this snake: moves the head and body along, eats, or ends the game. */
+	void ShowStep(const FSnakeStepResult& Result);
+
+	/** Pops the next queued direction for the simulation, None to keep going the way it goes. */
+	ESnakeDirection TakeNextDirection();
 	
+	// The tail end stays put on the next simulation step.
 	UFUNCTION(BlueprintCallable, Category = "Snake")
 	void GrowTail();
 	
-	void UpdateTailTargets(const FVector& PreviousHeadPosition);
-	
-	UFUNCTION(BlueprintCallable, Category = "Snake")
-	void UpdateTailPositions(const FVector& PreviousTilePosition);
-	
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Snake")
-	TArray<FVector> TailTargetPositions;
+	// Tiles the body covers behind the head (WorldToCell of their positions), tail end last.
+	TSnakeBodyRing<FIntPoint> TailCells;
+
+	UFUNCTION(BlueprintPure, Category = "Snake")
+	int32 GetTailLength() const { return TailCells.Num(); }
 	
 	virtual void Tick(float DeltaTime) override;
 
@@ -70,14 +85,10 @@ public:
 	UFUNCTION(BlueprintCallable, meta = (ToolTip = "Add a direction onto a queue where the first in line direction gets set and popped."))
 	void SetNextDirection(ESnakeDirection InDirection);
 	
-	UFUNCTION()
-	void OnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
-	                    UPrimitiveComponent* OtherComp, int32 OtherBodyIndex,
-	                    bool bFromSweep, const FHitResult & SweepResult);
-	
 	UFUNCTION(BlueprintCallable, Category = "Game")
 	void GameOver();
 
+	// Only its look is used: the tail renderer takes the mesh, material and scale of its segment.
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Snake")
 	TSubclassOf<ASnakeTailSegment> TailSegmentClass;
 
@@ -97,31 +108,36 @@ protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 	TArray<ESnakeDirection> DirectionQueue;
 	
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta = (ToolTip = "How long the snake has moved since reaching the last tile."))
-	float MovedTileDistance = 0.0f;
-	
 	virtual void BeginPlay() override;
-	
-	UFUNCTION()
-	void UpdateDirection();
 
-	FVector GetDirectionVector() const;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	
 	UFUNCTION()
 	void UpdateMovement(float DeltaTime);
 	
-	UFUNCTION()
-	void MoveSnake(float Distance);
-	
 	UFUNCTION()
 	void UpdateFalling(float DeltaTime);
 
+	// Effects, the apple actor and the score for food the simulation says this snake ate.
+	void EatFood(AActor* Food);
+
+	// Through USnakeSimSubsystem::RunAfterStep, right away without one.
+	void RunAfterStep(TFunction<void()> Event);
+
 private:
-	TArray<FVector> HeadPositionHistory;
+	// Where the head has been, the tail segments are laid out along it.
+	FSnakeTrail Trail;
+	TArray<FVector> TrailSamples;
+
+	// Grid the head and tail tiles are reported to, see ASnakeWorld::OccupyCell.
+	TWeakObjectPtr<ASnakeWorld> SnakeWorld;
 	
+	// Distance between tail segments along the trail, in steps of TrailSpacingUnit.
 	UPROPERTY(EditAnywhere, Category = "Snake|Tail")
 	int32 TailHistorySpacing = 5;
 	
+	static constexpr float TrailSpacingUnit = 10.0f;
+
 	static FVector SnapToGrid(const FVector& InLocation);
 
 	FTimerHandle QuestionMarkTimerHandle;
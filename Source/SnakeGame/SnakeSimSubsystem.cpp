@@ -0,0 +1,304 @@
+#include "SnakeSimSubsystem.h"
+
+#include "SnakeAIPlanner.h"
+#include "SnakeGrid.h"
+#include "SnakePawn.h"
+#include "SnakeWorld.h"
+
+void USnakeSimSubsystem::RegisterSnake(ASnakePawn& Snake)
+{
+    if (!Snakes.ContainsByPredicate([&Snake](const FSimSnake& Other) { return Other.Pawn == &Snake; }))
+    {
+        FSimSnake& Added = Snakes.AddDefaulted_GetRef();
+        Added.Pawn = &Snake;
+    }
+}
+
+void USnakeSimSubsystem::UnregisterSnake(ASnakePawn& Snake)
+{
+    const int32 Index = Snakes.IndexOfByPredicate([&Snake](const FSimSnake& Other) { return Other.Pawn == &Snake; });
+    if (Index == INDEX_NONE)
+    {
+        return;
+    }
+    if (Snakes[Index].Slot != INDEX_NONE)
+    {
+        Board.RemoveSnake(Snakes[Index].Slot);
+    }
+    Snakes.RemoveAt(Index);
+}
+
+void USnakeSimSubsystem::SetBoard(ASnakeWorld& World)
+{
+    BoardWorld = &World;
+    bBoardChanged = true;
+}
+
+void USnakeSimSubsystem::GrowSnake(const ASnakePawn& Snake)
+{
+    const FSimSnake* Found = Snakes.FindByPredicate([&Snake](const FSimSnake& Other) { return Other.Pawn == &Snake; });
+    if (Found && Found->Slot != INDEX_NONE && !Found->bDead)
+    {
+        Board.AddGrowth(Found->Slot, 1);
+    }
+}
+
+void USnakeSimSubsystem::SetStepsPerSecond(float InStepsPerSecond)
+{
+    StepsPerSecond = FMath::Max(InStepsPerSecond, 0.1f);
+}
+
+void USnakeSimSubsystem::RunAfterStep(TFunction<void()> Event)
+{
+    if (bStepping)
+    {
+        AfterStep.Add(MoveTemp(Event));
+    }
+    else
+    {
+        Event();
+    }
+}
+
+float USnakeSimSubsystem::GetInterpolationAlpha() const
+{
+    return FMath::Clamp(float(Accumulator * StepsPerSecond), 0.0f, 1.0f);
+}
+
+TStatId USnakeSimSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(USnakeSimSubsystem, STATGROUP_Tickables);
+}
+
+void USnakeSimSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    const double StepTime = 1.0 / StepsPerSecond;
+    Accumulator += DeltaTime;
+
+    int32 NumSteps = 0;
+    while (Accumulator >= StepTime && NumSteps < MaxStepsPerFrame)
+    {
+        Accumulator -= StepTime;
+        Step();
+        NumSteps++;
+    }
+
+    if (Accumulator >= StepTime)
+    {
+        UE_LOG(LogTemp, Verbose, TEXT("Simulation is %d steps behind, dropping them"), int32(Accumulator / StepTime));
+        Accumulator = FMath::Fmod(Accumulator, StepTime);
+    }
+}
+
+void USnakeSimSubsystem::SyncBoard()
+{
+    ASnakeWorld* World = BoardWorld.Get();
+    if (!World)
+    {
+        for (FSimSnake& Snake : Snakes)
+        {
+            Snake.Slot = INDEX_NONE;
+        }
+        return;
+    }
+
+    if (bBoardChanged)
+    {
+        bBoardChanged = false;
+
+        // A new level: bodies are where the pawns show them, directions and growth carry over
+        TArray<TPair<int32, int32>, TInlineAllocator<16>> Carried;
+        for (const FSimSnake& Snake : Snakes)
+        {
+            const ASnakePawn& Pawn = *Snake.Pawn;
+            Carried.Emplace(Snake.Slot != INDEX_NONE ? Board.GetDirection(Snake.Slot) : (Pawn.Direction != ESnakeDirection::None ? int32(Pawn.Direction) : INDEX_NONE),
+                            Snake.Slot != INDEX_NONE ? Board.GetGrowth(Snake.Slot) : 0);
+        }
+        Board.Init(World->GetGrid());
+        for (int32 Index = 0; Index < Snakes.Num(); Index++)
+        {
+            FSimSnake& Snake = Snakes[Index];
+            Snake.Slot = Snake.bDead ? INDEX_NONE : AddToBoard(*Snake.Pawn, Carried[Index].Key, Carried[Index].Value);
+        }
+    }
+    else
+    {
+        for (FSimSnake& Snake : Snakes)
+        {
+            if (Snake.Slot == INDEX_NONE && !Snake.bDead)
+            {
+                const ESnakeDirection Direction = Snake.Pawn->Direction;
+                Snake.Slot = AddToBoard(*Snake.Pawn, Direction != ESnakeDirection::None ? int32(Direction) : INDEX_NONE, 0);
+            }
+        }
+    }
+
+    // The world spawns apples and takes eaten ones away, the board only needs to know where they are
+    const FSnakeGrid& Grid = World->GetGrid();
+    TArray<int32, TInlineAllocator<32>> Gone;
+    for (const int32 Index : Board.GetFoodCells())
+    {
+        if (!Grid.HasFlagAt(Index, ESnakeCell::Food))
+        {
+            Gone.Add(Index);
+        }
+    }
+    for (const int32 Index : Gone)
+    {
+        Board.SetFood(Index, false);
+    }
+    for (const int32 Index : World->GetFoodIndex().GetCells())
+    {
+        Board.SetFood(Index, true);
+    }
+}
+
+int32 USnakeSimSubsystem::AddToBoard(const ASnakePawn& Pawn, int32 Direction, int32 Growth)
+{
+    const ASnakeWorld& World = *BoardWorld;
+    const FSnakeGrid& Grid = World.GetGrid();
+
+    TArray<int32, TInlineAllocator<64>> Body;
+    Body.Add(Grid.ToIndex(World.WorldToGridCell(CellToWorld(Pawn.HeadCell))));
+    for (const FIntPoint& Tile : Pawn.TailCells)
+    {
+        Body.Add(Grid.ToIndex(World.WorldToGridCell(CellToWorld(Tile))));
+    }
+
+    const int32 Slot = Board.AddSnake(Body, Direction, Growth);
+    if (Slot == INDEX_NONE)
+    {
+        UE_LOG(LogTemp, Verbose, TEXT("%s is off the level or the board is full, it runs into nothing"), *Pawn.GetName());
+    }
+    return Slot;
+}
+
+FSnakeStepResult USnakeSimSubsystem::StepOffBoard(const ASnakePawn& Pawn, ESnakeDirection Move)
+{
+    // Same turning rule as on the board: going back the way it came keeps it going straight
+    FSnakeStepResult Result;
+    Result.Direction = Pawn.Direction;
+    if (Move != ESnakeDirection::None && (Pawn.Direction == ESnakeDirection::None || (int32(Move) + 2) % FSnakeGrid::NumDirections != int32(Pawn.Direction)))
+    {
+        Result.Direction = Move;
+    }
+    Result.HeadCell = Pawn.HeadCell;
+    if (Result.Direction != ESnakeDirection::None)
+    {
+        Result.HeadCell += FSnakeGrid::GetDirectionOffset(int32(Result.Direction));
+        Result.bMoved = true;
+    }
+    return Result;
+}
+
+void USnakeSimSubsystem::Step()
+{
+    OnPreStep.Broadcast(StepCount);
+
+    // Plans asked for just now are needed before the snakes move, not at the end of the frame
+    if (USnakeAIPlanner* Planner = GetWorld()->GetSubsystem<USnakeAIPlanner>())
+    {
+        Planner->PlanRequests();
+    }
+
+    // Pawns that went without ending play give up their place on the board
+    Snakes.RemoveAll([this](const FSimSnake& Snake)
+    {
+        if (Snake.Pawn.IsValid())
+        {
+            return false;
+        }
+        if (Snake.Slot != INDEX_NONE)
+        {
+            Board.RemoveSnake(Snake.Slot);
+        }
+        return true;
+    });
+    SyncBoard();
+
+    // What every snake was before, the step's result for a pawn is how its snake changed
+    struct FBefore
+    {
+        int32 Head = INDEX_NONE;
+        int32 Length = 0;
+        int32 FoodEaten = 0;
+    };
+    const TArray<FSimSnake, TInlineAllocator<16>> Stepping(Snakes);
+    TArray<FBefore, TInlineAllocator<16>> Before;
+    TArray<FSnakeStepResult, TInlineAllocator<16>> Results;
+    Before.SetNum(Stepping.Num());
+    Results.SetNum(Stepping.Num());
+
+    // One move per snake from its queue, INDEX_NONE keeps it going the way it goes
+    Moves.Init(INDEX_NONE, Board.GetNumSnakes());
+    for (int32 Index = 0; Index < Stepping.Num(); Index++)
+    {
+        const FSimSnake& Snake = Stepping[Index];
+        if (Snake.bDead)
+        {
+            continue;
+        }
+        const ESnakeDirection Move = Snake.Pawn->TakeNextDirection();
+        if (Snake.Slot == INDEX_NONE)
+        {
+            Results[Index] = StepOffBoard(*Snake.Pawn, Move);
+            continue;
+        }
+        Moves[Snake.Slot] = Move != ESnakeDirection::None ? int32(Move) : INDEX_NONE;
+        Before[Index].Head = Board.GetHead(Snake.Slot);
+        Before[Index].Length = Board.GetLength(Snake.Slot);
+        Before[Index].FoodEaten = Board.GetFoodEaten(Snake.Slot);
+    }
+
+    // Every head and tail moves, then crashes and apples are decided for all snakes at once
+    Board.Step(Moves);
+
+    for (int32 Index = 0; Index < Stepping.Num(); Index++)
+    {
+        const FSimSnake& Snake = Stepping[Index];
+        if (Snake.bDead || Snake.Slot == INDEX_NONE)
+        {
+            continue;
+        }
+
+        FSnakeStepResult& Result = Results[Index];
+        if (!Board.IsAlive(Snake.Slot))
+        {
+            Result.bDied = true;
+            Snakes[Index].bDead = true;
+            continue;
+        }
+
+        const ASnakeWorld& World = *BoardWorld;
+        const int32 Head = Board.GetHead(Snake.Slot);
+        const int32 Direction = Board.GetDirection(Snake.Slot);
+        Result.HeadCell = WorldToCell(World.GridCellToWorld(World.GetGrid().ToCell(Head)));
+        Result.Direction = Direction != INDEX_NONE ? ESnakeDirection(Direction) : ESnakeDirection::None;
+        Result.bMoved = Head != Before[Index].Head;
+        Result.bGrew = Board.GetLength(Snake.Slot) > Before[Index].Length;
+        Result.bAte = Board.GetFoodEaten(Snake.Slot) > Before[Index].FoodEaten;
+    }
+
+    // A pawn may end play while it's shown its step, which takes it off the list
+    bStepping = true;
+    for (int32 Index = 0; Index < Stepping.Num(); Index++)
+    {
+        ASnakePawn* Pawn = Stepping[Index].Pawn.Get();
+        if (Pawn && !Stepping[Index].bDead)
+        {
+            Pawn->ShowStep(Results[Index]);
+        }
+    }
+    bStepping = false;
+    StepCount++;
+
+    // In the order they came up; anything these queue runs right away
+    TArray<TFunction<void()>> Events = MoveTemp(AfterStep);
+    AfterStep.Reset();
+    for (TFunction<void()>& Event : Events)
+    {
+        Event();
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Definitions.h"
+#include "SnakeSimState.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SnakeSimSubsystem.generated.h"
+
+class ASnakePawn;
+class ASnakeWorld;
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnSnakeSimStep, uint32);
+
+/** What one simulation step did to a snake, for its pawn to show. */
+struct FSnakeStepResult
+{
+	// Where the head is after the step, in the pawn's cells (WorldToCell).
+	FIntPoint HeadCell = FIntPoint::ZeroValue;
+	ESnakeDirection Direction = ESnakeDirection::None;
+	bool bMoved = false;
+	// The tail end stayed put, the body is a cell longer.
+	bool bGrew = false;
+	bool bAte = false;
+	bool bDied = false;
+};
+
+/**
+ * Fixed rate clock for the game rules. The board is an FSnakeSimState built from ASnakeWorld's grid:
+ * on every step each registered snake's queued direction goes into one FSnakeSimState::Step, which moves
+ * every head and tail and only then decides who crashed or ate, and each pawn is shown what happened to
+ * it. The game thus plays by the very rules Monte Carlo search and the headless program play by, the
+ * same whatever the frame rate. Frames only draw: pawns place themselves between their last two tiles
+ * using GetInterpolationAlpha.
+ *
+ * A frame runs as many steps as the time since the last one covers, up to MaxStepsPerFrame. After a
+ * longer hitch the game falls behind the wall clock for a moment rather than moving snakes in a burst.
+ */
+UCLASS()
+class SNAKEGAME_API USnakeSimSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static constexpr int32 MaxStepsPerFrame = 8;
+
+	/** The snake joins the board on the next step, from the cells its pawn is on. */
+	void RegisterSnake(ASnakePawn& Snake);
+	void UnregisterSnake(ASnakePawn& Snake);
+
+	/** The level the snakes play on. Called again whenever its grid is replaced, the board is rebuilt on the next step. */
+	void SetBoard(ASnakeWorld& World);
+
+	/** The snake's tail stays put for one more step, see FSnakeSimState::AddGrowth. */
+	void GrowSnake(const ASnakePawn& Snake);
+
+	void SetStepsPerSecond(float InStepsPerSecond);
+	float GetStepsPerSecond() const { return StepsPerSecond; }
+
+	/** Runs one step right away, whatever the clock says. */
+	void Step();
+
+	/** Steps run since the world began play. */
+	uint32 GetStepCount() const { return StepCount; }
+
+	/** How far along the time to the next step is, 0 right after a step and close to 1 just before the next. */
+	float GetInterpolationAlpha() const;
+
+	/** Broadcast with the step's number at its start, before any snake moves. Controllers pick their directions here. */
+	FOnSnakeSimStep OnPreStep;
+
+	/**
+	 * Runs Event once every snake has been shown the current step, right away outside a step. For rules
+	 * that change the board under everyone, like scoring the apple that finishes a level or ending the
+	 * game, so no snake sees a board where others have only moved half way.
+	 */
+	void RunAfterStep(TFunction<void()> Event);
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+private:
+	struct FSimSnake
+	{
+		TWeakObjectPtr<ASnakePawn> Pawn;
+		// Its number on Board, INDEX_NONE until it joins.
+		int32 Slot = INDEX_NONE;
+		// Crashed, it stays where it is until its pawn goes.
+		bool bDead = false;
+	};
+
+	// Rebuilds the board after a level change, puts new snakes on it and takes over the world's food.
+	void SyncBoard();
+	int32 AddToBoard(const ASnakePawn& Pawn, int32 Direction, int32 Growth);
+
+	// A snake that isn't on the board (no world, or off the level) goes straight on and runs into nothing.
+	static FSnakeStepResult StepOffBoard(const ASnakePawn& Pawn, ESnakeDirection Move);
+
+	TArray<FSimSnake> Snakes;
+	FSnakeSimState Board;
+	TWeakObjectPtr<ASnakeWorld> BoardWorld;
+	bool bBoardChanged = false;
+	TArray<int32> Moves;
+
+	float StepsPerSecond = 5.0f;
+	double Accumulator = 0.0;
+	uint32 StepCount = 0;
+	bool bStepping = false;
+	TArray<TFunction<void()>> AfterStep;
+};
@@ -0,0 +1,89 @@
+#include "SnakeTailRendererComponent.h"
+
+#include "Components/StaticMeshComponent.h"
+#include "SnakeTailSegment.h"
+#include "UObject/ConstructorHelpers.h"
+
+USnakeTailRendererComponent::USnakeTailRendererComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	// Instances are placed in world space, the component stays put while the snake moves
+	SetUsingAbsoluteLocation(true);
+	SetUsingAbsoluteRotation(true);
+	SetUsingAbsoluteScale(true);
+
+	SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	SetGenerateOverlapEvents(false);
+	SetCanEverAffectNavigation(false);
+	NumCustomDataFloats = 3;
+
+	static ConstructorHelpers::FObjectFinder<UStaticMesh> CubeMesh(TEXT("/Engine/BasicShapes/Cube"));
+	if (CubeMesh.Succeeded())
+	{
+		SetStaticMesh(CubeMesh.Object);
+	}
+}
+
+void USnakeTailRendererComponent::CopyLookFrom(TSubclassOf<ASnakeTailSegment> SegmentClass, UMaterialInterface* Material)
+{
+	const ASnakeTailSegment* Segment = SegmentClass ? SegmentClass->GetDefaultObject<ASnakeTailSegment>() : nullptr;
+	if (Segment && Segment->MeshComponent)
+	{
+		if (UStaticMesh* Mesh = Segment->MeshComponent->GetStaticMesh())
+		{
+			SetStaticMesh(Mesh);
+		}
+		SegmentScale = Segment->MeshComponent->GetRelativeScale3D();
+		if (!Material)
+		{
+			Material = Segment->MeshComponent->GetMaterial(0);
+		}
+	}
+	if (Material)
+	{
+		SetMaterial(0, Material);
+	}
+}
+
+int32 USnakeTailRendererComponent::AddSegment(const FVector& WorldLocation)
+{
+	Positions.Add(WorldLocation);
+	const int32 Index = AddInstance(FTransform(FQuat::Identity, WorldLocation, SegmentScale), true);
+	if (bUseSegmentColors)
+	{
+		SetSegmentColor(Index, SegmentColor);
+	}
+	return Index;
+}
+
+void USnakeTailRendererComponent::FollowTargets(TConstArrayView<FVector> Targets, float DeltaTime, float SmoothSpeed)
+{
+	const int32 Num = FMath::Min(Positions.Num(), Targets.Num());
+	for (int32 i = 0; i < Num; i++)
+	{
+		Positions[i] = FMath::VInterpTo(Positions[i], Targets[i], DeltaTime, SmoothSpeed);
+	}
+	PushTransforms();
+}
+
+void USnakeTailRendererComponent::SetSegmentColor(int32 Index, FLinearColor Color)
+{
+	const float Data[] = { Color.R, Color.G, Color.B };
+	SetCustomData(Index, Data, true);
+}
+
+void USnakeTailRendererComponent::PushTransforms()
+{
+	if (Positions.Num() == 0)
+	{
+		return;
+	}
+	Transforms.SetNum(Positions.Num(), EAllowShrinking::No);
+	for (int32 i = 0; i < Positions.Num(); i++)
+	{
+		Transforms[i] = FTransform(FQuat::Identity, Positions[i], SegmentScale);
+	}
+	// World space, render state dirty, teleport: there is no collision to sweep
+	BatchUpdateInstancesTransforms(0, Transforms, true, true, true);
+}
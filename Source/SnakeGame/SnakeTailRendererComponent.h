@@ -0,0 +1,55 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "SnakeTailRendererComponent.generated.h"
+
+class ASnakeTailSegment;
+
+/**
+ * All tail segments of one snake as instances of a single mesh. Segment positions are kept here in
+ * world space and pushed to the instances in one batch per frame, so a long tail is one component
+ * update rather than an actor move per segment. Segments don't collide, tail hits are decided on the grid.
+ *
+ * Optionally every instance carries a colour in its custom data (three floats, RGB) for the material
+ * to read with PerInstanceCustomData.
+ */
+UCLASS(ClassGroup=(Snake), meta=(BlueprintSpawnableComponent))
+class SNAKEGAME_API USnakeTailRendererComponent : public UInstancedStaticMeshComponent
+{
+	GENERATED_BODY()
+
+public:
+	USnakeTailRendererComponent();
+
+	// Write SegmentColor into every new instance's custom data.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Snake|Tail")
+	bool bUseSegmentColors = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Snake|Tail", meta=(EditCondition="bUseSegmentColors"))
+	FLinearColor SegmentColor = FLinearColor::White;
+
+	/** Mesh, material and scale of a tail segment class, what the segment actors used to look like. Material overrides the segment's own when set. */
+	void CopyLookFrom(TSubclassOf<ASnakeTailSegment> SegmentClass, UMaterialInterface* Material);
+
+	/** New segment at the tail end, placed at WorldLocation. */
+	int32 AddSegment(const FVector& WorldLocation);
+
+	/** Moves every segment part of the way to its target (one per segment, world space) and updates all instances at once. */
+	void FollowTargets(TConstArrayView<FVector> Targets, float DeltaTime, float SmoothSpeed);
+
+	UFUNCTION(BlueprintCallable, Category = "Snake|Tail")
+	void SetSegmentColor(int32 Index, FLinearColor Color);
+
+	UFUNCTION(BlueprintPure, Category = "Snake|Tail")
+	int32 GetNumSegments() const { return Positions.Num(); }
+
+	const FVector& GetSegmentLocation(int32 Index) const { return Positions[Index]; }
+
+private:
+	void PushTransforms();
+
+	TArray<FVector> Positions;
+	TArray<FTransform> Transforms;
+	FVector SegmentScale = FVector(0.5f);
+};
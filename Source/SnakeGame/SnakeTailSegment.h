@@ -4,6 +4,7 @@
 #include "GameFramework/Actor.h"
 #include "SnakeTailSegment.generated.h"
 
+/** Not spawned any more: blueprints of it describe what a snake's tail looks like, see USnakeTailRendererComponent::CopyLookFrom. */
 UCLASS()
 class SNAKEGAME_API ASnakeTailSegment : public AActor
 {
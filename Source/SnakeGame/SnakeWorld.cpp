@@ -2,8 +2,13 @@
 
 #include "Definitions.h"
 #include "Engine/World.h"
+#include "EngineUtils.h"
 #include "SnakeFood.h"
-#include "Misc/FileHelper.h"
+#include "SnakePawn.h"
+#include "SnakeSimSubsystem.h"
+#include "Camera/PlayerCameraManager.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/PlatformFileManager.h"
 #include "Misc/Paths.h"
 
 ASnakeWorld::ASnakeWorld()
@@ -28,20 +33,13 @@ void ASnakeWorld::OnConstruction(const FTransform& Transform)
 {
     UE_LOG(LogTemp, Log, TEXT("OnConstruction Called!"));
 
-    // Clean up previous instances and spawned actors
-    InstancedWalls->ClearInstances();
-    InstancedFloors->ClearInstances();
-    for (AActor* Actor : SpawnedActors)
-    {
-        if (Actor)
-        {
-            Actor->Destroy();
-        }
-    }
-    SpawnedActors.Empty();
+    // Instances are diffed against the reloaded level, only spawned actors are cleaned up here
+    DestroyDoors();
     
-    // Clear previous floor tile locations.
-    FloorTileLocations.Empty();
+    Grid.Reset();
+    FreeCells.Reset();
+    FoodIndex.Reset();
+    GridJournal.Invalidate();
 
 
     InstancedWalls->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
@@ -55,28 +53,359 @@ void ASnakeWorld::OnConstruction(const FTransform& Transform)
     LoadLevelFromText();
 }
 
+namespace
+{
+    // Back buffer chunks sit out of reach below the level so their wall bodies can't be overlapped.
+    const FVector ChunkParkingOffset(0.0f, 0.0f, -100000.0f);
+
+    void SetComponentParked(UHierarchicalInstancedStaticMeshComponent* Component, const FTransform& RelativeTransform, bool bParked)
+    {
+        if (!Component)
+        {
+            return;
+        }
+        FTransform Transform = RelativeTransform;
+        if (bParked)
+        {
+            Transform.AddToTranslation(ChunkParkingOffset);
+            Component->SetVisibility(false);
+        }
+        Component->SetRelativeTransform(Transform, false, nullptr, ETeleportType::TeleportPhysics);
+    }
+
+    // Makes the component hold exactly the desired instances. Instances already on a wanted cell are
+    // kept, leftovers are moved onto missing cells in place, and the rest is added or removed in one call.
+    // Returns how many instances had to change.
+    int32 ApplyInstanceDiff(UInstancedStaticMeshComponent* Component, const TArray<FTransform>& Desired,
+                            const FIntRect& Bounds, TArray<int32>& CellToInstance)
+    {
+        const int32 NumExisting = Component->GetInstanceCount();
+        if (NumExisting == 0)
+        {
+            Component->AddInstances(Desired, false);
+            return Desired.Num();
+        }
+
+        const FIntPoint Size = Bounds.Size();
+        const auto LocalIndex = [&Bounds, &Size](const FTransform& Transform)
+        {
+            const FIntPoint Cell = WorldToCell(Transform.GetTranslation());
+            return Bounds.Contains(Cell) ? (Cell.X - Bounds.Min.X) * Size.Y + (Cell.Y - Bounds.Min.Y) : INDEX_NONE;
+        };
+
+        CellToInstance.Init(INDEX_NONE, Size.X * Size.Y);
+        FTransform Existing;
+        for (int32 i = 0; i < NumExisting; i++)
+        {
+            Component->GetInstanceTransform(i, Existing);
+            const int32 Local = LocalIndex(Existing);
+            if (Local != INDEX_NONE)
+            {
+                CellToInstance[Local] = i;
+            }
+        }
+
+        TBitArray<> Kept(false, NumExisting);
+        TArray<const FTransform*> Missing;
+        for (const FTransform& Transform : Desired)
+        {
+            const int32 Local = LocalIndex(Transform);
+            const int32 Instance = Local != INDEX_NONE ? CellToInstance[Local] : INDEX_NONE;
+            if (Instance != INDEX_NONE && !Kept[Instance])
+            {
+                Kept[Instance] = true;
+            }
+            else
+            {
+                Missing.Add(&Transform);
+            }
+        }
+
+        int32 NumMoved = 0;
+        TArray<int32> ToRemove;
+        for (int32 i = 0; i < NumExisting; i++)
+        {
+            if (Kept[i])
+            {
+                continue;
+            }
+            if (NumMoved < Missing.Num())
+            {
+                Component->UpdateInstanceTransform(i, *Missing[NumMoved++], false, false, true);
+            }
+            else
+            {
+                ToRemove.Add(i);
+            }
+        }
+        if (NumMoved > 0)
+        {
+            Component->MarkRenderStateDirty();
+        }
+        if (ToRemove.Num() > 0)
+        {
+            Component->RemoveInstances(ToRemove);
+        }
+        if (NumMoved < Missing.Num())
+        {
+            TArray<FTransform> Added;
+            Added.Reserve(Missing.Num() - NumMoved);
+            for (int32 i = NumMoved; i < Missing.Num(); i++)
+            {
+                Added.Add(*Missing[i]);
+            }
+            Component->AddInstances(Added, false);
+        }
+        return Missing.Num() + ToRemove.Num();
+    }
+}
+
 void ASnakeWorld::BeginPlay()
 {
     Super::BeginPlay();
+
+    // Construction scripts don't rerun for placed actors in cooked games, make sure the chunks hold the level.
+    if (!FrontChunks.Level.IsValid() || FrontChunks.Level->LevelIndex != LevelIndex)
+    {
+        LoadLevelFromText();
+    }
+    if (USnakeSimSubsystem* Sim = GetWorld()->GetSubsystem<USnakeSimSubsystem>())
+    {
+        Sim->SetBoard(*this);
+    }
+
+    FoodRandom.Initialize(FoodRandomSeed != 0 ? FoodRandomSeed : FMath::Rand());
     SpawnFood();
+    PrefetchLevel(LevelIndex + 1);
 }
 
 void ASnakeWorld::Tick(float DeltaTime)
 {
     Super::Tick(DeltaTime);
+
+    UpdateChunkRelevance();
+    FillBackBuffer(PrefetchInstancesPerFrame);
+
+    if (NextHopTask.IsValid() && NextHopTask.IsCompleted())
+    {
+        NextHopTable = NextHopTask.GetResult();
+        NextHopTask = {};
+    }
+}
+
+TSharedPtr<const FSnakeLevelPack> ASnakeWorld::GetLevelPackShared() const
+{
+    if (!bTriedOpeningLevelPack)
+    {
+        bTriedOpeningLevelPack = true;
+        TSharedPtr<FSnakeLevelPack> Pack = MakeShared<FSnakeLevelPack>();
+        if (Pack->Open(FSnakeLevelPack::GetDefaultPackPath()))
+        {
+            // Translations are baked at the pack's tile size, they'd put tiles in the wrong places
+            if (FMath::IsNearlyEqual(Pack->GetTileSize(), TileSize))
+            {
+                LevelPack = Pack;
+            }
+            else
+            {
+                UE_LOG(LogTemp, Warning, TEXT("[LevelPack] Pack was built for tile size %.1f, the game uses %.1f; loading the text files instead"),
+                       Pack->GetTileSize(), TileSize);
+            }
+        }
+    }
+    return LevelPack;
+}
+
+const FSnakeLevelPack* ASnakeWorld::GetLevelPack() const
+{
+    return GetLevelPackShared().Get();
+}
+
+FString ASnakeWorld::GetLevelTextPath(int32 Index)
+{
+    return FPaths::ProjectContentDir() / FString::Printf(TEXT("Levels/Level%d.txt"), Index);
+}
+
+FString ASnakeWorld::GetNextHopCachePath(int32 Index)
+{
+    return FPaths::ProjectContentDir() / FString::Printf(TEXT("Levels/Level%d.nexthop"), Index);
+}
+
+void ASnakeWorld::RequestNextHopTable(int32 Index)
+{
+    // A task for the previous level may still be running, it finishes on its own and is dropped.
+    NextHopTable.Reset();
+    NextHopTask = {};
+
+    if (!bBuildNextHopTable || Grid.GetNumWalkable() > NextHopMaxCells || !GetWorld() || !GetWorld()->IsGameWorld())
+    {
+        return;
+    }
+
+    // Only walls matter, the worker gets its own copy of the grid.
+    NextHopTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [StaticGrid = Grid, CachePath = GetNextHopCachePath(Index)]()
+    {
+        TSharedPtr<FSnakeNextHopTable> Table = MakeShared<FSnakeNextHopTable>();
+        if (!Table->LoadFromFile(CachePath, StaticGrid))
+        {
+            Table->Build(StaticGrid);
+            if (!Table->SaveToFile(CachePath))
+            {
+                UE_LOG(LogTemp, Warning, TEXT("[NextHop] Couldn't write %s"), *CachePath);
+            }
+        }
+        return Table;
+    });
 }
 
 bool ASnakeWorld::DoesLevelExist(int32 Index) const
 {
-    const FString FileName = FString::Printf(TEXT("Levels/Level%d.txt"), Index);
-    const FString FullPath = FPaths::ProjectContentDir() / FileName;
-    return FPlatformFileManager::Get().GetPlatformFile().FileExists(*FullPath);
+    if (const FSnakeLevelPack* Pack = GetLevelPack())
+    {
+        return Pack->HasLevel(Index);
+    }
+    return FPlatformFileManager::Get().GetPlatformFile().FileExists(*GetLevelTextPath(Index));
+}
+
+TSharedPtr<FSnakeLevelBuild> ASnakeWorld::BuildLevel(const TSharedPtr<const FSnakeLevelPack>& Pack, int32 Index, int32 InChunkSize)
+{
+    FSnakeLevelView Level;
+    FSnakeLevelData ParsedLevel;
+
+    const FString FilePath = GetLevelTextPath(Index);
+    const bool bInPack = Pack.IsValid() && Pack->FindLevel(Index, Level);
+    if (bInPack && !Pack->IsOlderThan(FilePath))
+    {
+        UE_LOG(LogTemp, Log, TEXT("[LevelLoad] Level %d from pack"), Index);
+    }
+    else
+    {
+        if (bInPack)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("[LevelLoad] %s is newer than the level pack, loading it instead (rebuild with -run=SnakeLevelPack)"), *FilePath);
+        }
+
+        // No compiled pack (or level missing from it, or out of date), parse the text file directly.
+        UE_LOG(LogTemp, Warning, TEXT("[LevelLoad] Attempting to load: %s"), *FilePath);
+
+        if (!ParsedLevel.LoadFromTextFile(FilePath, TileSize))
+        {
+            UE_LOG(LogTemp, Error, TEXT("[LevelLoad] Failed to load file!"));
+            return nullptr;
+        }
+        UE_LOG(LogTemp, Warning, TEXT("[LevelLoad] Loaded %d lines"), ParsedLevel.Height);
+        Level = ParsedLevel.GetView();
+    }
+    return BuildLevel(Level, Index, InChunkSize);
+}
+
+TSharedPtr<FSnakeLevelBuild> ASnakeWorld::BuildLevel(const FSnakeLevelView& Level, int32 Index, int32 InChunkSize)
+{
+    TSharedPtr<FSnakeLevelBuild> Build = MakeShared<FSnakeLevelBuild>();
+    Build->LevelIndex = Index;
+    Build->Grid.Init(Level);
+
+    Build->ChunkSize = FMath::Max(InChunkSize, 1);
+    Build->NumChunksX = FMath::DivideAndRoundUp(Build->Grid.GetSizeX(), Build->ChunkSize);
+    Build->NumChunksY = FMath::DivideAndRoundUp(Build->Grid.GetSizeY(), Build->ChunkSize);
+    Build->Chunks.SetNum(Build->NumChunksX * Build->NumChunksY);
+    Build->GridOrigin = Build->Grid.GetOrigin();
+
+    const auto ChunkOf = [&Build](const FVector3f& Translation)
+    {
+        const FIntPoint Cell = WorldToCell(FVector(Translation)) - Build->Grid.GetOrigin();
+        return (Cell.X / Build->ChunkSize) * Build->NumChunksY + Cell.Y / Build->ChunkSize;
+    };
+
+    for (const FVector3f& Translation : Level.WallTranslations)
+    {
+        Build->Chunks[ChunkOf(Translation)].WallTransforms.Emplace(FVector(Translation));
+    }
+    for (const FVector3f& Translation : Level.FloorTranslations)
+    {
+        Build->Chunks[ChunkOf(Translation)].FloorTransforms.Emplace(FVector(Translation));
+    }
+    for (const FVector3f& Translation : Level.DoorTranslations)
+    {
+        Build->Chunks[ChunkOf(Translation)].FloorTransforms.Emplace(FVector(Translation));
+        Build->DoorTransforms.Emplace(FVector(Translation));
+    }
+    return Build;
 }
 
 void ASnakeWorld::LoadLevelFromText()
 {
-    InstancedWalls->ClearInstances();
-    InstancedFloors->ClearInstances();
+    TSharedPtr<FSnakeLevelBuild> Build = BuildLevel(GetLevelPackShared(), LevelIndex, ChunkSize);
+    if (!Build.IsValid())
+    {
+        return;
+    }
+    ApplyLevelBuild(Build);
+
+    if (HasActorBegunPlay())
+    {
+        PrefetchLevel(LevelIndex + 1);
+    }
+}
+
+void ASnakeWorld::ApplyLevelBuild(const TSharedPtr<FSnakeLevelBuild>& Build)
+{
+    DestroyDoors();
+
+    if (GetWorld() && GetWorld()->IsGameWorld())
+    {
+        InstancedWalls->ClearInstances();
+        InstancedFloors->ClearInstances();
+        Grid = MoveTemp(Build->Grid);
+        AssignLevelToChunkSet(FrontChunks, Build, false);
+        UpdateChunkRelevance();
+    }
+    else
+    {
+        ApplyEditorPreview(*Build);
+        Grid = MoveTemp(Build->Grid);
+    }
+    RebuildOccupancy();
+    RequestNextHopTable(Build->LevelIndex);
+
+    SpawnDoors(Build->DoorTransforms);
+}
+
+void ASnakeWorld::ApplyEditorPreview(const FSnakeLevelBuild& Build)
+{
+    TArray<FTransform> Walls;
+    TArray<FTransform> Floors;
+    for (const FSnakeChunkBuild& Chunk : Build.Chunks)
+    {
+        Walls.Append(Chunk.WallTransforms);
+        Floors.Append(Chunk.FloorTransforms);
+    }
+
+    // Construction reruns on every edit, so most reloads only touch the tiles that changed.
+    const FIntRect Bounds(Build.GridOrigin, Build.GridOrigin + FIntPoint(Build.Grid.GetSizeX(), Build.Grid.GetSizeY()));
+    ApplyInstanceDiff(InstancedWalls, Walls, Bounds, InstanceDiffScratch);
+    ApplyInstanceDiff(InstancedFloors, Floors, Bounds, InstanceDiffScratch);
+}
+
+void ASnakeWorld::SpawnDoors(const TArray<FTransform>& DoorTransforms)
+{
+    if (!IsValid(DoorActor))
+    {
+        return;
+    }
+    for (const FTransform& DoorTransform : DoorTransforms)
+    {
+        AActor* SpawnedActor = GetWorld()->SpawnActor<AActor>(DoorActor, DoorTransform, FActorSpawnParameters());
+        if (SpawnedActor)
+        {
+            SpawnedActor->AttachToActor(this, FAttachmentTransformRules::KeepRelativeTransform);
+            SpawnedActors.Add(SpawnedActor);
+        }
+    }
+}
+
+void ASnakeWorld::DestroyDoors()
+{
     for (AActor* Actor : SpawnedActors)
     {
         if (Actor)
@@ -85,101 +414,606 @@ void ASnakeWorld::LoadLevelFromText()
         }
     }
     SpawnedActors.Empty();
-    FloorTileLocations.Empty();
+}
 
-    FString FileName = FString::Printf(TEXT("Levels/Level%d.txt"), LevelIndex);
-    FString FilePath = FPaths::ProjectContentDir() + FileName;
-    UE_LOG(LogTemp, Warning, TEXT("[LevelLoad] Attempting to load: %s"), *FilePath);
-    
-    TArray<FString> Lines;
+void ASnakeWorld::AssignLevelToChunkSet(FSnakeChunkSet& Set, const TSharedPtr<FSnakeLevelBuild>& Build, bool bParked)
+{
+    // Keep components by chunk coordinate so a level of another size still reuses what overlaps.
+    if (Set.NumChunksX != Build->NumChunksX || Set.NumChunksY != Build->NumChunksY)
+    {
+        TArray<FSnakeWorldChunk> OldChunks = MoveTemp(Set.Chunks);
+        Set.Chunks.SetNum(Build->NumChunksX * Build->NumChunksY);
+
+        for (int32 X = 0; X < Set.NumChunksX; X++)
+        {
+            for (int32 Y = 0; Y < Set.NumChunksY; Y++)
+            {
+                FSnakeWorldChunk& Old = OldChunks[X * Set.NumChunksY + Y];
+                if (X < Build->NumChunksX && Y < Build->NumChunksY)
+                {
+                    Set.Chunks[X * Build->NumChunksY + Y] = Old;
+                }
+                else
+                {
+                    if (Old.Walls) Old.Walls->DestroyComponent();
+                    if (Old.Floors) Old.Floors->DestroyComponent();
+                }
+            }
+        }
+        Set.NumChunksX = Build->NumChunksX;
+        Set.NumChunksY = Build->NumChunksY;
+    }
+
+    // Old instances stay until the chunk is built again and diffed against the new level.
+    for (FSnakeWorldChunk& Chunk : Set.Chunks)
+    {
+        if (Chunk.Walls)
+        {
+            Chunk.Walls->SetVisibility(false);
+        }
+        if (Chunk.Floors)
+        {
+            Chunk.Floors->SetVisibility(false);
+        }
+        Chunk.bBuilt = false;
+        Chunk.bVisible = false;
+    }
+
+    Set.Level = Build;
+    Set.NextChunkToPrefill = 0;
+    SetChunkSetParked(Set, bParked);
+}
+
+UHierarchicalInstancedStaticMeshComponent* ASnakeWorld::CreateChunkComponent(UInstancedStaticMeshComponent* Template, bool bParked)
+{
+    UHierarchicalInstancedStaticMeshComponent* Component =
+        NewObject<UHierarchicalInstancedStaticMeshComponent>(this, NAME_None, RF_Transient);
+    Component->SetupAttachment(RootComponent);
+
+    // Blueprints configure the template components, every chunk copies them.
+    Component->SetStaticMesh(Template->GetStaticMesh());
+    for (int32 i = 0; i < Template->GetNumMaterials(); i++)
+    {
+        Component->SetMaterial(i, Template->GetMaterial(i));
+    }
+    Component->BodyInstance.CopyBodyInstancePropertiesFrom(&Template->BodyInstance);
+    Component->SetGenerateOverlapEvents(Template->GetGenerateOverlapEvents());
+    Component->ComponentTags = Template->ComponentTags;
+    Component->SetCastShadow(Template->CastShadow);
+    Component->SetVisibility(false);
+
+    FTransform Transform = Template->GetRelativeTransform();
+    if (bParked)
+    {
+        Transform.AddToTranslation(ChunkParkingOffset);
+    }
+    Component->SetRelativeTransform(Transform);
+    Component->RegisterComponent();
+    return Component;
+}
+
+int32 ASnakeWorld::BuildChunk(FSnakeChunkSet& Set, int32 ChunkIndex)
+{
+    FSnakeWorldChunk& Chunk = Set.Chunks[ChunkIndex];
+    const FSnakeChunkBuild& Data = Set.Level->Chunks[ChunkIndex];
+    const FIntRect Bounds = Set.Level->GetChunkBounds(ChunkIndex);
+    Chunk.bBuilt = true;
+
+    if (Data.WallTransforms.Num() > 0 && !Chunk.Walls)
+    {
+        Chunk.Walls = CreateChunkComponent(InstancedWalls, Set.bParked);
+    }
+    if (Data.FloorTransforms.Num() > 0 && !Chunk.Floors)
+    {
+        Chunk.Floors = CreateChunkComponent(InstancedFloors, Set.bParked);
+    }
+
+    int32 NumChanged = 0;
+    if (Chunk.Walls)
+    {
+        NumChanged += ApplyInstanceDiff(Chunk.Walls, Data.WallTransforms, Bounds, InstanceDiffScratch);
+    }
+    if (Chunk.Floors)
+    {
+        NumChanged += ApplyInstanceDiff(Chunk.Floors, Data.FloorTransforms, Bounds, InstanceDiffScratch);
+    }
+    return NumChanged;
+}
 
-    if (!FFileHelper::LoadFileToStringArray(Lines, *FilePath))
+void ASnakeWorld::SetChunkSetParked(FSnakeChunkSet& Set, bool bParked)
+{
+    Set.bParked = bParked;
+    for (FSnakeWorldChunk& Chunk : Set.Chunks)
+    {
+        SetComponentParked(Chunk.Walls, InstancedWalls->GetRelativeTransform(), bParked);
+        SetComponentParked(Chunk.Floors, InstancedFloors->GetRelativeTransform(), bParked);
+        if (bParked)
+        {
+            Chunk.bVisible = false;
+        }
+    }
+}
+
+void ASnakeWorld::MarkChunksRelevant(const FBox2D& LocalBounds, int32 Margin)
+{
+    const int32 Size = FrontChunks.Level->ChunkSize;
+    const FIntPoint Origin = Grid.GetOrigin();
+    const auto ToChunk = [Size](double Position, int32 OriginCell)
+    {
+        return FMath::FloorToInt((FMath::FloorToInt(Position / TileSize + 0.5) - OriginCell) / float(Size));
+    };
+
+    const int32 MinX = ToChunk(LocalBounds.Min.X, Origin.X) - Margin;
+    const int32 MaxX = ToChunk(LocalBounds.Max.X, Origin.X) + Margin;
+    const int32 MinY = ToChunk(LocalBounds.Min.Y, Origin.Y) - Margin;
+    const int32 MaxY = ToChunk(LocalBounds.Max.Y, Origin.Y) + Margin;
+    if (MaxX < 0 || MaxY < 0 || MinX >= FrontChunks.NumChunksX || MinY >= FrontChunks.NumChunksY)
     {
-        UE_LOG(LogTemp, Error, TEXT("[LevelLoad] Failed to load file!"));
         return;
     }
-    UE_LOG(LogTemp, Warning, TEXT("[LevelLoad] Loaded %d lines"), Lines.Num());
-    
-    if (FFileHelper::LoadFileToStringArray(Lines, *FilePath))
+
+    for (int32 X = FMath::Max(MinX, 0); X <= FMath::Min(MaxX, FrontChunks.NumChunksX - 1); X++)
+    {
+        for (int32 Y = FMath::Max(MinY, 0); Y <= FMath::Min(MaxY, FrontChunks.NumChunksY - 1); Y++)
+        {
+            FrontChunks.Chunks[X * FrontChunks.NumChunksY + Y].RelevantFrame = RelevanceFrame;
+        }
+    }
+}
+
+void ASnakeWorld::UpdateChunkRelevance()
+{
+    UWorld* World = GetWorld();
+    if (!World || !FrontChunks.Level.IsValid() || FrontChunks.Chunks.Num() == 0)
+    {
+        return;
+    }
+    ++RelevanceFrame;
+
+    const FVector ActorLocation = GetActorLocation();
+
+    // Whatever any local camera can see of the ground plane.
+    for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
     {
-        int y = 0;
-        for (const FString& Line : Lines)
+        APlayerController* PC = It->Get();
+        if (!PC || !PC->IsLocalController() || !PC->PlayerCameraManager)
         {
-            for (int x = 0; x < Line.Len(); x++)
+            continue;
+        }
+
+        const FMinimalViewInfo& View = PC->PlayerCameraManager->GetCameraCacheView();
+        const FVector Camera = View.Location - ActorLocation;
+        const float Aspect = View.AspectRatio > 0.0f ? View.AspectRatio : 16.0f / 9.0f;
+
+        FBox2D Bounds(FVector2D(Camera), FVector2D(Camera));
+        if (View.ProjectionMode == ECameraProjectionMode::Orthographic)
+        {
+            // Square on the wider extent, we don't know how the view is rolled.
+            const double HalfExtent = View.OrthoWidth * 0.5;
+            Bounds = FBox2D(FVector2D(Camera) - HalfExtent, FVector2D(Camera) + HalfExtent);
+        }
+        else
+        {
+            const FRotationMatrix Rotation(View.Rotation);
+            const FVector Forward = Rotation.GetUnitAxis(EAxis::X);
+            const FVector Right = Rotation.GetUnitAxis(EAxis::Y);
+            const FVector Up = Rotation.GetUnitAxis(EAxis::Z);
+            const float TanHalfH = FMath::Tan(FMath::DegreesToRadians(View.FOV * 0.5f));
+            const float TanHalfV = TanHalfH / Aspect;
+
+            for (int32 Corner = 0; Corner < 4; Corner++)
             {
-                FTransform TileTransform(FRotator::ZeroRotator, FVector((Lines.Num() - y) * 100, x * 100, 0.0f));
-                
-                switch (Line[x])
+                const float SignH = (Corner & 1) ? 1.0f : -1.0f;
+                const float SignV = (Corner & 2) ? 1.0f : -1.0f;
+                const FVector Ray = Forward + Right * (SignH * TanHalfH) + Up * (SignV * TanHalfV);
+
+                FVector Hit = Camera + Ray.GetSafeNormal2D() * MaxChunkViewDistance;
+                if (Ray.Z < -KINDA_SMALL_NUMBER && Camera.Z > 0.0f)
                 {
-                    case '#':
-                        InstancedWalls->AddInstance(TileTransform);
-                        break;
-
-                    case 'O':
-                        break;
-
-                    case 'D':
-                        InstancedFloors->AddInstance(TileTransform);
-                        if (IsValid(DoorActor))
-                        {
-                            AActor* SpawnedActor = GetWorld()->SpawnActor<AActor>(DoorActor, TileTransform, FActorSpawnParameters());
-                            if (SpawnedActor)
-                            {
-                                SpawnedActor->AttachToActor(this, FAttachmentTransformRules::KeepRelativeTransform);
-                                SpawnedActors.Add(SpawnedActor);
-                            }
-                        }
-                        break;
-
-                    case '.':
-                        InstancedFloors->AddInstance(TileTransform);
-                        FloorTileLocations.Add(TileTransform.GetTranslation());
-                        break;
+                    const FVector GroundHit = Camera + Ray * (-Camera.Z / Ray.Z);
+                    if (FVector::Dist2D(GroundHit, Camera) < MaxChunkViewDistance)
+                    {
+                        Hit = GroundHit;
+                    }
                 }
+                Bounds += FVector2D(Hit);
             }
-            y++;
         }
-    } 
+        MarkChunksRelevant(Bounds, ChunkViewMargin);
+    }
+
+    // Snakes need their surroundings built even off screen, walls are what they collide with.
+    for (TActorIterator<ASnakePawn> It(World); It; ++It)
+    {
+        // At least one ring, a chunk still holding the previous level's walls must be rebuilt before a head gets there.
+        const FVector2D Head(It->GetActorLocation() - ActorLocation);
+        MarkChunksRelevant(FBox2D(Head, Head), FMath::Max(ChunkViewMargin, 1));
+    }
+
+    for (int32 i = 0; i < FrontChunks.Chunks.Num(); i++)
+    {
+        FSnakeWorldChunk& Chunk = FrontChunks.Chunks[i];
+        const bool bRelevant = Chunk.RelevantFrame == RelevanceFrame;
+        if (bRelevant && !Chunk.bBuilt)
+        {
+            BuildChunk(FrontChunks, i);
+        }
+        if (bRelevant != Chunk.bVisible)
+        {
+            // Hidden chunks drop out of rendering, their walls keep colliding.
+            if (Chunk.Walls) Chunk.Walls->SetVisibility(bRelevant);
+            if (Chunk.Floors) Chunk.Floors->SetVisibility(bRelevant);
+            Chunk.bVisible = bRelevant;
+        }
+    }
+}
+
+void ASnakeWorld::PrefetchLevel(int32 Index)
+{
+    if (PrefetchedLevelIndex == Index)
+    {
+        return;
+    }
+
+    PrefetchedLevelIndex = Index;
+    PrefetchTask = {};
+
+    if (!DoesLevelExist(Index))
+    {
+        return;
+    }
+
+    // Only the pack and the index go to the worker, never the actor.
+    TSharedPtr<const FSnakeLevelPack> Pack = GetLevelPackShared();
+    const int32 InChunkSize = ChunkSize;
+    PrefetchTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Pack, Index, InChunkSize]()
+    {
+        return BuildLevel(Pack, Index, InChunkSize);
+    });
+}
+
+void ASnakeWorld::FillBackBuffer(int32 InstanceBudget)
+{
+    if (PrefetchTask.IsValid() && PrefetchTask.IsCompleted())
+    {
+        TSharedPtr<FSnakeLevelBuild> Build = PrefetchTask.GetResult();
+        PrefetchTask = {};
+        if (Build.IsValid())
+        {
+            AssignLevelToChunkSet(BackChunks, Build, true);
+        }
+    }
+
+    if (!BackChunks.Level.IsValid())
+    {
+        return;
+    }
+
+    while (InstanceBudget > 0 && BackChunks.NextChunkToPrefill < BackChunks.Chunks.Num())
+    {
+        const int32 ChunkIndex = BackChunks.NextChunkToPrefill++;
+        if (!BackChunks.Chunks[ChunkIndex].bBuilt)
+        {
+            InstanceBudget -= BuildChunk(BackChunks, ChunkIndex);
+        }
+    }
+}
+
+void ASnakeWorld::SwapToLevel(int32 Index)
+{
+    if (PrefetchedLevelIndex == Index && PrefetchTask.IsValid())
+    {
+        // Transition came before the worker finished, wait for it rather than parse twice.
+        PrefetchTask.Wait();
+    }
+    if (PrefetchedLevelIndex == Index)
+    {
+        // Picks up a finished task; chunks the prefill didn't reach are built once they're in view.
+        FillBackBuffer(0);
+    }
+
+    if (!BackChunks.Level.IsValid() || BackChunks.Level->LevelIndex != Index)
+    {
+        LevelIndex = Index;
+        LoadLevelFromText();
+        return;
+    }
+
+    Swap(FrontChunks, BackChunks);
+    SetChunkSetParked(FrontChunks, false);
+    SetChunkSetParked(BackChunks, true);
+    BackChunks.NextChunkToPrefill = BackChunks.Chunks.Num();
+
+    DestroyDoors();
+    Grid = MoveTemp(FrontChunks.Level->Grid);
+    RebuildOccupancy();
+    LevelIndex = Index;
+    RequestNextHopTable(LevelIndex);
+    UpdateChunkRelevance();
+    SpawnDoors(FrontChunks.Level->DoorTransforms);
+
+    PrefetchLevel(LevelIndex + 1);
 }
 
 void ASnakeWorld::SpawnFood()
 {
-    if (!FoodClass || FloorTileLocations.Num() == 0)
+    if (!FoodClass)
         return;
-    
-    TSet<FVector> FloorSet(FloorTileLocations);
-    TArray<FVector> ValidSpawnTiles;
-    FVector Offsets[4] = {
-        FVector(TileSize,  0,       0),
-        FVector(-TileSize, 0,       0),
-        FVector(0,        TileSize, 0),
-        FVector(0,       -TileSize, 0)
-    };
 
-    for (const FVector& Loc : FloorTileLocations)
+    // Constant time no matter the level size; prefers tiles with floor on all four sides.
+    const int32 Chosen = FreeCells.Sample(FoodRandom);
+    if (Chosen == INDEX_NONE)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("No free tile left to spawn food on"));
+        return;
+    }
+
+    const FIntPoint Cell = Grid.ToCell(Chosen);
+    AActor* Food = GetWorld()->SpawnActor<AActor>(FoodClass, GridCellToWorld(Cell), FRotator::ZeroRotator);
+    if (Food)
+    {
+        Grid.SetFood(Cell, true);
+        FreeCells.Remove(Chosen);
+        FoodIndex.Add(Chosen);
+        FoodActors.Add(Food);
+        bFlowFieldDirty = true;
+        Food->OnDestroyed.AddDynamic(this, &ASnakeWorld::OnFoodDestroyed);
+    }
+}
+
+void ASnakeWorld::OnFoodDestroyed(AActor* DestroyedActor)
+{
+    FoodActors.Remove(DestroyedActor);
+
+    const FIntPoint Cell = WorldToGridCell(DestroyedActor->GetActorLocation());
+    Grid.SetFood(Cell, false);
+    FoodIndex.Remove(Grid.ToIndex(Cell));
+    RefreshFreeCell(Cell);
+}
+
+void ASnakeWorld::OccupyCell(const FVector& WorldLocation)
+{
+    const FIntPoint Cell = WorldToGridCell(WorldLocation);
+    if (Grid.AddOccupant(Cell))
     {
-        bool bSurrounded = true;
-        for (auto& Offset : Offsets)
+        RefreshFreeCell(Cell);
+    }
+}
+
+void ASnakeWorld::ReleaseCell(const FVector& WorldLocation)
+{
+    const FIntPoint Cell = WorldToGridCell(WorldLocation);
+    if (Grid.RemoveOccupant(Cell))
+    {
+        RefreshFreeCell(Cell);
+    }
+}
+
+void ASnakeWorld::RefreshFreeCell(const FIntPoint& Cell)
+{
+    const int32 Index = Grid.ToIndex(Cell);
+    if (Index == INDEX_NONE)
+    {
+        return;
+    }
+    bFlowFieldDirty = true;
+    GridJournal.Record(Index);
+
+    if (Grid.IsFreeAt(Index) && !Grid.HasFlagAt(Index, ESnakeCell::Food))
+    {
+        FreeCells.Add(Index);
+    }
+    else
+    {
+        FreeCells.Remove(Index);
+    }
+}
+
+void ASnakeWorld::RebuildOccupancy()
+{
+    if (UWorld* World = GetWorld())
+    {
+        // Pawns that haven't begun play yet occupy their tiles from their own BeginPlay.
+        for (TActorIterator<ASnakePawn> It(World); It; ++It)
         {
-            FVector Neigh = SnapToGrid(Loc + Offset);
-            if (!FloorSet.Contains(Neigh))
+            if (!It->HasActorBegunPlay())
+                continue;
+
+            Grid.AddOccupant(WorldToGridCell(It->LastTilePosition));
+            for (const FIntPoint& Tile : It->TailCells)
             {
-                bSurrounded = false;
-                break;
+                Grid.AddOccupant(WorldToGridCell(CellToWorld(Tile)));
             }
         }
 
-        if (bSurrounded)
-            ValidSpawnTiles.Add(Loc);
+        // The simulation plays on a copy of the grid, rebuilt before its next step
+        if (USnakeSimSubsystem* Sim = World->GetSubsystem<USnakeSimSubsystem>())
+        {
+            Sim->SetBoard(*this);
+        }
     }
-    
-    const TArray<FVector>& Pool = (ValidSpawnTiles.Num() > 0)
-        ? ValidSpawnTiles
-        : FloorTileLocations;
-    
-    int32 Index = FMath::RandRange(0, Pool.Num() - 1);
-    FVector Chosen = Pool[Index];
-    FVector SpawnLocation = GetActorLocation() + Chosen;
-    GetWorld()->SpawnActor<AActor>(FoodClass, SpawnLocation, FRotator::ZeroRotator);
+
+    FoodActors.RemoveAll([](const TWeakObjectPtr<AActor>& Food) { return !Food.IsValid(); });
+    FoodIndex.Init(Grid.GetSizeX(), Grid.GetSizeY());
+    for (const TWeakObjectPtr<AActor>& Food : FoodActors)
+    {
+        const FIntPoint Cell = WorldToGridCell(Food->GetActorLocation());
+        Grid.SetFood(Cell, true);
+        FoodIndex.Add(Grid.ToIndex(Cell));
+    }
+
+    FreeCells.Init(Grid);
+    GridJournal.Invalidate();
+    ClusterGraph.Reset();
+    bFlowFieldDirty = true;
+    GridSnapshotStep = MAX_uint64;
+}
+
+bool ASnakeWorld::FindSpawnCell(FIntPoint& OutCell)
+{
+    const int32 Index = FreeCells.Sample(FoodRandom);
+    if (Index == INDEX_NONE)
+    {
+        return false;
+    }
+    OutCell = Grid.ToCell(Index);
+    return true;
+}
+
+void ASnakeWorld::GetFoodCells(TArray<int32>& OutCells) const
+{
+    const TConstArrayView<int32> Cells = FoodIndex.GetCells();
+    OutCells.Reset();
+    OutCells.Append(Cells.GetData(), Cells.Num());
+}
+
+AActor* ASnakeWorld::FindFoodAt(const FVector& WorldLocation) const
+{
+    const FIntPoint Cell = WorldToGridCell(WorldLocation);
+    if (!Grid.HasFood(Cell))
+    {
+        return nullptr;
+    }
+
+    // Only a handful of apples are ever out, the grid already said one is here
+    for (const TWeakObjectPtr<AActor>& Food : FoodActors)
+    {
+        if (Food.IsValid() && WorldToGridCell(Food->GetActorLocation()) == Cell)
+        {
+            return Food.Get();
+        }
+    }
+    return nullptr;
+}
+
+FSnakeClusterGraph& ASnakeWorld::GetClusterGraph()
+{
+    if (!ClusterGraph.IsBuiltFor(Grid))
+    {
+        ClusterGraph.Build(Grid, GridJournal);
+    }
+    return ClusterGraph;
+}
+
+const FSnakeFlowField& ASnakeWorld::GetFlowField()
+{
+    // Snakes decide at the start of a simulation step, one rebuild per step is enough as the
+    // field users check the live grid for the cells next to them.
+    const uint64 Step = GetSimStep();
+    if (bFlowFieldDirty && (FlowFieldStep != Step || !FlowField.IsBuilt()))
+    {
+        FlowField.Build(Grid, FoodIndex.GetCells(), bFlowFieldAvoidsSnakes);
+        bFlowFieldDirty = false;
+        FlowFieldStep = Step;
+    }
+    return FlowField;
+}
+
+TSharedRef<const FSnakeGrid> ASnakeWorld::GetGridSnapshot()
+{
+    const uint64 Step = GetSimStep();
+    if (GridSnapshot.IsValid() && GridSnapshotStep == Step)
+    {
+        return GridSnapshot.ToSharedRef();
+    }
+    GridSnapshotStep = Step;
+
+    // Plans still running keep the last one alive, otherwise its memory is reused
+    if (!GridSnapshot.IsValid() || !GridSnapshot.IsUnique())
+    {
+        GridSnapshot = MakeShared<FSnakeGrid>();
+    }
+    *GridSnapshot = Grid;
+    return GridSnapshot.ToSharedRef();
 }
 
+const FSnakeReservationTable& ASnakeWorld::GetReservations()
+{
+    // Bodies only move when the simulation steps
+    const uint64 Step = GetSimStep();
+    if (ReservationStep == Step)
+    {
+        return Reservations;
+    }
+    ReservationStep = Step;
+    Reservations.Reset(Grid.Num());
+
+    if (UWorld* World = GetWorld())
+    {
+        for (TActorIterator<ASnakePawn> It(World); It; ++It)
+        {
+            const ASnakePawn& Snake = **It;
+            if (!Snake.HasActorBegunPlay())
+                continue;
+
+            const int32 Head = Grid.ToIndex(WorldToGridCell(Snake.LastTilePosition));
+            if (Head == INDEX_NONE)
+                continue;
+
+            ReservationBody.Reset();
+            ReservationBody.Add(Head);
+            for (const FIntPoint& Tile : Snake.TailCells)
+            {
+                ReservationBody.Add(Grid.ToIndex(WorldToGridCell(CellToWorld(Tile))));
+            }
+            Reservations.AddBody(ReservationBody);
+
+            // A published path is good from the cell the head is on now; a snake that left it gets a guess
+            const int32 Owner = int32(Snake.GetUniqueID());
+            TArray<int32>* Path = PlannedPaths.Find(MakeWeakObjectPtr(&Snake));
+            const int32 Progress = Path ? Path->Find(Head) : INDEX_NONE;
+            if (Progress != INDEX_NONE)
+            {
+                Path->RemoveAt(0, Progress, EAllowShrinking::No);
+                Reservations.Reserve(*Path, Owner);
+            }
+            else
+            {
+                if (Path)
+                {
+                    PlannedPaths.Remove(MakeWeakObjectPtr(&Snake));
+                }
+                const int32 Direction = Snake.Direction != ESnakeDirection::None ? int32(Snake.Direction) : INDEX_NONE;
+                Reservations.ReserveAhead(Grid, Head, Direction, Owner, ReservationGuessSteps);
+            }
+        }
+    }
+
+    for (auto It = PlannedPaths.CreateIterator(); It; ++It)
+    {
+        if (!It->Key.IsValid())
+        {
+            It.RemoveCurrent();
+        }
+    }
+    return Reservations;
+}
+
+uint64 ASnakeWorld::GetSimStep() const
+{
+    const UWorld* World = GetWorld();
+    const USnakeSimSubsystem* Sim = World ? World->GetSubsystem<USnakeSimSubsystem>() : nullptr;
+    return Sim ? Sim->GetStepCount() : GFrameCounter;
+}
+
+void ASnakeWorld::ReservePath(const ASnakePawn& Snake, TConstArrayView<int32> Path)
+{
+    // Into the current table as well, snakes planning later in this step should see it
+    GetReservations();
+    const int32 Owner = int32(Snake.GetUniqueID());
+
+    // No move found still means the head goes somewhere, and releasing its claims would let others plan into it
+    if (Path.Num() < 2)
+    {
+        PlannedPaths.Remove(MakeWeakObjectPtr(&Snake));
+        const int32 Head = Path.Num() > 0 ? Path[0] : Grid.ToIndex(WorldToGridCell(Snake.LastTilePosition));
+        const int32 Direction = Snake.Direction != ESnakeDirection::None ? int32(Snake.Direction) : INDEX_NONE;
+        Reservations.ReserveAhead(Grid, Head, Direction, Owner, ReservationGuessSteps);
+        return;
+    }
+    Reservations.Reserve(Path, Owner);
+
+    TArray<int32>& Planned = PlannedPaths.FindOrAdd(MakeWeakObjectPtr(&Snake));
+    Planned.Reset();
+    Planned.Append(Path.GetData(), FMath::Min(Path.Num(), FSnakeReservationTable::MaxSteps + 1));
+}
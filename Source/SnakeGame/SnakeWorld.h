@@ -1,10 +1,87 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Definitions.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
 #include "Components/InstancedStaticMeshComponent.h"
 #include "GameFramework/Actor.h"
+#include "SnakeClusterGraph.h"
+#include "SnakeFlowField.h"
+#include "SnakeFoodIndex.h"
+#include "SnakeFreeCellIndex.h"
+#include "SnakeGrid.h"
+#include "SnakeGridJournal.h"
+#include "SnakeLevelPack.h"
+#include "SnakeNextHopTable.h"
+#include "SnakeReservationTable.h"
+#include "Tasks/Task.h"
 #include "SnakeWorld.generated.h"
 
+class ASnakePawn;
+
+struct FSnakeChunkBuild
+{
+	TArray<FTransform> WallTransforms;
+	// Floors and doors, doors are rendered as floor tiles.
+	TArray<FTransform> FloorTransforms;
+};
+
+/** A level ready to be handed to the instanced components, built off the game thread. */
+struct FSnakeLevelBuild
+{
+	int32 LevelIndex = 0;
+	int32 ChunkSize = 0;
+	int32 NumChunksX = 0;
+	int32 NumChunksY = 0;
+	FIntPoint GridOrigin = FIntPoint::ZeroValue;
+	TArray<FSnakeChunkBuild> Chunks;
+	TArray<FTransform> DoorTransforms;
+	FSnakeGrid Grid;
+
+	/** Cells covered by a chunk, Max is exclusive. */
+	FIntRect GetChunkBounds(int32 ChunkIndex) const
+	{
+		const FIntPoint Min = GridOrigin + FIntPoint((ChunkIndex / NumChunksY) * ChunkSize, (ChunkIndex % NumChunksY) * ChunkSize);
+		return FIntRect(Min, Min + FIntPoint(ChunkSize, ChunkSize));
+	}
+};
+
+/** One square block of the level with its own hierarchical instanced components. */
+USTRUCT()
+struct FSnakeWorldChunk
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	UHierarchicalInstancedStaticMeshComponent* Walls = nullptr;
+
+	UPROPERTY()
+	UHierarchicalInstancedStaticMeshComponent* Floors = nullptr;
+
+	bool bBuilt = false;
+	bool bVisible = false;
+	uint32 RelevantFrame = 0;
+};
+
+/** All chunks of one loaded level. The world keeps a front set on screen and a back set for prefetching. */
+USTRUCT()
+struct FSnakeChunkSet
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FSnakeWorldChunk> Chunks;
+
+	// Kept alive so chunks can be built the first time they come into view. Chunks that aren't
+	// built yet may still hold the previous level's instances, building diffs against them.
+	TSharedPtr<FSnakeLevelBuild> Level;
+
+	int32 NumChunksX = 0;
+	int32 NumChunksY = 0;
+	int32 NextChunkToPrefill = 0;
+	bool bParked = false;
+};
+
 UCLASS()
 class SNAKEGAME_API ASnakeWorld : public AActor
 {
@@ -16,6 +93,8 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
 	USceneComponent* SceneComponent;
 	
+	// In game these are only templates (mesh, materials, collision) for the chunk components;
+	// the editor preview still draws the whole level through them.
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
 	UInstancedStaticMeshComponent* InstancedWalls;
 	
@@ -30,6 +109,10 @@ public:
 	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Food")
 	float FoodSpawnDelay = 0.5f;
+
+	// Seed for picking food cells, 0 picks a new one every play.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Food")
+	int32 FoodRandomSeed = 0;
 	
 	UPROPERTY()
 	TArray<AActor*> SpawnedActors;
@@ -44,17 +127,193 @@ public:
 	
 	UFUNCTION(BlueprintCallable, Category="Level")
 	void LoadLevelFromText();
+
+	/** Grid and chunked instance transforms for a parsed level. Thread safe, touches nothing of the world. */
+	static TSharedPtr<FSnakeLevelBuild> BuildLevel(const FSnakeLevelView& Level, int32 Index, int32 InChunkSize);
 	
 	UFUNCTION(BlueprintCallable, Category="Level")
 	bool DoesLevelExist(int32 Index) const;
 
+	/** Switches to another level, using the prefetched back buffer when it holds that level. */
+	UFUNCTION(BlueprintCallable, Category="Level")
+	void SwapToLevel(int32 Index);
+
+	/** Starts parsing a level on a worker; the result is uploaded into the back buffer over the next frames. */
+	UFUNCTION(BlueprintCallable, Category="Level")
+	void PrefetchLevel(int32 Index);
+
+	// How many instances may be added to the back buffer per frame while prefetching.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Level")
+	int32 PrefetchInstancesPerFrame = 2000;
+
+	// Side length of a render chunk in tiles.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Level|Chunks", meta=(ClampMin="4"))
+	int32 ChunkSize = 32;
+
+	// Extra ring of chunks kept around the camera view and around every snake head.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Level|Chunks", meta=(ClampMin="0"))
+	int32 ChunkViewMargin = 1;
+
+	// How far along the ground a camera looking at the horizon can see.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Level|Chunks")
+	float MaxChunkViewDistance = 20000.0f;
+
 protected:
 	virtual void BeginPlay() override;
 	
 
 public:    
 	virtual void Tick(float DeltaTime) override;
-	const TArray<FVector>& GetFloorTileLocations() const { return FloorTileLocations; }
-	TArray<FVector> FloorTileLocations;
-	
-};
+
+	const FSnakeGrid& GetGrid() const { return Grid; }
+	FSnakeGrid& GetGrid() { return Grid; }
+
+	// Grid cells are relative to this actor.
+	FIntPoint WorldToGridCell(const FVector& WorldLocation) const { return WorldToCell(WorldLocation - GetActorLocation()); }
+	FVector GridCellToWorld(const FIntPoint& Cell, float Z = 0.0f) const { return GetActorLocation() + CellToWorld(Cell, Z); }
+
+	// Snake parts report every tile they enter and leave, this keeps the grid occupancy and the food cells in sync.
+	void OccupyCell(const FVector& WorldLocation);
+	void ReleaseCell(const FVector& WorldLocation);
+
+	int32 GetNumFreeCells() const { return FreeCells.Num(); }
+
+	/** A random free cell to spawn something on, false when the board is full. */
+	bool FindSpawnCell(FIntPoint& OutCell);
+
+	/** Grid indices of all food currently spawned. */
+	void GetFoodCells(TArray<int32>& OutCells) const;
+
+	/** The food on WorldLocation's tile, null if the grid has none there. */
+	AActor* FindFoodAt(const FVector& WorldLocation) const;
+
+	/** First moves between all walkable cells of the current level, null until built or when disabled. */
+	TSharedPtr<const FSnakeNextHopTable> GetNextHopTable() const { return NextHopTable; }
+
+	// Build a next hop table for levels up to NextHopMaxCells walkable cells, cached next to the level as LevelN.nexthop.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	bool bBuildNextHopTable = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI", meta=(ClampMin="1", EditCondition="bBuildNextHopTable"))
+	int32 NextHopMaxCells = 4096;
+
+	/** Entrance graph for hierarchical searches. Built the first time it is asked for after a level loads; game thread only. */
+	FSnakeClusterGraph& GetClusterGraph();
+
+	/** Cells whose free state changed, for searches that repair themselves between tiles. */
+	const FSnakeGridJournal& GetGridJournal() const { return GridJournal; }
+
+	/** Spawned food by grid cell, kept up to date as food spawns and gets eaten. */
+	const FSnakeFoodIndex& GetFoodIndex() const { return FoodIndex; }
+
+	/** Distances to the nearest food, shared by all AI snakes. Rebuilt at most once per simulation step when the board changed. */
+	const FSnakeFlowField& GetFlowField();
+
+	// When set, snake bodies block the flow field; otherwise only walls do and snakes avoid bodies next to them.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	bool bFlowFieldAvoidsSnakes = true;
+
+	/** Copy of the grid for searches off the game thread, taken once per simulation step and shared by every snake planning in it. */
+	TSharedRef<const FSnakeGrid> GetGridSnapshot();
+
+	/** When every snake's body frees its cells and where the heads are expected, rebuilt once per simulation step. Game thread only. */
+	const FSnakeReservationTable& GetReservations();
+
+	/**
+	 * Where Snake's head is going, Path[0] being its cell now. Kept over the next frames until the snake strays from it.
+	 * A path without a move reserves the same guess as for snakes that don't publish one.
+	 */
+	void ReservePath(const ASnakePawn& Snake, TConstArrayView<int32> Path);
+
+	// Tiles ahead reserved for snakes that don't publish a path (players, AI in other modes): any turn, then straight on.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI", meta=(ClampMin="1"))
+	int32 ReservationGuessSteps = 3;
+
+private:
+	FSnakeGrid Grid;
+	FSnakeGridJournal GridJournal;
+
+	// Cells food can spawn on, updated on every occupancy or food change.
+	FSnakeFreeCellIndex FreeCells;
+	FRandomStream FoodRandom;
+
+	UPROPERTY(Transient)
+	TArray<TWeakObjectPtr<AActor>> FoodActors;
+
+	FSnakeFoodIndex FoodIndex;
+
+	UFUNCTION()
+	void OnFoodDestroyed(AActor* DestroyedActor);
+
+	void RefreshFreeCell(const FIntPoint& Cell);
+
+	FSnakeClusterGraph ClusterGraph;
+
+	FSnakeFlowField FlowField;
+	bool bFlowFieldDirty = true;
+	uint64 FlowFieldStep = MAX_uint64;
+
+	TSharedPtr<FSnakeGrid> GridSnapshot;
+	uint64 GridSnapshotStep = MAX_uint64;
+
+	FSnakeReservationTable Reservations;
+	uint64 ReservationStep = MAX_uint64;
+	TArray<int32> ReservationBody;
+
+	// Number of the current simulation step, what the flow field, grid snapshot and reservations are cached by.
+	uint64 GetSimStep() const;
+
+	// Published paths, trimmed to the head's cell on every rebuild.
+	TMap<TWeakObjectPtr<const ASnakePawn>, TArray<int32>> PlannedPaths;
+
+	// Re-applies snakes and food to a freshly loaded grid and rebuilds the free cells from it.
+	void RebuildOccupancy();
+
+	// Compiled levels, see USnakeLevelPackCommandlet. Opened on first use, null if there is no pack.
+	const FSnakeLevelPack* GetLevelPack() const;
+
+	TSharedPtr<const FSnakeLevelPack> GetLevelPackShared() const;
+
+	static FString GetLevelTextPath(int32 Index);
+
+	// Thread safe, runs on workers for prefetching and on the game thread for direct loads.
+	static TSharedPtr<FSnakeLevelBuild> BuildLevel(const TSharedPtr<const FSnakeLevelPack>& Pack, int32 Index, int32 InChunkSize);
+
+	void ApplyLevelBuild(const TSharedPtr<FSnakeLevelBuild>& Build);
+	void ApplyEditorPreview(const FSnakeLevelBuild& Build);
+	void SpawnDoors(const TArray<FTransform>& DoorTransforms);
+	void DestroyDoors();
+
+	void AssignLevelToChunkSet(FSnakeChunkSet& Set, const TSharedPtr<FSnakeLevelBuild>& Build, bool bParked);
+	int32 BuildChunk(FSnakeChunkSet& Set, int32 ChunkIndex);
+	UHierarchicalInstancedStaticMeshComponent* CreateChunkComponent(UInstancedStaticMeshComponent* Template, bool bParked);
+	void SetChunkSetParked(FSnakeChunkSet& Set, bool bParked);
+	void UpdateChunkRelevance();
+	void MarkChunksRelevant(const FBox2D& LocalBounds, int32 Margin);
+
+	void FillBackBuffer(int32 InstanceBudget);
+
+	mutable TSharedPtr<const FSnakeLevelPack> LevelPack;
+	mutable bool bTriedOpeningLevelPack = false;
+
+	UPROPERTY(Transient)
+	FSnakeChunkSet FrontChunks;
+
+	UPROPERTY(Transient)
+	FSnakeChunkSet BackChunks;
+
+	uint32 RelevanceFrame = 0;
+
+	// Reused by the instance diff, one slot per cell of the chunk being built.
+	TArray<int32> InstanceDiffScratch;
+
+	UE::Tasks::TTask<TSharedPtr<FSnakeLevelBuild>> PrefetchTask;
+	int32 PrefetchedLevelIndex = INDEX_NONE;
+
+	// Loads or builds the next hop table of the current level on a worker, picked up in Tick.
+	void RequestNextHopTable(int32 Index);
+	static FString GetNextHopCachePath(int32 Index);
+
+	TSharedPtr<const FSnakeNextHopTable> NextHopTable;
+	UE::Tasks::TTask<TSharedPtr<FSnakeNextHopTable>> NextHopTask;
+};
\ No newline at end of file
@@ -0,0 +1,211 @@
+#include "SnakeBitboard.h"
+
+#include "SnakeGrid.h"
+#include "SnakeGridJournal.h"
+
+namespace SnakeBitboard
+{
+    // Spreads Seeds towards the high bits through runs of Free. Doubling steps, so a run of any
+    // length inside the word is covered in six.
+    uint64 FillUp(uint64 Seeds, uint64 Free)
+    {
+        uint64 Filled = Seeds & Free;
+        uint64 Pass = Free;
+        Filled |= Pass & (Filled << 1);
+        Pass &= Pass << 1;
+        Filled |= Pass & (Filled << 2);
+        Pass &= Pass << 2;
+        Filled |= Pass & (Filled << 4);
+        Pass &= Pass << 4;
+        Filled |= Pass & (Filled << 8);
+        Pass &= Pass << 8;
+        Filled |= Pass & (Filled << 16);
+        Pass &= Pass << 16;
+        Filled |= Pass & (Filled << 32);
+        return Filled;
+    }
+
+    uint64 FillDown(uint64 Seeds, uint64 Free)
+    {
+        uint64 Filled = Seeds & Free;
+        uint64 Pass = Free;
+        Filled |= Pass & (Filled >> 1);
+        Pass &= Pass >> 1;
+        Filled |= Pass & (Filled >> 2);
+        Pass &= Pass >> 2;
+        Filled |= Pass & (Filled >> 4);
+        Pass &= Pass >> 4;
+        Filled |= Pass & (Filled >> 8);
+        Pass &= Pass >> 8;
+        Filled |= Pass & (Filled >> 16);
+        Pass &= Pass >> 16;
+        Filled |= Pass & (Filled >> 32);
+        return Filled;
+    }
+}
+
+void FSnakeBitboard::Build(const FSnakeGrid& Grid)
+{
+    SizeX = Grid.GetSizeX();
+    SizeY = Grid.GetSizeY();
+    WordsPerRow = (SizeY + 63) >> 6;
+
+    // Bits past the end of a row stay clear, so fills never run into the next row.
+    Free.Init(0, SizeX * WordsPerRow);
+    Reach.Init(0, SizeX * WordsPerRow);
+    for (int32 Index = 0; Index < Grid.Num(); Index++)
+    {
+        if (Grid.IsFreeAt(Index))
+        {
+            SetFree(Index, true);
+        }
+    }
+}
+
+void FSnakeBitboard::Sync(const FSnakeGrid& Grid, const FSnakeGridJournal& Journal)
+{
+    TConstArrayView<int32> Changed;
+    if (SizeX != Grid.GetSizeX() || SizeY != Grid.GetSizeY() || !Journal.GetChangesSince(Serial, Changed))
+    {
+        Build(Grid);
+    }
+    else
+    {
+        for (const int32 Index : Changed)
+        {
+            SetFree(Index, Grid.IsFreeAt(Index));
+        }
+    }
+    Serial = Journal.GetSerial();
+}
+
+void FSnakeBitboard::SetFree(int32 Index, bool bFree)
+{
+    const int32 Column = Index % SizeY;
+    uint64& Word = Free[(Index / SizeY) * WordsPerRow + (Column >> 6)];
+    const uint64 Bit = uint64(1) << (Column & 63);
+    Word = bFree ? Word | Bit : Word & ~Bit;
+}
+
+bool FSnakeBitboard::IsNextToReached(int32 Index) const
+{
+    if (Index < 0 || Index >= SizeX * SizeY)
+    {
+        return false;
+    }
+    const int32 Column = Index % SizeY;
+    return (Index >= SizeY && IsReached(Index - SizeY))
+        || (Index + SizeY < SizeX * SizeY && IsReached(Index + SizeY))
+        || (Column > 0 && IsReached(Index - 1))
+        || (Column + 1 < SizeY && IsReached(Index + 1));
+}
+
+int32 FSnakeBitboard::FillFrom(int32 Start, int32 Limit)
+{
+    FMemory::Memzero(Reach.GetData(), Reach.Num() * sizeof(uint64));
+    if (!IsFree(Start))
+    {
+        return 0;
+    }
+
+    const int32 StartRow = Start / SizeY;
+    const int32 StartColumn = Start % SizeY;
+    Reach[StartRow * WordsPerRow + (StartColumn >> 6)] = uint64(1) << (StartColumn & 63);
+    FillRow(StartRow);
+
+    // Rows outside [FirstRow, LastRow] haven't been reached, the sweeps don't need to look at them.
+    int32 FirstRow = StartRow;
+    int32 LastRow = StartRow;
+    int32 Count = CountReached(FirstRow, LastRow);
+
+    bool bChanged = true;
+    while (bChanged && Count < Limit)
+    {
+        bChanged = false;
+
+        // Up the rows, each one grown from the row below it as it is now, so a straight corridor is a single sweep.
+        for (int32 Row = FirstRow + 1; Row < SizeX; Row++)
+        {
+            if (GrowRow(Row, Row - 1))
+            {
+                bChanged = true;
+                LastRow = FMath::Max(LastRow, Row);
+            }
+            else if (Row > LastRow)
+            {
+                break;
+            }
+        }
+        for (int32 Row = LastRow - 1; Row >= 0; Row--)
+        {
+            if (GrowRow(Row, Row + 1))
+            {
+                bChanged = true;
+                FirstRow = FMath::Min(FirstRow, Row);
+            }
+            else if (Row < FirstRow)
+            {
+                break;
+            }
+        }
+
+        if (bChanged)
+        {
+            Count = CountReached(FirstRow, LastRow);
+        }
+    }
+    return Count;
+}
+
+void FSnakeBitboard::FillRow(int32 Row)
+{
+    using namespace SnakeBitboard;
+
+    uint64* ReachRow = Reach.GetData() + Row * WordsPerRow;
+    const uint64* FreeRow = Free.GetData() + Row * WordsPerRow;
+
+    // Towards higher columns, carrying the top bit into the next word, then back down the same way.
+    uint64 Carry = 0;
+    for (int32 Word = 0; Word < WordsPerRow; Word++)
+    {
+        ReachRow[Word] = FillUp(ReachRow[Word] | Carry, FreeRow[Word]);
+        Carry = ReachRow[Word] >> 63;
+    }
+    Carry = 0;
+    for (int32 Word = WordsPerRow - 1; Word >= 0; Word--)
+    {
+        ReachRow[Word] = FillDown(ReachRow[Word] | Carry, FreeRow[Word]);
+        Carry = ReachRow[Word] << 63;
+    }
+}
+
+bool FSnakeBitboard::GrowRow(int32 Row, int32 FromRow)
+{
+    uint64* ReachRow = Reach.GetData() + Row * WordsPerRow;
+    const uint64* FromReach = Reach.GetData() + FromRow * WordsPerRow;
+    const uint64* FreeRow = Free.GetData() + Row * WordsPerRow;
+
+    uint64 NewCells = 0;
+    for (int32 Word = 0; Word < WordsPerRow; Word++)
+    {
+        const uint64 Seeds = FromReach[Word] & FreeRow[Word] & ~ReachRow[Word];
+        ReachRow[Word] |= Seeds;
+        NewCells |= Seeds;
+    }
+    if (NewCells == 0)
+    {
+        return false;
+    }
+    FillRow(Row);
+    return true;
+}
+
+int32 FSnakeBitboard::CountReached(int32 FirstRow, int32 LastRow) const
+{
+    int32 Count = 0;
+    for (int32 Word = FirstRow * WordsPerRow; Word < (LastRow + 1) * WordsPerRow; Word++)
+    {
+        Count += FPlatformMath::CountBits(Reach[Word]);
+    }
+    return Count;
+}
@@ -0,0 +1,460 @@
+#include "SnakeClusterGraph.h"
+
+#include "Algo/BinarySearch.h"
+#include "Algo/Reverse.h"
+#include "Async/ParallelFor.h"
+#include "SnakeGrid.h"
+#include "SnakeGridJournal.h"
+
+namespace SnakeClusterGraph
+{
+    // Border runs at least this long get an entrance at both ends instead of one in the middle.
+    constexpr int32 WideEntrance = 6;
+
+    int32 GetManhattanDistance(int32 A, int32 B, int32 SizeY)
+    {
+        return FMath::Abs(A / SizeY - B / SizeY) + FMath::Abs(A % SizeY - B % SizeY);
+    }
+
+    struct FOpenNodeOrder
+    {
+        template <typename NodeType>
+        bool operator()(const NodeType& A, const NodeType& B) const
+        {
+            return A.Cost < B.Cost || (A.Cost == B.Cost && A.Distance > B.Distance);
+        }
+    };
+}
+
+void FSnakeClusterGraph::Build(const FSnakeGrid& Grid, const FSnakeGridJournal& Journal)
+{
+    using namespace SnakeClusterGraph;
+
+    Reset();
+    SizeX = Grid.GetSizeX();
+    SizeY = Grid.GetSizeY();
+    ClustersX = FMath::DivideAndRoundUp(SizeX, ClusterSize);
+    ClustersY = FMath::DivideAndRoundUp(SizeY, ClusterSize);
+    Clusters.SetNum(ClustersX * ClustersY);
+    for (int32 ClusterIndex = 0; ClusterIndex < Clusters.Num(); ClusterIndex++)
+    {
+        FCluster& Cluster = Clusters[ClusterIndex];
+        Cluster.Row = (ClusterIndex / ClustersY) * ClusterSize;
+        Cluster.Column = (ClusterIndex % ClustersY) * ClusterSize;
+        Cluster.NumRows = FMath::Min(ClusterSize, SizeX - Cluster.Row);
+        Cluster.NumColumns = FMath::Min(ClusterSize, SizeY - Cluster.Column);
+    }
+
+    // Entrances: runs of border cells walkable on both sides, by wall layout alone.
+    TArray<TArray<int32>> ClusterCells;
+    ClusterCells.SetNum(Clusters.Num());
+    TArray<TPair<int32, int32>> Pairs;
+    const auto AddRun = [&](int32 RunStart, int32 RunLength, int32 Step, int32 Across)
+    {
+        const auto AddPair = [&](int32 Inside)
+        {
+            const int32 Outside = Inside + Across;
+            ClusterCells[GetClusterOf(Inside)].Add(Inside);
+            ClusterCells[GetClusterOf(Outside)].Add(Outside);
+            Pairs.Emplace(Inside, Outside);
+        };
+        if (RunLength >= WideEntrance)
+        {
+            AddPair(RunStart);
+            AddPair(RunStart + (RunLength - 1) * Step);
+        }
+        else
+        {
+            AddPair(RunStart + (RunLength / 2) * Step);
+        }
+    };
+    const auto ScanBorder = [&](int32 First, int32 Count, int32 Step, int32 Across)
+    {
+        int32 RunStart = INDEX_NONE;
+        int32 RunLength = 0;
+        for (int32 i = 0; i < Count; i++)
+        {
+            const int32 Cell = First + i * Step;
+            if (Grid.IsWalkableAt(Cell) && Grid.IsWalkableAt(Cell + Across))
+            {
+                RunStart = RunLength == 0 ? Cell : RunStart;
+                RunLength++;
+            }
+            else if (RunLength > 0)
+            {
+                AddRun(RunStart, RunLength, Step, Across);
+                RunLength = 0;
+            }
+        }
+        if (RunLength > 0)
+        {
+            AddRun(RunStart, RunLength, Step, Across);
+        }
+    };
+    for (int32 ClusterIndex = 0; ClusterIndex < Clusters.Num(); ClusterIndex++)
+    {
+        const FCluster& Cluster = Clusters[ClusterIndex];
+        const int32 LastRow = Cluster.Row + Cluster.NumRows - 1;
+        const int32 LastColumn = Cluster.Column + Cluster.NumColumns - 1;
+        if (LastRow + 1 < SizeX)
+        {
+            ScanBorder(LastRow * SizeY + Cluster.Column, Cluster.NumColumns, 1, SizeY);
+        }
+        if (LastColumn + 1 < SizeY)
+        {
+            ScanBorder(Cluster.Row * SizeY + LastColumn, Cluster.NumRows, SizeY, 1);
+        }
+    }
+
+    for (int32 ClusterIndex = 0; ClusterIndex < Clusters.Num(); ClusterIndex++)
+    {
+        TArray<int32>& Cells = ClusterCells[ClusterIndex];
+        Cells.Sort();
+        Cells.SetNum(Algo::Unique(Cells));
+
+        FCluster& Cluster = Clusters[ClusterIndex];
+        Cluster.FirstNode = NodeCell.Num();
+        Cluster.NumNodes = Cells.Num();
+        NodeCell.Append(Cells);
+        for (int32 i = 0; i < Cells.Num(); i++)
+        {
+            NodeCluster.Add(ClusterIndex);
+        }
+    }
+
+    const auto FindNode = [this](int32 Cell)
+    {
+        const FCluster& Cluster = Clusters[GetClusterOf(Cell)];
+        const TConstArrayView<int32> Cells(NodeCell.GetData() + Cluster.FirstNode, Cluster.NumNodes);
+        return Cluster.FirstNode + Algo::BinarySearch(Cells, Cell);
+    };
+    LinkOffsets.Init(0, NodeCell.Num() + 1);
+    for (const TPair<int32, int32>& Pair : Pairs)
+    {
+        LinkOffsets[FindNode(Pair.Key) + 1]++;
+        LinkOffsets[FindNode(Pair.Value) + 1]++;
+    }
+    for (int32 Node = 0; Node < NodeCell.Num(); Node++)
+    {
+        LinkOffsets[Node + 1] += LinkOffsets[Node];
+    }
+    Links.SetNumUninitialized(LinkOffsets.Last());
+    TArray<int32> Fill(LinkOffsets.GetData(), NodeCell.Num());
+    for (const TPair<int32, int32>& Pair : Pairs)
+    {
+        const int32 A = FindNode(Pair.Key);
+        const int32 B = FindNode(Pair.Value);
+        Links[Fill[A]++] = B;
+        Links[Fill[B]++] = A;
+    }
+
+    // Distances inside every cluster, one batch of clusters per worker.
+    const int32 NumBatches = FMath::Max(FMath::Min(Clusters.Num(), FTaskGraphInterface::Get().GetNumWorkerThreads() + 1), 1);
+    ParallelFor(NumBatches, [this, &Grid, NumBatches](int32 Batch)
+    {
+        FLocalSearch Search;
+        const int32 First = Clusters.Num() * Batch / NumBatches;
+        const int32 Last = Clusters.Num() * (Batch + 1) / NumBatches;
+        for (int32 ClusterIndex = First; ClusterIndex < Last; ClusterIndex++)
+        {
+            RefineCluster(Grid, Clusters[ClusterIndex], Search);
+        }
+    });
+    Serial = Journal.GetSerial();
+
+    const int32 NumSearchNodes = NodeCell.Num() + 2;
+    Cost.SetNumUninitialized(NumSearchNodes);
+    Parent.SetNumUninitialized(NumSearchNodes);
+    Visited.Init(0, NumSearchNodes);
+    Generation = 0;
+
+    UE_LOG(LogTemp, Log, TEXT("[ClusterGraph] %d clusters, %d entrances, %d links"), Clusters.Num(), NodeCell.Num(), Links.Num() / 2);
+}
+
+void FSnakeClusterGraph::Reset()
+{
+    SizeX = SizeY = ClustersX = ClustersY = 0;
+    Clusters.Empty();
+    NodeCell.Empty();
+    NodeCluster.Empty();
+    LinkOffsets.Empty();
+    Links.Empty();
+    Cost.Empty();
+    Parent.Empty();
+    Visited.Empty();
+    Open.Empty();
+    Generation = 0;
+}
+
+void FSnakeClusterGraph::Sync(const FSnakeGridJournal& Journal)
+{
+    TConstArrayView<int32> Changed;
+    if (!Journal.GetChangesSince(Serial, Changed))
+    {
+        for (FCluster& Cluster : Clusters)
+        {
+            Cluster.bDirty = true;
+        }
+    }
+    else
+    {
+        for (const int32 Cell : Changed)
+        {
+            Clusters[GetClusterOf(Cell)].bDirty = true;
+        }
+    }
+    Serial = Journal.GetSerial();
+}
+
+void FSnakeClusterGraph::SearchCluster(const FSnakeGrid& Grid, const FCluster& Cluster, int32 From, FLocalSearch& Search) const
+{
+    const int32 NumCells = Cluster.NumRows * Cluster.NumColumns;
+    Search.Distance.Init(Unreachable, NumCells);
+    Search.Parent.SetNumUninitialized(NumCells);
+    Search.Queue.SetNumUninitialized(NumCells);
+
+    // From may be occupied, everything after it has to be free.
+    const int32 FromLocal = ToLocal(Cluster, From);
+    Search.Distance[FromLocal] = 0;
+    Search.Parent[FromLocal] = INDEX_NONE;
+    Search.Queue[0] = From;
+    int32 Head = 0;
+    int32 Tail = 1;
+    while (Head < Tail)
+    {
+        const int32 Cell = Search.Queue[Head++];
+        const int32 CellLocal = ToLocal(Cluster, Cell);
+        const int32 Row = Cell / SizeY;
+        const int32 Column = Cell % SizeY;
+        for (int32 Direction = 0; Direction < FSnakeGrid::NumDirections; Direction++)
+        {
+            const FIntPoint Offset = FSnakeGrid::GetDirectionOffset(Direction);
+            const int32 NextRow = Row + Offset.X;
+            const int32 NextColumn = Column + Offset.Y;
+            if (NextRow < Cluster.Row || NextRow >= Cluster.Row + Cluster.NumRows
+                || NextColumn < Cluster.Column || NextColumn >= Cluster.Column + Cluster.NumColumns)
+            {
+                continue;
+            }
+
+            const int32 Next = NextRow * SizeY + NextColumn;
+            const int32 NextLocal = ToLocal(Cluster, Next);
+            if (Search.Distance[NextLocal] == Unreachable && Grid.IsFreeAt(Next))
+            {
+                Search.Distance[NextLocal] = Search.Distance[CellLocal] + 1;
+                Search.Parent[NextLocal] = int16(CellLocal);
+                Search.Queue[Tail++] = Next;
+            }
+        }
+    }
+}
+
+void FSnakeClusterGraph::RefineCluster(const FSnakeGrid& Grid, FCluster& Cluster, FLocalSearch& Search) const
+{
+    Cluster.Distances.Init(Unreachable, Cluster.NumNodes * Cluster.NumNodes);
+    for (int32 From = 0; From < Cluster.NumNodes; From++)
+    {
+        // A covered entrance can't be walked through, it keeps no distances.
+        const int32 FromCell = NodeCell[Cluster.FirstNode + From];
+        if (!Grid.IsFreeAt(FromCell))
+        {
+            continue;
+        }
+
+        SearchCluster(Grid, Cluster, FromCell, Search);
+        for (int32 To = 0; To < Cluster.NumNodes; To++)
+        {
+            Cluster.Distances[From * Cluster.NumNodes + To] = Search.Distance[ToLocal(Cluster, NodeCell[Cluster.FirstNode + To])];
+        }
+    }
+    Cluster.bDirty = false;
+}
+
+void FSnakeClusterGraph::Relax(int32 Node, int32 From, uint32 Distance, int32 Goal)
+{
+    using namespace SnakeClusterGraph;
+
+    if (Visited[Node] == Generation && Cost[Node] <= Distance)
+    {
+        return;
+    }
+    Visited[Node] = Generation;
+    Cost[Node] = Distance;
+    Parent[Node] = From;
+
+    const int32 Cell = Node < NodeCell.Num() ? NodeCell[Node] : Goal;
+    Open.HeapPush({ Distance + GetManhattanDistance(Cell, Goal, SizeY), Distance, Node }, FOpenNodeOrder());
+}
+
+bool FSnakeClusterGraph::FindPath(const FSnakeGrid& Grid, const FSnakeGridJournal& Journal, int32 Start, int32 Goal, TArray<int32>& OutPath, int32 MaxSteps)
+{
+    using namespace SnakeClusterGraph;
+
+    OutPath.Reset();
+    NumExpanded = 0;
+    NumRefined = 0;
+    if (!IsBuiltFor(Grid) || Start < 0 || Start >= Grid.Num() || Goal < 0 || Goal >= Grid.Num())
+    {
+        return false;
+    }
+    Sync(Journal);
+
+    const int32 StartNode = NodeCell.Num();
+    const int32 GoalNode = StartNode + 1;
+    const FCluster& StartCluster = Clusters[GetClusterOf(Start)];
+    const FCluster& GoalCluster = Clusters[GetClusterOf(Goal)];
+
+    // How far the start and goal cells are from the entrances of their clusters.
+    SearchCluster(Grid, StartCluster, Start, Local);
+    StartDistance.SetNumUninitialized(StartCluster.NumNodes);
+    for (int32 i = 0; i < StartCluster.NumNodes; i++)
+    {
+        StartDistance[i] = Local.Distance[ToLocal(StartCluster, NodeCell[StartCluster.FirstNode + i])];
+    }
+    const uint16 DirectDistance = &StartCluster == &GoalCluster ? Local.Distance[ToLocal(StartCluster, Goal)] : Unreachable;
+
+    SearchCluster(Grid, GoalCluster, Goal, Local);
+    GoalDistance.SetNumUninitialized(GoalCluster.NumNodes);
+    for (int32 i = 0; i < GoalCluster.NumNodes; i++)
+    {
+        GoalDistance[i] = Local.Distance[ToLocal(GoalCluster, NodeCell[GoalCluster.FirstNode + i])];
+    }
+
+    if (++Generation == 0)
+    {
+        FMemory::Memzero(Visited.GetData(), Visited.Num() * sizeof(uint32));
+        Generation = 1;
+    }
+    Open.Reset();
+    Visited[StartNode] = Generation;
+    Cost[StartNode] = 0;
+    Parent[StartNode] = INDEX_NONE;
+    Open.HeapPush({ uint32(GetManhattanDistance(Start, Goal, SizeY)), 0, StartNode }, FOpenNodeOrder());
+
+    bool bFound = false;
+    while (Open.Num() > 0)
+    {
+        FOpenNode OpenNode;
+        Open.HeapPop(OpenNode, FOpenNodeOrder(), EAllowShrinking::No);
+        const int32 Node = OpenNode.Node;
+        if (OpenNode.Distance > Cost[Node])
+        {
+            continue;
+        }
+        if (Node == GoalNode)
+        {
+            bFound = true;
+            break;
+        }
+        NumExpanded++;
+
+        if (Node == StartNode)
+        {
+            for (int32 i = 0; i < StartCluster.NumNodes; i++)
+            {
+                if (StartDistance[i] != Unreachable)
+                {
+                    Relax(StartCluster.FirstNode + i, Node, StartDistance[i], Goal);
+                }
+            }
+            if (DirectDistance != Unreachable)
+            {
+                Relax(GoalNode, Node, DirectDistance, Goal);
+            }
+            continue;
+        }
+
+        FCluster& Cluster = Clusters[NodeCluster[Node]];
+        if (Cluster.bDirty)
+        {
+            RefineCluster(Grid, Cluster, Local);
+            NumRefined++;
+        }
+
+        const int32 From = Node - Cluster.FirstNode;
+        for (int32 To = 0; To < Cluster.NumNodes; To++)
+        {
+            const uint16 Step = Cluster.Distances[From * Cluster.NumNodes + To];
+            if (To != From && Step != Unreachable)
+            {
+                Relax(Cluster.FirstNode + To, Node, OpenNode.Distance + Step, Goal);
+            }
+        }
+        for (int32 Link = LinkOffsets[Node]; Link < LinkOffsets[Node + 1]; Link++)
+        {
+            if (Grid.IsFreeAt(NodeCell[Links[Link]]))
+            {
+                Relax(Links[Link], Node, OpenNode.Distance + 1, Goal);
+            }
+        }
+        if (&Cluster == &GoalCluster && GoalDistance[From] != Unreachable)
+        {
+            Relax(GoalNode, Node, OpenNode.Distance + GoalDistance[From], Goal);
+        }
+    }
+    if (!bFound)
+    {
+        return false;
+    }
+
+    AbstractPath.Reset();
+    for (int32 Node = GoalNode; Node != INDEX_NONE; Node = Parent[Node])
+    {
+        AbstractPath.Add(Node);
+    }
+    Algo::Reverse(AbstractPath);
+
+    // Walk the cells between consecutive nodes, only as far as the caller needs.
+    OutPath.Add(Start);
+    for (int32 i = 1; i < AbstractPath.Num() && OutPath.Num() < MaxSteps; i++)
+    {
+        const int32 Next = AbstractPath[i] == GoalNode ? Goal : NodeCell[AbstractPath[i]];
+        const int32 Current = OutPath.Last();
+        if (Next == Current)
+        {
+            continue;
+        }
+        if (GetClusterOf(Next) != GetClusterOf(Current))
+        {
+            // A link across a border, always one step.
+            OutPath.Add(Next);
+        }
+        else if (!AppendLocalPath(Grid, Current, Next, OutPath))
+        {
+            OutPath.Reset();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FSnakeClusterGraph::AppendLocalPath(const FSnakeGrid& Grid, int32 From, int32 To, TArray<int32>& OutPath)
+{
+    const FCluster& Cluster = Clusters[GetClusterOf(From)];
+    SearchCluster(Grid, Cluster, From, Local);
+    const int32 ToLocalIndex = ToLocal(Cluster, To);
+    if (Local.Distance[ToLocalIndex] == Unreachable)
+    {
+        return false;
+    }
+
+    const int32 First = OutPath.Num();
+    OutPath.AddUninitialized(Local.Distance[ToLocalIndex]);
+    for (int32 Cell = ToLocalIndex, i = OutPath.Num() - 1; i >= First; Cell = Local.Parent[Cell], i--)
+    {
+        OutPath[i] = (Cluster.Row + Cell / Cluster.NumColumns) * SizeY + Cluster.Column + Cell % Cluster.NumColumns;
+    }
+    return true;
+}
+
+SIZE_T FSnakeClusterGraph::GetAllocatedSize() const
+{
+    SIZE_T Size = Clusters.GetAllocatedSize() + NodeCell.GetAllocatedSize() + NodeCluster.GetAllocatedSize()
+        + LinkOffsets.GetAllocatedSize() + Links.GetAllocatedSize() + Cost.GetAllocatedSize() + Parent.GetAllocatedSize()
+        + Visited.GetAllocatedSize() + Open.GetAllocatedSize();
+    for (const FCluster& Cluster : Clusters)
+    {
+        Size += Cluster.Distances.GetAllocatedSize();
+    }
+    return Size;
+}
@@ -0,0 +1,75 @@
+#include "SnakeFlowField.h"
+
+#include "SnakeGrid.h"
+
+void FSnakeFlowField::Build(const FSnakeGrid& Grid, TConstArrayView<int32> Sources, bool bAvoidOccupied)
+{
+    const int32 NumCells = Grid.Num();
+    Distance.SetNumUninitialized(NumCells, EAllowShrinking::No);
+    Frontier.SetNumUninitialized(NumCells, EAllowShrinking::No);
+    FMemory::Memset(Distance.GetData(), 0xFF, NumCells * sizeof(uint32));
+
+    int32 Head = 0;
+    int32 Tail = 0;
+    for (const int32 Source : Sources)
+    {
+        if (Source != INDEX_NONE && Grid.IsWalkableAt(Source) && Distance[Source] == Unreachable)
+        {
+            Distance[Source] = 0;
+            Frontier[Tail++] = Source;
+        }
+    }
+
+    while (Head < Tail)
+    {
+        const int32 Current = Frontier[Head++];
+        const uint32 NextDistance = Distance[Current] + 1;
+        for (int32 Dir = 0; Dir < FSnakeGrid::NumDirections; Dir++)
+        {
+            const int32 Next = Grid.GetNeighbour(Current, Dir);
+            if (Next == INDEX_NONE || Distance[Next] != Unreachable)
+            {
+                continue;
+            }
+            if (bAvoidOccupied ? !Grid.IsFreeAt(Next) : !Grid.IsWalkableAt(Next))
+            {
+                continue;
+            }
+            Distance[Next] = NextDistance;
+            Frontier[Tail++] = Next;
+        }
+    }
+}
+
+void FSnakeFlowField::Reset()
+{
+    Distance.Empty();
+    Frontier.Empty();
+}
+
+int32 FSnakeFlowField::GetBestDirection(const FSnakeGrid& Grid, int32 Index, int32 ExcludedDirection) const
+{
+    if (!Distance.IsValidIndex(Index) || Distance.Num() != Grid.Num())
+    {
+        return INDEX_NONE;
+    }
+
+    int32 BestDirection = INDEX_NONE;
+    uint32 BestDistance = Unreachable;
+    for (int32 Dir = 0; Dir < FSnakeGrid::NumDirections; Dir++)
+    {
+        if (Dir == ExcludedDirection)
+        {
+            continue;
+        }
+
+        // The field may be a frame old, occupancy is checked against the live grid.
+        const int32 Next = Grid.GetNeighbour(Index, Dir);
+        if (Next != INDEX_NONE && Distance[Next] < BestDistance && Grid.IsFreeAt(Next))
+        {
+            BestDistance = Distance[Next];
+            BestDirection = Dir;
+        }
+    }
+    return BestDirection;
+}
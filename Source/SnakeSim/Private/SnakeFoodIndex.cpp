@@ -0,0 +1,132 @@
+#include "SnakeFoodIndex.h"
+
+void FSnakeFoodIndex::Init(int32 InSizeX, int32 InSizeY)
+{
+    SizeX = InSizeX;
+    SizeY = InSizeY;
+    BucketsX = (SizeX + BucketSize - 1) >> BucketShift;
+    BucketsY = (SizeY + BucketSize - 1) >> BucketShift;
+
+    Buckets.Reset();
+    Buckets.SetNum(BucketsX * BucketsY);
+    Cells.Reset();
+    Slots.Init(INDEX_NONE, SizeX * SizeY);
+}
+
+void FSnakeFoodIndex::Reset()
+{
+    SizeX = SizeY = BucketsX = BucketsY = 0;
+    Buckets.Empty();
+    Cells.Empty();
+    Slots.Empty();
+}
+
+void FSnakeFoodIndex::Add(int32 Index)
+{
+    if (!Slots.IsValidIndex(Index) || Slots[Index] != INDEX_NONE)
+    {
+        return;
+    }
+
+    Slots[Index] = Cells.Add(Index);
+    const int32 Bucket = ((Index / SizeY) >> BucketShift) * BucketsY + ((Index % SizeY) >> BucketShift);
+    Buckets[Bucket].Add(Index);
+}
+
+void FSnakeFoodIndex::Remove(int32 Index)
+{
+    if (!Contains(Index))
+    {
+        return;
+    }
+
+    const int32 Slot = Slots[Index];
+    const int32 Last = Cells.Pop(EAllowShrinking::No);
+    if (Last != Index)
+    {
+        Cells[Slot] = Last;
+        Slots[Last] = Slot;
+    }
+    Slots[Index] = INDEX_NONE;
+
+    const int32 Bucket = ((Index / SizeY) >> BucketShift) * BucketsY + ((Index % SizeY) >> BucketShift);
+    Buckets[Bucket].RemoveSingleSwap(Index, EAllowShrinking::No);
+}
+
+int32 FSnakeFoodIndex::FindNearest(int32 From) const
+{
+    if (Cells.Num() == 0 || !Slots.IsValidIndex(From))
+    {
+        return INDEX_NONE;
+    }
+
+    int32 Nearest = INDEX_NONE;
+    int32 NearestDistance = MAX_int32;
+
+    if (Cells.Num() <= LinearScanThreshold)
+    {
+        for (const int32 Cell : Cells)
+        {
+            const int32 Distance = GetDistance(From, Cell);
+            if (Distance < NearestDistance)
+            {
+                NearestDistance = Distance;
+                Nearest = Cell;
+            }
+        }
+        return Nearest;
+    }
+
+    const int32 CenterX = (From / SizeY) >> BucketShift;
+    const int32 CenterY = (From % SizeY) >> BucketShift;
+    const int32 MaxRing = FMath::Max(BucketsX, BucketsY);
+
+    for (int32 Ring = 0; Ring <= MaxRing; Ring++)
+    {
+        // Every cell in this ring is at least this far away along one axis.
+        if (Nearest != INDEX_NONE && (Ring - 1) * BucketSize + 1 > NearestDistance)
+        {
+            break;
+        }
+
+        for (int32 X = CenterX - Ring; X <= CenterX + Ring; X++)
+        {
+            if (X < 0 || X >= BucketsX)
+            {
+                continue;
+            }
+
+            // Full rows at the top and bottom of the ring, only the two ends in between.
+            const bool bEdgeRow = X == CenterX - Ring || X == CenterX + Ring;
+            const int32 StepY = bEdgeRow ? 1 : FMath::Max(Ring * 2, 1);
+            for (int32 Y = CenterY - Ring; Y <= CenterY + Ring; Y += StepY)
+            {
+                if (Y < 0 || Y >= BucketsY)
+                {
+                    continue;
+                }
+
+                for (const int32 Cell : Buckets[X * BucketsY + Y])
+                {
+                    const int32 Distance = GetDistance(From, Cell);
+                    if (Distance < NearestDistance)
+                    {
+                        NearestDistance = Distance;
+                        Nearest = Cell;
+                    }
+                }
+            }
+        }
+    }
+    return Nearest;
+}
+
+SIZE_T FSnakeFoodIndex::GetAllocatedSize() const
+{
+    SIZE_T Size = Buckets.GetAllocatedSize() + Cells.GetAllocatedSize() + Slots.GetAllocatedSize();
+    for (const auto& Bucket : Buckets)
+    {
+        Size += Bucket.GetAllocatedSize();
+    }
+    return Size;
+}
@@ -0,0 +1,105 @@
+#include "SnakeFreeCellIndex.h"
+
+#include "SnakeGrid.h"
+
+void FSnakeFreeCellIndex::FPool::Init(int32 NumGridCells)
+{
+    Cells.Reset();
+    Slots.Init(INDEX_NONE, NumGridCells);
+}
+
+void FSnakeFreeCellIndex::FPool::Add(int32 Index)
+{
+    if (Slots[Index] == INDEX_NONE)
+    {
+        Slots[Index] = Cells.Add(Index);
+    }
+}
+
+void FSnakeFreeCellIndex::FPool::Remove(int32 Index)
+{
+    const int32 Slot = Slots[Index];
+    if (Slot == INDEX_NONE)
+    {
+        return;
+    }
+
+    const int32 Last = Cells.Pop(EAllowShrinking::No);
+    if (Last != Index)
+    {
+        Cells[Slot] = Last;
+        Slots[Last] = Slot;
+    }
+    Slots[Index] = INDEX_NONE;
+}
+
+void FSnakeFreeCellIndex::Init(const FSnakeGrid& Grid)
+{
+    Free.Init(Grid.Num());
+    PreferredFree.Init(Grid.Num());
+    Preferred.Init(false, Grid.Num());
+    Free.Cells.Reserve(Grid.GetNumWalkable());
+
+    for (int32 Index = 0; Index < Grid.Num(); Index++)
+    {
+        if (!Grid.IsWalkableAt(Index))
+        {
+            continue;
+        }
+
+        bool bSurrounded = true;
+        for (int32 Dir = 0; Dir < FSnakeGrid::NumDirections; Dir++)
+        {
+            const int32 Neigh = Grid.GetNeighbour(Index, Dir);
+            if (Neigh == INDEX_NONE || !Grid.IsWalkableAt(Neigh))
+            {
+                bSurrounded = false;
+                break;
+            }
+        }
+        Preferred[Index] = bSurrounded;
+
+        if (Grid.IsFreeAt(Index) && !Grid.HasFlagAt(Index, ESnakeCell::Food))
+        {
+            Add(Index);
+        }
+    }
+}
+
+void FSnakeFreeCellIndex::Reset()
+{
+    Free = FPool();
+    PreferredFree = FPool();
+    Preferred.Empty();
+}
+
+void FSnakeFreeCellIndex::Add(int32 Index)
+{
+    Free.Add(Index);
+    if (Preferred[Index])
+    {
+        PreferredFree.Add(Index);
+    }
+}
+
+void FSnakeFreeCellIndex::Remove(int32 Index)
+{
+    Free.Remove(Index);
+    if (Preferred[Index])
+    {
+        PreferredFree.Remove(Index);
+    }
+}
+
+int32 FSnakeFreeCellIndex::Sample(FRandomStream& Random) const
+{
+    const TArray<int32>& Pool = PreferredFree.Cells.Num() > 0 ? PreferredFree.Cells : Free.Cells;
+    return Pool.Num() > 0 ? Pool[Random.RandHelper(Pool.Num())] : INDEX_NONE;
+}
+
+SIZE_T FSnakeFreeCellIndex::GetAllocatedSize() const
+{
+    return Free.Cells.GetAllocatedSize() + Free.Slots.GetAllocatedSize()
+        + PreferredFree.Cells.GetAllocatedSize() + PreferredFree.Slots.GetAllocatedSize()
+        + Preferred.GetAllocatedSize();
+}
@@ -0,0 +1,76 @@
+#include "SnakeGrid.h"
+
+#include "SnakeLevelPack.h"
+
+void FSnakeGrid::Init(const FSnakeLevelView& Level)
+{
+    // Text row 0 is the far end of the level (X = Height), see FSnakeLevelData::ParseText.
+    SizeX = Level.Height;
+    SizeY = Level.Width;
+    Origin = FIntPoint(1, 0);
+    Cells.Init(0, SizeX * SizeY);
+    NumWalkable = 0;
+
+    for (int32 Row = 0; Row < Level.Height; Row++)
+    {
+        uint8* GridRow = Cells.GetData() + (Level.Height - 1 - Row) * SizeY;
+        for (int32 Column = 0; Column < Level.Width; Column++)
+        {
+            uint8 Flags = 0;
+            if (FSnakeLevelView::TestBit(Level.WallPlane, Level.WordsPerRow, Row, Column))
+            {
+                Flags |= uint8(ESnakeCell::Wall);
+            }
+            if (FSnakeLevelView::TestBit(Level.FloorPlane, Level.WordsPerRow, Row, Column))
+            {
+                Flags |= uint8(ESnakeCell::Floor);
+                NumWalkable++;
+            }
+            if (FSnakeLevelView::TestBit(Level.DoorPlane, Level.WordsPerRow, Row, Column))
+            {
+                Flags |= uint8(ESnakeCell::Door);
+            }
+            GridRow[Column] = Flags;
+        }
+    }
+}
+
+void FSnakeGrid::Reset()
+{
+    Cells.Empty();
+    Origin = FIntPoint::ZeroValue;
+    SizeX = 0;
+    SizeY = 0;
+    NumWalkable = 0;
+}
+
+bool FSnakeGrid::AddOccupant(const FIntPoint& Cell)
+{
+    const int32 Index = ToIndex(Cell);
+    return Index != INDEX_NONE && AddOccupantTo(Cells[Index]);
+}
+
+bool FSnakeGrid::RemoveOccupant(const FIntPoint& Cell)
+{
+    // Past MaxOccupants the count is lost, the cell stays taken rather than reading free under a body
+    const int32 Index = ToIndex(Cell);
+    return Index != INDEX_NONE && RemoveOccupantFrom(Cells[Index]);
+}
+
+void FSnakeGrid::SetFood(const FIntPoint& Cell, bool bHasFood)
+{
+    const int32 Index = ToIndex(Cell);
+    if (Index == INDEX_NONE)
+    {
+        return;
+    }
+
+    if (bHasFood)
+    {
+        Cells[Index] |= uint8(ESnakeCell::Food);
+    }
+    else
+    {
+        Cells[Index] &= ~uint8(ESnakeCell::Food);
+    }
+}
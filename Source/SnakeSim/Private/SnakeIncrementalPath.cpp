@@ -0,0 +1,278 @@
+#include "SnakeIncrementalPath.h"
+
+#include "SnakeGridJournal.h"
+
+namespace SnakeIncrementalPath
+{
+    uint32 AddStep(uint32 Distance)
+    {
+        return Distance == MAX_uint32 ? MAX_uint32 : Distance + 1;
+    }
+
+    struct FOpenNodeOrder
+    {
+        template <typename NodeType>
+        bool operator()(const NodeType& A, const NodeType& B) const
+        {
+            return A.Key.Primary < B.Key.Primary || (A.Key.Primary == B.Key.Primary && A.Key.Secondary < B.Key.Secondary);
+        }
+    };
+
+    template <typename KeyType>
+    bool IsLess(const KeyType& A, const KeyType& B)
+    {
+        return A.Primary < B.Primary || (A.Primary == B.Primary && A.Secondary < B.Secondary);
+    }
+}
+
+bool FSnakeIncrementalPath::FindPath(const FSnakeGrid& Grid, const FSnakeGridJournal& Journal, int32 Start, int32 NewGoal, TArray<int32>& OutPath)
+{
+    using namespace SnakeIncrementalPath;
+
+    OutPath.Reset();
+    NumExpanded = 0;
+    if (Start == INDEX_NONE || NewGoal == INDEX_NONE)
+    {
+        return false;
+    }
+
+    TConstArrayView<int32> Changed;
+    if (NewGoal != Goal || Stamp.Num() != Grid.Num() || !Journal.GetChangesSince(Serial, Changed))
+    {
+        Restart(Grid, Start, NewGoal, Journal.GetSerial());
+    }
+    else
+    {
+        // Keys already queued were made from the old start; raising the bound keeps them comparable.
+        if (Start != LastStart)
+        {
+            Km += FMath::Abs(LastStart / SizeY - Start / SizeY) + FMath::Abs(LastStart % SizeY - Start % SizeY);
+            LastStart = Start;
+        }
+
+        // A cell changing its free state changes the cost of stepping onto it from every neighbour.
+        for (const int32 Cell : Changed)
+        {
+            for (int32 Direction = 0; Direction < FSnakeGrid::NumDirections; Direction++)
+            {
+                const int32 Neighbour = Grid.GetNeighbour(Cell, Direction);
+                if (Neighbour != INDEX_NONE && Neighbour != Goal && Grid.IsWalkableAt(Neighbour))
+                {
+                    SetRhs(Neighbour, ComputeRhs(Grid, Neighbour));
+                    UpdateVertex(Neighbour, Start);
+                }
+            }
+        }
+        Serial = Journal.GetSerial();
+
+        // Repairs leave superseded entries behind, drop them before they outgrow the grid.
+        if (Open.Num() > Grid.Num() * 4)
+        {
+            Open.RemoveAll([this](const FOpenNode& Node) { return GetG(Node.Index) == GetRhs(Node.Index); });
+            for (FOpenNode& Node : Open)
+            {
+                Node.Key = CalculateKey(Node.Index, Start);
+            }
+            Open.Heapify(FOpenNodeOrder());
+        }
+    }
+
+    ComputeShortestPath(Grid, Start);
+    if (GetRhs(Start) == Unreachable)
+    {
+        return false;
+    }
+
+    // Walk down the distances. Every step lowers them by one, so this can't take more than the grid.
+    int32 Current = Start;
+    OutPath.Add(Current);
+    while (Current != Goal && OutPath.Num() <= Grid.Num())
+    {
+        int32 Next = INDEX_NONE;
+        uint32 NextDistance = Unreachable;
+        for (int32 Direction = 0; Direction < FSnakeGrid::NumDirections; Direction++)
+        {
+            const int32 Neighbour = Grid.GetNeighbour(Current, Direction);
+            if (Neighbour != INDEX_NONE && Grid.IsFreeAt(Neighbour) && GetG(Neighbour) < NextDistance)
+            {
+                NextDistance = GetG(Neighbour);
+                Next = Neighbour;
+            }
+        }
+        if (Next == INDEX_NONE)
+        {
+            OutPath.Reset();
+            return false;
+        }
+        Current = Next;
+        OutPath.Add(Current);
+    }
+    if (Current != Goal)
+    {
+        OutPath.Reset();
+        return false;
+    }
+    return true;
+}
+
+void FSnakeIncrementalPath::Reset()
+{
+    Goal = INDEX_NONE;
+    LastStart = INDEX_NONE;
+    Stamp.Empty();
+    G.Empty();
+    Rhs.Empty();
+    Open.Empty();
+    Generation = 0;
+}
+
+void FSnakeIncrementalPath::Restart(const FSnakeGrid& Grid, int32 Start, int32 NewGoal, uint64 JournalSerial)
+{
+    if (Stamp.Num() != Grid.Num())
+    {
+        Stamp.Init(0, Grid.Num());
+        G.SetNumUninitialized(Grid.Num());
+        Rhs.SetNumUninitialized(Grid.Num());
+        Generation = 0;
+    }
+    if (++Generation == 0)
+    {
+        FMemory::Memzero(Stamp.GetData(), Stamp.Num() * sizeof(uint32));
+        Generation = 1;
+    }
+
+    Goal = NewGoal;
+    LastStart = Start;
+    SizeY = Grid.GetSizeY();
+    Km = 0;
+    Serial = JournalSerial;
+    Open.Reset();
+
+    SetRhs(Goal, 0);
+    UpdateVertex(Goal, Start);
+}
+
+void FSnakeIncrementalPath::ComputeShortestPath(const FSnakeGrid& Grid, int32 Start)
+{
+    using namespace SnakeIncrementalPath;
+
+    while (true)
+    {
+        // Cells settled since they were queued.
+        while (Open.Num() > 0 && GetG(Open.HeapTop().Index) == GetRhs(Open.HeapTop().Index))
+        {
+            Open.HeapPopDiscard(FOpenNodeOrder(), EAllowShrinking::No);
+        }
+        if (Open.Num() == 0
+            || (!IsLess(Open.HeapTop().Key, CalculateKey(Start, Start)) && GetRhs(Start) <= GetG(Start)))
+        {
+            return;
+        }
+
+        FOpenNode Node;
+        Open.HeapPop(Node, FOpenNodeOrder(), EAllowShrinking::No);
+        NumExpanded++;
+
+        const int32 Index = Node.Index;
+        const FKey NewKey = CalculateKey(Index, Start);
+        if (IsLess(Node.Key, NewKey))
+        {
+            Open.HeapPush({ NewKey, Index }, FOpenNodeOrder());
+            continue;
+        }
+
+        // Stepping onto a blocked cell isn't possible, so its distance doesn't reach its neighbours.
+        const bool bEnterable = Grid.IsFreeAt(Index);
+        if (GetG(Index) > GetRhs(Index))
+        {
+            const uint32 NewG = GetRhs(Index);
+            SetG(Index, NewG);
+            if (!bEnterable)
+            {
+                continue;
+            }
+            for (int32 Direction = 0; Direction < FSnakeGrid::NumDirections; Direction++)
+            {
+                const int32 Neighbour = Grid.GetNeighbour(Index, Direction);
+                if (Neighbour != INDEX_NONE && Neighbour != Goal && Grid.IsWalkableAt(Neighbour)
+                    && AddStep(NewG) < GetRhs(Neighbour))
+                {
+                    SetRhs(Neighbour, AddStep(NewG));
+                    UpdateVertex(Neighbour, Start);
+                }
+            }
+        }
+        else
+        {
+            const uint32 OldG = GetG(Index);
+            SetG(Index, Unreachable);
+            UpdateVertex(Index, Start);
+            if (!bEnterable)
+            {
+                continue;
+            }
+            for (int32 Direction = 0; Direction < FSnakeGrid::NumDirections; Direction++)
+            {
+                const int32 Neighbour = Grid.GetNeighbour(Index, Direction);
+                if (Neighbour != INDEX_NONE && Neighbour != Goal && Grid.IsWalkableAt(Neighbour)
+                    && GetRhs(Neighbour) == AddStep(OldG))
+                {
+                    SetRhs(Neighbour, ComputeRhs(Grid, Neighbour));
+                    UpdateVertex(Neighbour, Start);
+                }
+            }
+        }
+    }
+}
+
+FSnakeIncrementalPath::FKey FSnakeIncrementalPath::CalculateKey(int32 Index, int32 Start) const
+{
+    const uint32 Distance = FMath::Min(GetG(Index), GetRhs(Index));
+    if (Distance == Unreachable)
+    {
+        return { MAX_uint64, Unreachable };
+    }
+    const uint32 Heuristic = FMath::Abs(Index / SizeY - Start / SizeY) + FMath::Abs(Index % SizeY - Start % SizeY);
+    return { uint64(Distance) + Heuristic + Km, Distance };
+}
+
+uint32 FSnakeIncrementalPath::ComputeRhs(const FSnakeGrid& Grid, int32 Index) const
+{
+    using namespace SnakeIncrementalPath;
+
+    uint32 Best = Unreachable;
+    for (int32 Direction = 0; Direction < FSnakeGrid::NumDirections; Direction++)
+    {
+        const int32 Neighbour = Grid.GetNeighbour(Index, Direction);
+        if (Neighbour != INDEX_NONE && Grid.IsFreeAt(Neighbour))
+        {
+            Best = FMath::Min(Best, AddStep(GetG(Neighbour)));
+        }
+    }
+    return Best;
+}
+
+void FSnakeIncrementalPath::UpdateVertex(int32 Index, int32 Start)
+{
+    using namespace SnakeIncrementalPath;
+
+    if (GetG(Index) != GetRhs(Index))
+    {
+        Open.HeapPush({ CalculateKey(Index, Start), Index }, FOpenNodeOrder());
+    }
+}
+
+void FSnakeIncrementalPath::Touch(int32 Index)
+{
+    if (Stamp[Index] != Generation)
+    {
+        Stamp[Index] = Generation;
+        G[Index] = Unreachable;
+        Rhs[Index] = Unreachable;
+    }
+}
+
+SIZE_T FSnakeIncrementalPath::GetAllocatedSize() const
+{
+    return Stamp.GetAllocatedSize() + G.GetAllocatedSize() + Rhs.GetAllocatedSize() + Open.GetAllocatedSize();
+}
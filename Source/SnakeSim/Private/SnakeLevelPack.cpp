@@ -0,0 +1,316 @@
+#include "SnakeLevelPack.h"
+
+#include "Algo/BinarySearch.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace SnakeLevelPack
+{
+    constexpr uint64 SectionAlignment = 16;
+
+    static void SetBit(TArray<uint64>& Plane, int32 WordsPerRow, int32 Row, int32 Column)
+    {
+        Plane[Row * WordsPerRow + (Column >> 6)] |= uint64(1) << (Column & 63);
+    }
+
+    template <typename T>
+    static TConstArrayView<T> ViewAt(const uint8* Base, uint64 Offset, int32 Num)
+    {
+        return TConstArrayView<T>(reinterpret_cast<const T*>(Base + Offset), Num);
+    }
+
+    template <typename T>
+    static uint64 AppendSection(TArray64<uint8>& Out, const TArray<T>& Items)
+    {
+        Out.SetNumZeroed(Align(Out.Num(), SectionAlignment));
+        const uint64 Offset = Out.Num();
+        Out.Append(reinterpret_cast<const uint8*>(Items.GetData()), Items.Num() * sizeof(T));
+        return Offset;
+    }
+}
+
+bool FSnakeLevelData::ParseText(const TArray<FString>& Lines, float InTileSize)
+{
+    Height = Lines.Num();
+    Width = 0;
+    for (const FString& Line : Lines)
+    {
+        Width = FMath::Max(Width, Line.Len());
+    }
+    if (Width == 0 || Height == 0)
+    {
+        return false;
+    }
+
+    WordsPerRow = (Width + 63) / 64;
+    WallPlane.Init(0, Height * WordsPerRow);
+    FloorPlane.Init(0, Height * WordsPerRow);
+    DoorPlane.Init(0, Height * WordsPerRow);
+    WallTranslations.Reset();
+    FloorTranslations.Reset();
+    DoorTranslations.Reset();
+
+    for (int32 y = 0; y < Height; y++)
+    {
+        const FString& Line = Lines[y];
+        for (int32 x = 0; x < Line.Len(); x++)
+        {
+            // Same placement the text loader always used: rows run down -X, columns along +Y.
+            const FVector3f Translation((Height - y) * InTileSize, x * InTileSize, 0.0f);
+
+            switch (Line[x])
+            {
+                case '#':
+                    SnakeLevelPack::SetBit(WallPlane, WordsPerRow, y, x);
+                    WallTranslations.Add(Translation);
+                    break;
+
+                case 'D':
+                    SnakeLevelPack::SetBit(DoorPlane, WordsPerRow, y, x);
+                    DoorTranslations.Add(Translation);
+                    break;
+
+                case '.':
+                    SnakeLevelPack::SetBit(FloorPlane, WordsPerRow, y, x);
+                    FloorTranslations.Add(Translation);
+                    break;
+            }
+        }
+    }
+    return true;
+}
+
+bool FSnakeLevelData::LoadFromTextFile(const FString& FilePath, float InTileSize)
+{
+    TArray<FString> Lines;
+    if (!FFileHelper::LoadFileToStringArray(Lines, *FilePath))
+    {
+        return false;
+    }
+    return ParseText(Lines, InTileSize);
+}
+
+FSnakeLevelView FSnakeLevelData::GetView() const
+{
+    FSnakeLevelView View;
+    View.Width = Width;
+    View.Height = Height;
+    View.WordsPerRow = WordsPerRow;
+    View.WallPlane = WallPlane;
+    View.FloorPlane = FloorPlane;
+    View.DoorPlane = DoorPlane;
+    View.WallTranslations = WallTranslations;
+    View.FloorTranslations = FloorTranslations;
+    View.DoorTranslations = DoorTranslations;
+    return View;
+}
+
+FSnakeLevelPack::FSnakeLevelPack() = default;
+
+FSnakeLevelPack::~FSnakeLevelPack()
+{
+    // Region has to go before the handle it was mapped from.
+    MappedRegion.Reset();
+    MappedHandle.Reset();
+}
+
+FString FSnakeLevelPack::GetDefaultPackPath()
+{
+    return FPaths::ProjectContentDir() / TEXT("Levels/Levels.snakepack");
+}
+
+bool FSnakeLevelPack::Open(const FString& FilePath)
+{
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    if (!PlatformFile.FileExists(*FilePath))
+    {
+        return false;
+    }
+
+    FOpenMappedResult MapResult = PlatformFile.OpenMappedEx(*FilePath);
+    if (MapResult.HasValue())
+    {
+        MappedHandle = MapResult.StealValue();
+        MappedRegion.Reset(MappedHandle->MapRegion(0, MappedHandle->GetFileSize()));
+    }
+
+    if (MappedRegion.IsValid())
+    {
+        Data = MappedRegion->GetMappedPtr();
+        DataSize = MappedRegion->GetMappedSize();
+    }
+    else
+    {
+        // Pak files and some platforms can't map, read it in one go instead.
+        MappedHandle.Reset();
+        if (!FFileHelper::LoadFileToArray(FallbackBuffer, *FilePath))
+        {
+            return false;
+        }
+        Data = FallbackBuffer.GetData();
+        DataSize = FallbackBuffer.Num();
+    }
+
+    if (!Validate())
+    {
+        UE_LOG(LogTemp, Error, TEXT("[LevelPack] %s is not a valid level pack"), *FilePath);
+        MappedRegion.Reset();
+        MappedHandle.Reset();
+        FallbackBuffer.Empty();
+        Data = nullptr;
+        DataSize = 0;
+        Header = nullptr;
+        Entries = {};
+        return false;
+    }
+
+    TimeStamp = PlatformFile.GetTimeStamp(*FilePath);
+    UE_LOG(LogTemp, Log, TEXT("[LevelPack] Opened %s (%d levels, %s)"),
+           *FilePath, Entries.Num(), MappedRegion.IsValid() ? TEXT("mapped") : TEXT("buffered"));
+    return true;
+}
+
+bool FSnakeLevelPack::Validate()
+{
+    if (DataSize < (int64)sizeof(FSnakeLevelPackHeader))
+    {
+        return false;
+    }
+
+    Header = reinterpret_cast<const FSnakeLevelPackHeader*>(Data);
+    if (Header->Magic != FSnakeLevelPackHeader::ExpectedMagic
+        || Header->Version != FSnakeLevelPackHeader::CurrentVersion
+        || Header->FileSize != (uint64)DataSize
+        || !(Header->TileSize > 0.0f))
+    {
+        return false;
+    }
+
+    // Written as Bytes > Size || Offset > Size - Bytes so that no sum of offsets read from the file can wrap
+    const uint64 Size = (uint64)DataSize;
+    const auto InRange = [Size](uint64 Offset, uint64 Bytes, uint64 Alignment)
+    {
+        return Offset % Alignment == 0 && Bytes <= Size && Offset <= Size - Bytes;
+    };
+
+    if (!InRange(Header->IndexOffset, uint64(Header->NumLevels) * sizeof(FSnakeLevelPackEntry), alignof(FSnakeLevelPackEntry)))
+    {
+        return false;
+    }
+    Entries = SnakeLevelPack::ViewAt<FSnakeLevelPackEntry>(Data, Header->IndexOffset, Header->NumLevels);
+
+    for (const FSnakeLevelPackEntry& Entry : Entries)
+    {
+        // Sizes come first, the plane sizes and every bit lookup are computed from them
+        if (Entry.Width <= 0 || Entry.Height <= 0 || Entry.WordsPerRow <= 0 || int64(Entry.WordsPerRow) * 64 < Entry.Width
+            || Entry.NumWalls < 0 || Entry.NumFloors < 0 || Entry.NumDoors < 0)
+        {
+            return false;
+        }
+
+        // Height * WordsPerRow fits in 62 bits, the byte count only once it's known to fit the file
+        const uint64 PlaneWords = uint64(Entry.Height) * uint64(Entry.WordsPerRow);
+        if (PlaneWords > Size / sizeof(uint64))
+        {
+            return false;
+        }
+        const uint64 PlaneBytes = PlaneWords * sizeof(uint64);
+
+        if (!InRange(Entry.WallPlaneOffset, PlaneBytes, SnakeLevelPack::SectionAlignment)
+            || !InRange(Entry.FloorPlaneOffset, PlaneBytes, SnakeLevelPack::SectionAlignment)
+            || !InRange(Entry.DoorPlaneOffset, PlaneBytes, SnakeLevelPack::SectionAlignment)
+            || !InRange(Entry.WallTranslationsOffset, uint64(Entry.NumWalls) * sizeof(FVector3f), SnakeLevelPack::SectionAlignment)
+            || !InRange(Entry.FloorTranslationsOffset, uint64(Entry.NumFloors) * sizeof(FVector3f), SnakeLevelPack::SectionAlignment)
+            || !InRange(Entry.DoorTranslationsOffset, uint64(Entry.NumDoors) * sizeof(FVector3f), SnakeLevelPack::SectionAlignment))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FSnakeLevelPack::IsOlderThan(const FString& SourcePath) const
+{
+    // A missing source, as in a cooked build, never makes the pack stale
+    const FDateTime SourceTime = FPlatformFileManager::Get().GetPlatformFile().GetTimeStamp(*SourcePath);
+    return SourceTime != FDateTime::MinValue() && SourceTime > TimeStamp;
+}
+
+const FSnakeLevelPackEntry* FSnakeLevelPack::FindEntry(int32 LevelIndex) const
+{
+    // Entries are written sorted by level index.
+    const int32 Found = Algo::LowerBoundBy(Entries, LevelIndex, &FSnakeLevelPackEntry::LevelIndex);
+    if (Entries.IsValidIndex(Found) && Entries[Found].LevelIndex == LevelIndex)
+    {
+        return &Entries[Found];
+    }
+    return nullptr;
+}
+
+bool FSnakeLevelPack::FindLevel(int32 LevelIndex, FSnakeLevelView& OutView) const
+{
+    const FSnakeLevelPackEntry* Entry = FindEntry(LevelIndex);
+    if (!Entry)
+    {
+        return false;
+    }
+
+    using namespace SnakeLevelPack;
+    const int32 PlaneWords = Entry->Height * Entry->WordsPerRow;
+    OutView.Width = Entry->Width;
+    OutView.Height = Entry->Height;
+    OutView.WordsPerRow = Entry->WordsPerRow;
+    OutView.WallPlane = ViewAt<uint64>(Data, Entry->WallPlaneOffset, PlaneWords);
+    OutView.FloorPlane = ViewAt<uint64>(Data, Entry->FloorPlaneOffset, PlaneWords);
+    OutView.DoorPlane = ViewAt<uint64>(Data, Entry->DoorPlaneOffset, PlaneWords);
+    OutView.WallTranslations = ViewAt<FVector3f>(Data, Entry->WallTranslationsOffset, Entry->NumWalls);
+    OutView.FloorTranslations = ViewAt<FVector3f>(Data, Entry->FloorTranslationsOffset, Entry->NumFloors);
+    OutView.DoorTranslations = ViewAt<FVector3f>(Data, Entry->DoorTranslationsOffset, Entry->NumDoors);
+    return true;
+}
+
+bool FSnakeLevelPack::Write(const FString& FilePath, const TArray<FSnakeLevelData>& Levels, float InTileSize)
+{
+    using namespace SnakeLevelPack;
+
+    TArray<const FSnakeLevelData*> Sorted;
+    for (const FSnakeLevelData& Level : Levels)
+    {
+        Sorted.Add(&Level);
+    }
+    Sorted.Sort([](const FSnakeLevelData& A, const FSnakeLevelData& B) { return A.LevelIndex < B.LevelIndex; });
+
+    TArray64<uint8> Out;
+    Out.SetNumZeroed(sizeof(FSnakeLevelPackHeader));
+
+    TArray<FSnakeLevelPackEntry> PackEntries;
+    for (const FSnakeLevelData* Level : Sorted)
+    {
+        FSnakeLevelPackEntry& Entry = PackEntries.AddDefaulted_GetRef();
+        Entry.LevelIndex = Level->LevelIndex;
+        Entry.Width = Level->Width;
+        Entry.Height = Level->Height;
+        Entry.WordsPerRow = Level->WordsPerRow;
+        Entry.NumWalls = Level->WallTranslations.Num();
+        Entry.NumFloors = Level->FloorTranslations.Num();
+        Entry.NumDoors = Level->DoorTranslations.Num();
+        Entry.WallPlaneOffset = AppendSection(Out, Level->WallPlane);
+        Entry.FloorPlaneOffset = AppendSection(Out, Level->FloorPlane);
+        Entry.DoorPlaneOffset = AppendSection(Out, Level->DoorPlane);
+        Entry.WallTranslationsOffset = AppendSection(Out, Level->WallTranslations);
+        Entry.FloorTranslationsOffset = AppendSection(Out, Level->FloorTranslations);
+        Entry.DoorTranslationsOffset = AppendSection(Out, Level->DoorTranslations);
+    }
+
+    FSnakeLevelPackHeader PackHeader;
+    PackHeader.NumLevels = PackEntries.Num();
+    PackHeader.TileSize = InTileSize;
+    PackHeader.IndexOffset = AppendSection(Out, PackEntries);
+    Out.SetNumZeroed(Align(Out.Num(), SectionAlignment));
+    PackHeader.FileSize = Out.Num();
+    FMemory::Memcpy(Out.GetData(), &PackHeader, sizeof(PackHeader));
+
+    return FFileHelper::SaveArrayToFile(Out, *FilePath);
+}
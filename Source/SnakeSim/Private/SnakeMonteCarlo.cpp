@@ -0,0 +1,271 @@
+#include "SnakeMonteCarlo.h"
+
+#include "Async/ParallelFor.h"
+
+int32 FSnakeMonteCarlo::Search(const FSnakeSimState& Root, int32 Snake, const FSettings& Settings)
+{
+    NumRollouts = 0;
+    if (Snake < 0 || Snake >= Root.GetNumSnakes() || !Root.IsAlive(Snake))
+        return INDEX_NONE;
+
+    // One tree per worker, kept between searches
+    const int32 NumTrees = FMath::Max(FTaskGraphInterface::Get().GetNumWorkerThreads() + 1, 1);
+    if (Trees.Num() != NumTrees)
+    {
+        Trees.SetNum(NumTrees);
+        for (int32 i = 0; i < NumTrees; i++)
+        {
+            Trees[i].Random.Initialize(int32(FPlatformTime::Cycles()) + i * 7919);
+            Trees[i].Nodes.Reset();
+        }
+    }
+
+    const double Deadline = FPlatformTime::Seconds() + Settings.TimeBudget;
+    ParallelFor(NumTrees, [this, &Root, Snake, &Settings, Deadline](int32 TreeIndex)
+    {
+        FTree& Tree = Trees[TreeIndex];
+        if (Tree.Nodes.Num() == 0)
+        {
+            Tree.Nodes.AddDefaulted();
+        }
+        Tree.NumRollouts = 0;
+
+        // At least one game each, so a late worker still adds something
+        do
+        {
+            RunIteration(Tree, Root, Snake, Settings);
+        }
+        while (FPlatformTime::Seconds() < Deadline);
+    });
+
+    // Most visited move over all trees, the one the searches trusted most
+    int32 Visits[NumMoves] = {};
+    float Values[NumMoves] = {};
+    for (const FTree& Tree : Trees)
+    {
+        NumRollouts += Tree.NumRollouts;
+        const int32 FirstChild = Tree.Nodes[0].FirstChild;
+        if (FirstChild == INDEX_NONE)
+            continue;
+        for (int32 Move = 0; Move < NumMoves; Move++)
+        {
+            Visits[Move] += Tree.Nodes[FirstChild + Move].Visits;
+            Values[Move] += Tree.Nodes[FirstChild + Move].Value;
+        }
+    }
+
+    int32 Best = INDEX_NONE;
+    for (int32 Move = 0; Move < NumMoves; Move++)
+    {
+        if (Visits[Move] > 0 && (Best == INDEX_NONE || Visits[Move] > Visits[Best]
+            || (Visits[Move] == Visits[Best] && Values[Move] > Values[Best])))
+        {
+            Best = Move;
+        }
+    }
+    if (Best == INDEX_NONE)
+    {
+        // Too little time to get past the root, any move that doesn't kill us outright
+        int32 Safe[NumMoves];
+        Best = Root.GetSafeMoves(Snake, Safe) > 0 ? Safe[0] : INDEX_NONE;
+    }
+    return Best;
+}
+
+void FSnakeMonteCarlo::Advance(int32 Move)
+{
+    for (FTree& Tree : Trees)
+    {
+        const int32 FirstChild = Tree.Nodes.Num() > 0 ? Tree.Nodes[0].FirstChild : INDEX_NONE;
+        if (Move >= 0 && Move < NumMoves && FirstChild != INDEX_NONE && Tree.Nodes[FirstChild + Move].Visits > 0)
+        {
+            KeepSubtree(Tree, FirstChild + Move);
+        }
+        else
+        {
+            Tree.Nodes.Reset();
+        }
+    }
+}
+
+void FSnakeMonteCarlo::Reset()
+{
+    for (FTree& Tree : Trees)
+    {
+        Tree.Nodes.Reset();
+    }
+}
+
+int32 FSnakeMonteCarlo::GetNumNodes() const
+{
+    int32 Count = 0;
+    for (const FTree& Tree : Trees)
+    {
+        Count += Tree.Nodes.Num();
+    }
+    return Count;
+}
+
+void FSnakeMonteCarlo::KeepSubtree(FTree& Tree, int32 NewRoot)
+{
+    // Breadth first copy, children stay in rows of NumMoves
+    Tree.Scratch.Reset();
+    Tree.Scratch.Add(Tree.Nodes[NewRoot]);
+    for (int32 Index = 0; Index < Tree.Scratch.Num(); Index++)
+    {
+        const int32 OldFirst = Tree.Scratch[Index].FirstChild;
+        if (OldFirst == INDEX_NONE)
+            continue;
+
+        Tree.Scratch[Index].FirstChild = Tree.Scratch.Num();
+        for (int32 Move = 0; Move < NumMoves; Move++)
+        {
+            Tree.Scratch.Add(Tree.Nodes[OldFirst + Move]);
+        }
+    }
+    Swap(Tree.Nodes, Tree.Scratch);
+}
+
+void FSnakeMonteCarlo::RunIteration(FTree& Tree, const FSnakeSimState& Root, int32 Snake, const FSettings& Settings)
+{
+    FSnakeSimState& State = Tree.State;
+    State = Root;
+
+    int32 Moves[FSnakeSimState::MaxSnakes];
+    const TConstArrayView<int32> MoveView(Moves, State.GetNumSnakes());
+
+    // Down the tree, the other snakes play their rollout policy
+    int32 Node = 0;
+    Tree.Visited.Reset();
+    Tree.Visited.Add(Node);
+    while (State.IsAlive(Snake))
+    {
+        if (Tree.Nodes[Node].FirstChild == INDEX_NONE)
+        {
+            // A leaf grows children on its second visit, the first one is only played out
+            if (Tree.Nodes[Node].Visits == 0 || Tree.Nodes.Num() + NumMoves > Settings.MaxNodesPerTree)
+                break;
+            Tree.Nodes[Node].FirstChild = Tree.Nodes.Num();
+            Tree.Nodes.AddDefaulted(NumMoves);
+        }
+
+        for (int32 Other = 0; Other < State.GetNumSnakes(); Other++)
+        {
+            Moves[Other] = Other != Snake ? ChooseRolloutMove(State, Other, Tree.Random) : INDEX_NONE;
+        }
+        const int32 Move = SelectMove(Tree, Node, Snake, Settings.Exploration);
+        Moves[Snake] = Move;
+        State.Step(MoveView, Tree.Random);
+
+        Node = Tree.Nodes[Node].FirstChild + Move;
+        Tree.Visited.Add(Node);
+    }
+
+    for (int32 Depth = 0; Depth < Settings.RolloutDepth && State.IsAlive(Snake); Depth++)
+    {
+        for (int32 Other = 0; Other < State.GetNumSnakes(); Other++)
+        {
+            Moves[Other] = ChooseRolloutMove(State, Other, Tree.Random);
+        }
+        State.Step(MoveView, Tree.Random);
+    }
+
+    const float Reward = Evaluate(State, Root, Snake);
+    for (const int32 Visited : Tree.Visited)
+    {
+        Tree.Nodes[Visited].Visits++;
+        Tree.Nodes[Visited].Value += Reward;
+    }
+    Tree.NumRollouts++;
+}
+
+int32 FSnakeMonteCarlo::SelectMove(FTree& Tree, int32 Node, int32 Snake, float Exploration)
+{
+    const FSnakeSimState& State = Tree.State;
+    int32 Safe[NumMoves];
+    const int32 NumSafe = State.GetSafeMoves(Snake, Safe);
+    if (NumSafe == 0)
+    {
+        // Every way is deadly this time round, straight on is as good as any
+        return State.GetDirection(Snake) != INDEX_NONE ? State.GetDirection(Snake) : 0;
+    }
+
+    // UCB1, moves never tried come first in random order
+    const FNode& Parent = Tree.Nodes[Node];
+    const float LogVisits = FMath::Loge(float(FMath::Max(Parent.Visits, 1)));
+    int32 Best = Safe[0];
+    float BestScore = -1.0f;
+    for (int32 i = 0; i < NumSafe; i++)
+    {
+        const FNode& Child = Tree.Nodes[Parent.FirstChild + Safe[i]];
+        const float Score = Child.Visits == 0
+            ? 2.0f + Tree.Random.FRand()
+            : Child.Value / Child.Visits + Exploration * FMath::Sqrt(LogVisits / Child.Visits);
+        if (Score > BestScore)
+        {
+            BestScore = Score;
+            Best = Safe[i];
+        }
+    }
+    return Best;
+}
+
+int32 FSnakeMonteCarlo::ChooseRolloutMove(const FSnakeSimState& State, int32 Snake, FRandomStream& Random)
+{
+    int32 Safe[NumMoves];
+    const int32 NumSafe = State.IsAlive(Snake) ? State.GetSafeMoves(Snake, Safe) : 0;
+    if (NumSafe == 0)
+        return INDEX_NONE;
+
+    // Mostly towards the nearest apple, sometimes anywhere safe so the games don't all play out the same
+    const int32 Food = State.FindNearestFood(State.GetHead(Snake));
+    if (Food == INDEX_NONE || Random.FRand() < 0.25f)
+        return Safe[Random.RandHelper(NumSafe)];
+
+    int32 Best = Safe[0];
+    int32 BestDistance = MAX_int32;
+    for (int32 i = 0; i < NumSafe; i++)
+    {
+        const int32 Distance = State.GetDistance(State.GetNeighbour(State.GetHead(Snake), Safe[i]), Food);
+        if (Distance < BestDistance)
+        {
+            BestDistance = Distance;
+            Best = Safe[i];
+        }
+    }
+    return Best;
+}
+
+float FSnakeMonteCarlo::Evaluate(const FSnakeSimState& State, const FSnakeSimState& Root, int32 Snake)
+{
+    if (!State.IsAlive(Snake))
+        return 0.0f;
+
+    // Staying alive is worth most, then eating more than the others, then outliving them
+    const int32 Gain = State.GetFoodEaten(Snake) - Root.GetFoodEaten(Snake);
+    int32 BestOtherGain = 0;
+    bool bHasOthers = false;
+    bool bOthersAlive = false;
+    for (int32 Other = 0; Other < State.GetNumSnakes(); Other++)
+    {
+        if (Other == Snake || !Root.IsAlive(Other))
+            continue;
+        bHasOthers = true;
+        bOthersAlive |= State.IsAlive(Other);
+        BestOtherGain = FMath::Max(BestOtherGain, State.GetFoodEaten(Other) - Root.GetFoodEaten(Other));
+    }
+
+    float Reward = 0.5f + 0.15f * (Gain - BestOtherGain);
+    if (bHasOthers && !bOthersAlive)
+    {
+        Reward += 0.25f;
+    }
+
+    // Being near an apple at the end breaks ties between otherwise equal games
+    const int32 Food = State.FindNearestFood(State.GetHead(Snake));
+    if (Food != INDEX_NONE)
+    {
+        Reward += 0.05f * (1.0f - float(State.GetDistance(State.GetHead(Snake), Food)) / (State.GetSizeX() + State.GetSizeY()));
+    }
+    return FMath::Clamp(Reward, 0.1f, 1.0f);
+}
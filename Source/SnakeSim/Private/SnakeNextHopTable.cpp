@@ -0,0 +1,228 @@
+#include "SnakeNextHopTable.h"
+
+#include "Algo/BinarySearch.h"
+#include "Async/ParallelFor.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "SnakeGrid.h"
+
+uint32 FSnakeNextHopTable::MapCells(const FSnakeGrid& Grid)
+{
+    SizeX = Grid.GetSizeX();
+    SizeY = Grid.GetSizeY();
+    CellToNode.Init(INDEX_NONE, Grid.Num());
+    NodeToCell.Reset(Grid.GetNumWalkable());
+    for (int32 Index = 0; Index < Grid.Num(); Index++)
+    {
+        if (Grid.IsWalkableAt(Index))
+        {
+            CellToNode[Index] = NodeToCell.Add(Index);
+        }
+    }
+
+    uint32 Hash = FCrc::MemCrc32(NodeToCell.GetData(), NodeToCell.Num() * sizeof(int32));
+    Hash = HashCombine(Hash, GetTypeHash(FIntPoint(SizeX, SizeY)));
+    return Hash;
+}
+
+void FSnakeNextHopTable::Build(const FSnakeGrid& Grid)
+{
+    WallsHash = MapCells(Grid);
+    const int32 NumNodes = NodeToCell.Num();
+
+    // One batch per worker, each with its own search buffers and output rows.
+    struct FBatch
+    {
+        TArray<int32> Queue;
+        TArray<uint8> FirstMove;
+        TArray<uint32> Runs;
+        TArray<uint32> RowEnds;
+    };
+    const int32 NumBatches = FMath::Max(FMath::Min(NumNodes, FTaskGraphInterface::Get().GetNumWorkerThreads() + 1), 1);
+    TArray<FBatch> Batches;
+    Batches.SetNum(NumBatches);
+
+    ParallelFor(NumBatches, [this, &Grid, &Batches, NumBatches, NumNodes](int32 BatchIndex)
+    {
+        FBatch& Batch = Batches[BatchIndex];
+        Batch.Queue.SetNumUninitialized(NumNodes);
+        Batch.FirstMove.SetNumUninitialized(NumNodes);
+
+        const int32 First = NumNodes * BatchIndex / NumBatches;
+        const int32 Last = NumNodes * (BatchIndex + 1) / NumBatches;
+        for (int32 Source = First; Source < Last; Source++)
+        {
+            // Every cell inherits the first move of the cell it was reached from.
+            FMemory::Memset(Batch.FirstMove.GetData(), NoMove, NumNodes);
+            int32 Head = 0;
+            int32 Tail = 0;
+            const int32 SourceCell = NodeToCell[Source];
+            for (int32 Direction = 0; Direction < FSnakeGrid::NumDirections; Direction++)
+            {
+                const int32 Neighbour = Grid.GetNeighbour(SourceCell, Direction);
+                const int32 Node = Neighbour != INDEX_NONE ? CellToNode[Neighbour] : INDEX_NONE;
+                if (Node != INDEX_NONE && Node != Source && Batch.FirstMove[Node] == NoMove)
+                {
+                    Batch.FirstMove[Node] = uint8(Direction);
+                    Batch.Queue[Tail++] = Node;
+                }
+            }
+            while (Head < Tail)
+            {
+                const int32 Node = Batch.Queue[Head++];
+                for (int32 Direction = 0; Direction < FSnakeGrid::NumDirections; Direction++)
+                {
+                    const int32 Neighbour = Grid.GetNeighbour(NodeToCell[Node], Direction);
+                    const int32 Next = Neighbour != INDEX_NONE ? CellToNode[Neighbour] : INDEX_NONE;
+                    if (Next != INDEX_NONE && Next != Source && Batch.FirstMove[Next] == NoMove)
+                    {
+                        Batch.FirstMove[Next] = Batch.FirstMove[Node];
+                        Batch.Queue[Tail++] = Next;
+                    }
+                }
+            }
+
+            // The source itself takes whatever move its neighbours in the row have, it's never asked for.
+            Batch.FirstMove[Source] = Source > 0 ? Batch.FirstMove[Source - 1] : (NumNodes > 1 ? Batch.FirstMove[1] : NoMove);
+            uint8 RunMove = Batch.FirstMove[0];
+            Batch.Runs.Add(RunMove);
+            for (int32 Target = 1; Target < NumNodes; Target++)
+            {
+                if (Batch.FirstMove[Target] != RunMove)
+                {
+                    RunMove = Batch.FirstMove[Target];
+                    Batch.Runs.Add((uint32(Target) << MoveBits) | RunMove);
+                }
+            }
+            Batch.RowEnds.Add(Batch.Runs.Num());
+        }
+    });
+
+    RowOffsets.Reset(NumNodes + 1);
+    Runs.Reset();
+    RowOffsets.Add(0);
+    for (const FBatch& Batch : Batches)
+    {
+        const uint32 BatchStart = Runs.Num();
+        for (const uint32 RowEnd : Batch.RowEnds)
+        {
+            RowOffsets.Add(BatchStart + RowEnd);
+        }
+        Runs.Append(Batch.Runs);
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("[NextHop] %d cells, %d runs (%.1f per cell)"),
+           NumNodes, Runs.Num(), NumNodes > 0 ? float(Runs.Num()) / NumNodes : 0.0f);
+}
+
+bool FSnakeNextHopTable::LoadFromFile(const FString& FilePath, const FSnakeGrid& Grid)
+{
+    TArray<uint8> Bytes;
+    if (!FFileHelper::LoadFileToArray(Bytes, *FilePath, FILEREAD_Silent))
+    {
+        return false;
+    }
+
+    const uint32 ExpectedHash = MapCells(Grid);
+    FMemoryReader Reader(Bytes);
+    uint32 Magic = 0;
+    uint32 Version = 0;
+    uint32 Hash = 0;
+    Reader << Magic << Version << Hash;
+    if (Magic != FileMagic || Version != FileVersion || Hash != ExpectedHash)
+    {
+        UE_LOG(LogTemp, Log, TEXT("[NextHop] %s is out of date, rebuilding"), *FilePath);
+        return false;
+    }
+    Reader << RowOffsets << Runs;
+
+    bool bValid = !Reader.IsError() && RowOffsets.Num() == NodeToCell.Num() + 1 && RowOffsets[0] == 0 && RowOffsets.Last() == uint32(Runs.Num());
+    const uint32 NumNodes = uint32(NodeToCell.Num());
+    const uint32 MoveMask = (1 << MoveBits) - 1;
+    for (int32 Source = 0; bValid && Source < NodeToCell.Num(); Source++)
+    {
+        // Every row has at least the run starting at the first target.
+        bValid = RowOffsets[Source] < RowOffsets[Source + 1] && (Runs[RowOffsets[Source]] >> MoveBits) == 0;
+
+        // GetFirstMove binary searches the starts and hands the move out as a direction.
+        for (uint32 Run = RowOffsets[Source]; bValid && Run < RowOffsets[Source + 1]; Run++)
+        {
+            const uint32 Target = Runs[Run] >> MoveBits;
+            const bool bAfterLast = Run == RowOffsets[Source] || Target > (Runs[Run - 1] >> MoveBits);
+            bValid = bAfterLast && Target < NumNodes && (Runs[Run] & MoveMask) <= NoMove;
+        }
+    }
+    if (!bValid)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("[NextHop] %s is corrupt, rebuilding"), *FilePath);
+        RowOffsets.Reset();
+        Runs.Reset();
+        return false;
+    }
+    WallsHash = Hash;
+    return true;
+}
+
+bool FSnakeNextHopTable::SaveToFile(const FString& FilePath)
+{
+    TArray<uint8> Bytes;
+    FMemoryWriter Writer(Bytes);
+    uint32 Magic = FileMagic;
+    uint32 Version = FileVersion;
+    uint32 Hash = WallsHash;
+    Writer << Magic << Version << Hash;
+    Writer << RowOffsets << Runs;
+    return FFileHelper::SaveArrayToFile(Bytes, *FilePath);
+}
+
+int32 FSnakeNextHopTable::GetFirstMove(int32 From, int32 To) const
+{
+    if (!CellToNode.IsValidIndex(From) || !CellToNode.IsValidIndex(To))
+    {
+        return INDEX_NONE;
+    }
+    const int32 Source = CellToNode[From];
+    const int32 Target = CellToNode[To];
+    if (Source == INDEX_NONE || Target == INDEX_NONE || Source == Target)
+    {
+        return INDEX_NONE;
+    }
+
+    // Last run starting at or before the target.
+    const TConstArrayView<uint32> Row(Runs.GetData() + RowOffsets[Source], RowOffsets[Source + 1] - RowOffsets[Source]);
+    const int32 Run = Algo::UpperBoundBy(Row, uint32(Target), [](uint32 Entry) { return Entry >> MoveBits; }) - 1;
+    const uint8 Move = Row[Run] & ((1 << MoveBits) - 1);
+    return Move != NoMove ? Move : INDEX_NONE;
+}
+
+bool FSnakeNextHopTable::FindFreePath(const FSnakeGrid& Grid, int32 Start, int32 Goal, TArray<int32>& OutPath) const
+{
+    OutPath.Reset();
+    if (Grid.Num() != CellToNode.Num() || !CellToNode.IsValidIndex(Start) || !CellToNode.IsValidIndex(Goal))
+    {
+        return false;
+    }
+
+    int32 Current = Start;
+    OutPath.Add(Current);
+    while (Current != Goal)
+    {
+        // Every step is one closer to the goal, a longer walk means the table is broken.
+        if (OutPath.Num() > NodeToCell.Num())
+        {
+            OutPath.Reset();
+            return false;
+        }
+        const int32 Move = GetFirstMove(Current, Goal);
+        const int32 Next = Move != INDEX_NONE ? Grid.GetNeighbour(Current, Move) : INDEX_NONE;
+        if (Next == INDEX_NONE || !Grid.IsFreeAt(Next))
+        {
+            OutPath.Reset();
+            return false;
+        }
+        Current = Next;
+        OutPath.Add(Current);
+    }
+    return true;
+}
@@ -0,0 +1,332 @@
+#include "SnakePathfinder.h"
+
+#include "Algo/Reverse.h"
+
+namespace SnakePathfinder
+{
+    bool IsHorizontal(int32 Direction)
+    {
+        return Direction == 1 || Direction == 3;
+    }
+
+    int32 GetManhattanDistance(int32 A, int32 B, int32 SizeY)
+    {
+        return FMath::Abs(A / SizeY - B / SizeY) + FMath::Abs(A % SizeY - B % SizeY);
+    }
+
+    bool IsBlocked(const FSnakeGrid& Grid, int32 Index)
+    {
+        return Index == INDEX_NONE || !Grid.IsFreeAt(Index);
+    }
+
+    // Entry bit for the start cell, which may turn any way.
+    constexpr uint8 StartEntry = 1 << 4;
+
+    struct FOpenNodeOrder
+    {
+        template <typename NodeType>
+        bool operator()(const NodeType& A, const NodeType& B) const
+        {
+            return A.Cost < B.Cost || (A.Cost == B.Cost && A.Distance > B.Distance);
+        }
+    };
+}
+
+void FSnakePathfinder::Reserve(int32 NumCells)
+{
+    if (Visited.Num() != NumCells)
+    {
+        // Every cell is queued at most once, so the frontier never wraps.
+        Frontier.SetNumUninitialized(NumCells);
+        Parent.SetNumUninitialized(NumCells);
+        Visited.Init(0, NumCells);
+        Distance.SetNumUninitialized(NumCells);
+        EnteredFrom.SetNumUninitialized(NumCells);
+        EntryMask.SetNumUninitialized(NumCells);
+        Generation = 0;
+    }
+}
+
+uint32 FSnakePathfinder::NextGeneration()
+{
+    if (++Generation == 0)
+    {
+        // Wrapped after four billion searches, old stamps could match again.
+        FMemory::Memzero(Visited.GetData(), Visited.Num() * sizeof(uint32));
+        Generation = 1;
+    }
+    return Generation;
+}
+
+template <typename GoalPredicate>
+int32 FSnakePathfinder::SearchBreadthFirst(const FSnakeGrid& Grid, int32 Start, GoalPredicate IsGoal)
+{
+    Reserve(Grid.Num());
+    const uint32 Mark = NextGeneration();
+
+    int32 Head = 0;
+    int32 Tail = 0;
+    Frontier[Tail++] = Start;
+    Parent[Start] = Start;
+    Visited[Start] = Mark;
+
+    int32 Found = IsGoal(Start) ? Start : INDEX_NONE;
+    while (Head < Tail && Found == INDEX_NONE)
+    {
+        const int32 Current = Frontier[Head++];
+        for (int32 Dir = 0; Dir < FSnakeGrid::NumDirections; Dir++)
+        {
+            const int32 Next = Grid.GetNeighbour(Current, Dir);
+            if (Next == INDEX_NONE || Visited[Next] == Mark || !Grid.IsFreeAt(Next))
+            {
+                continue;
+            }
+            Visited[Next] = Mark;
+            Parent[Next] = Current;
+            Frontier[Tail++] = Next;
+            if (IsGoal(Next))
+            {
+                Found = Next;
+                break;
+            }
+        }
+    }
+
+    NumExpanded = Head;
+    return Found;
+}
+
+void FSnakePathfinder::BuildPath(int32 Start, int32 End, TArray<int32>& OutPath) const
+{
+    for (int32 At = End; ; At = Parent[At])
+    {
+        OutPath.Add(At);
+        if (At == Start)
+        {
+            break;
+        }
+    }
+    Algo::Reverse(OutPath);
+}
+
+bool FSnakePathfinder::FindPath(const FSnakeGrid& Grid, int32 Start, int32 Goal, TArray<int32>& OutPath)
+{
+    OutPath.Reset();
+    NumExpanded = 0;
+    if (Start == INDEX_NONE || Goal == INDEX_NONE || !Grid.IsWalkableAt(Goal))
+    {
+        return false;
+    }
+
+    if (SearchBreadthFirst(Grid, Start, [Goal](int32 Index) { return Index == Goal; }) == INDEX_NONE)
+    {
+        return false;
+    }
+    BuildPath(Start, Goal, OutPath);
+    return true;
+}
+
+bool FSnakePathfinder::FindPathToNearest(const FSnakeGrid& Grid, int32 Start, ESnakeCell Flag, TArray<int32>& OutPath)
+{
+    OutPath.Reset();
+    NumExpanded = 0;
+    if (Start == INDEX_NONE)
+    {
+        return false;
+    }
+
+    const int32 Found = SearchBreadthFirst(Grid, Start, [&Grid, Flag](int32 Index) { return Grid.HasFlagAt(Index, Flag); });
+    if (Found == INDEX_NONE)
+    {
+        return false;
+    }
+    BuildPath(Start, Found, OutPath);
+    return true;
+}
+
+int32 FSnakePathfinder::JumpVertical(const FSnakeGrid& Grid, int32 From, int32 Direction, int32 Goal) const
+{
+    using namespace SnakePathfinder;
+
+    for (int32 Current = From; ; )
+    {
+        const int32 Next = Grid.GetNeighbour(Current, Direction);
+        if (IsBlocked(Grid, Next))
+        {
+            return INDEX_NONE;
+        }
+        if (Next == Goal)
+        {
+            return Next;
+        }
+
+        // Forced neighbour: the side is open here but wasn't one step back.
+        for (const int32 Side : { 1, 3 })
+        {
+            if (!IsBlocked(Grid, Grid.GetNeighbour(Next, Side)) && IsBlocked(Grid, Grid.GetNeighbour(Current, Side)))
+            {
+                return Next;
+            }
+        }
+        Current = Next;
+    }
+}
+
+int32 FSnakePathfinder::JumpHorizontal(const FSnakeGrid& Grid, int32 From, int32 Direction, int32 Goal) const
+{
+    using namespace SnakePathfinder;
+
+    for (int32 Current = From; ; )
+    {
+        const int32 Next = Grid.GetNeighbour(Current, Direction);
+        if (IsBlocked(Grid, Next))
+        {
+            return INDEX_NONE;
+        }
+        if (Next == Goal
+            || JumpVertical(Grid, Next, 0, Goal) != INDEX_NONE
+            || JumpVertical(Grid, Next, 2, Goal) != INDEX_NONE)
+        {
+            return Next;
+        }
+        Current = Next;
+    }
+}
+
+void FSnakePathfinder::ExpandJumpPoint(const FSnakeGrid& Grid, int32 From, int32 Direction, int32 Goal, uint32 Mark)
+{
+    const int32 JumpPoint = SnakePathfinder::IsHorizontal(Direction)
+        ? JumpHorizontal(Grid, From, Direction, Goal)
+        : JumpVertical(Grid, From, Direction, Goal);
+    if (JumpPoint == INDEX_NONE)
+    {
+        return;
+    }
+
+    const int32 SizeY = Grid.GetSizeY();
+    const int32 NewDistance = Distance[From] + SnakePathfinder::GetManhattanDistance(From, JumpPoint, SizeY);
+    const uint8 Entry = uint8(1 << Direction);
+    if (Visited[JumpPoint] == Mark)
+    {
+        // Equally short from another direction still has to be expanded for the turns it allows.
+        if (Distance[JumpPoint] < NewDistance || (Distance[JumpPoint] == NewDistance && (EntryMask[JumpPoint] & Entry)))
+        {
+            return;
+        }
+    }
+
+    if (Visited[JumpPoint] != Mark || NewDistance < Distance[JumpPoint])
+    {
+        Visited[JumpPoint] = Mark;
+        Distance[JumpPoint] = NewDistance;
+        Parent[JumpPoint] = From;
+        EnteredFrom[JumpPoint] = uint8(Direction);
+        EntryMask[JumpPoint] = 0;
+    }
+    EntryMask[JumpPoint] |= Entry;
+    Open.HeapPush({ NewDistance + SnakePathfinder::GetManhattanDistance(JumpPoint, Goal, SizeY), NewDistance, JumpPoint, Entry },
+                  SnakePathfinder::FOpenNodeOrder());
+}
+
+bool FSnakePathfinder::FindPathJumpPoint(const FSnakeGrid& Grid, int32 Start, int32 Goal, TArray<int32>& OutPath)
+{
+    using namespace SnakePathfinder;
+
+    OutPath.Reset();
+    NumExpanded = 0;
+    if (Start == INDEX_NONE || Goal == INDEX_NONE || !Grid.IsWalkableAt(Goal))
+    {
+        return false;
+    }
+
+    Reserve(Grid.Num());
+    const uint32 Mark = NextGeneration();
+
+    Open.Reset();
+    Visited[Start] = Mark;
+    Distance[Start] = 0;
+    Parent[Start] = Start;
+    EntryMask[Start] = StartEntry;
+    Open.HeapPush({ GetManhattanDistance(Start, Goal, Grid.GetSizeY()), 0, Start, StartEntry }, FOpenNodeOrder());
+
+    bool bFound = Start == Goal;
+    while (!bFound && Open.Num() > 0)
+    {
+        FOpenNode Node;
+        Open.HeapPop(Node, FOpenNodeOrder(), EAllowShrinking::No);
+        if (Node.Distance != Distance[Node.Index])
+        {
+            continue;
+        }
+        NumExpanded++;
+
+        const int32 Current = Node.Index;
+        if (Current == Goal)
+        {
+            bFound = true;
+            break;
+        }
+
+        if (Node.Entries & StartEntry)
+        {
+            for (int32 Dir = 0; Dir < FSnakeGrid::NumDirections; Dir++)
+            {
+                ExpandJumpPoint(Grid, Current, Dir, Goal, Mark);
+            }
+            continue;
+        }
+
+        for (int32 Entered = 0; Entered < FSnakeGrid::NumDirections; Entered++)
+        {
+            if (!(Node.Entries & (1 << Entered)))
+            {
+                continue;
+            }
+
+            ExpandJumpPoint(Grid, Current, Entered, Goal, Mark);
+            if (IsHorizontal(Entered))
+            {
+                // Turning vertical is natural anywhere along a horizontal run.
+                ExpandJumpPoint(Grid, Current, 0, Goal, Mark);
+                ExpandJumpPoint(Grid, Current, 2, Goal, Mark);
+            }
+            else
+            {
+                // Only forced turns, the others are covered by runs that turned earlier.
+                const int32 Back = Grid.GetNeighbour(Current, (Entered + 2) % FSnakeGrid::NumDirections);
+                for (const int32 Side : { 1, 3 })
+                {
+                    if (IsBlocked(Grid, Back == INDEX_NONE ? INDEX_NONE : Grid.GetNeighbour(Back, Side)))
+                    {
+                        ExpandJumpPoint(Grid, Current, Side, Goal, Mark);
+                    }
+                }
+            }
+        }
+    }
+
+    if (!bFound)
+    {
+        return false;
+    }
+
+    // Jump points are joined by straight runs, walk them back cell by cell.
+    for (int32 At = Goal; At != Start; At = Parent[At])
+    {
+        const int32 Backwards = (EnteredFrom[At] + 2) % FSnakeGrid::NumDirections;
+        for (int32 Cell = At; Cell != Parent[At]; Cell = Grid.GetNeighbour(Cell, Backwards))
+        {
+            OutPath.Add(Cell);
+        }
+    }
+    OutPath.Add(Start);
+    Algo::Reverse(OutPath);
+    return true;
+}
+
+SIZE_T FSnakePathfinder::GetAllocatedSize() const
+{
+    return Frontier.GetAllocatedSize() + Parent.GetAllocatedSize() + Visited.GetAllocatedSize()
+        + Distance.GetAllocatedSize() + EnteredFrom.GetAllocatedSize() + EntryMask.GetAllocatedSize()
+        + Open.GetAllocatedSize();
+}
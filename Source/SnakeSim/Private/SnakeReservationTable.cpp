@@ -0,0 +1,255 @@
+#include "SnakeReservationTable.h"
+
+#include "Algo/Reverse.h"
+#include "SnakeGrid.h"
+
+void FSnakeReservationTable::Reset(int32 NumCells)
+{
+    if (VacatedStep.Num() != NumCells)
+    {
+        VacatedStep.Init(0, NumCells);
+    }
+    else
+    {
+        for (const int32 Index : BodyCells)
+        {
+            VacatedStep[Index] = 0;
+        }
+    }
+    BodyCells.Reset();
+    Claims.Reset();
+    OwnerCells.Reset();
+}
+
+void FSnakeReservationTable::AddBody(TConstArrayView<int32> Body)
+{
+    // The last cell is left after the first step, the head's after all of them
+    for (int32 i = 0; i < Body.Num(); i++)
+    {
+        const int32 Index = Body[i];
+        if (!VacatedStep.IsValidIndex(Index))
+            continue;
+
+        const uint16 Step = uint16(FMath::Min(Body.Num() - i, int32(MAX_uint16)));
+        if (VacatedStep[Index] == 0)
+        {
+            BodyCells.Add(Index);
+        }
+        VacatedStep[Index] = FMath::Max(VacatedStep[Index], Step);
+    }
+}
+
+void FSnakeReservationTable::Add(int32 Index, int32 Step, int32 Owner)
+{
+    if (!VacatedStep.IsValidIndex(Index))
+        return;
+
+    TArray<FClaim, TInlineAllocator<2>>& CellClaims = Claims.FindOrAdd(Index);
+    for (FClaim& Claim : CellClaims)
+    {
+        // Only the first time a head gets to a cell matters, the body holds it after that
+        if (Claim.Owner == Owner)
+        {
+            Claim.Step = FMath::Min(Claim.Step, Step);
+            return;
+        }
+    }
+    CellClaims.Add({ Step, Owner });
+    OwnerCells.FindOrAdd(Owner).Add(Index);
+}
+
+void FSnakeReservationTable::Reserve(TConstArrayView<int32> Path, int32 Owner)
+{
+    Release(Owner);
+
+    // Path[0] is the head, already a body cell
+    const int32 NumSteps = FMath::Min(Path.Num(), MaxSteps + 1);
+    for (int32 Step = 1; Step < NumSteps; Step++)
+    {
+        Add(Path[Step], Step, Owner);
+    }
+}
+
+void FSnakeReservationTable::ReserveAhead(const FSnakeGrid& Grid, int32 Head, int32 Direction, int32 Owner, int32 NumSteps)
+{
+    Release(Owner);
+    if (Head == INDEX_NONE || NumSteps <= 0)
+        return;
+
+    // Nobody knows which way a player turns, anything but back is possible on the next tile
+    const int32 Back = Direction != INDEX_NONE ? (Direction + 2) % FSnakeGrid::NumDirections : INDEX_NONE;
+    for (int32 Turn = 0; Turn < FSnakeGrid::NumDirections; Turn++)
+    {
+        const int32 Next = Grid.GetNeighbour(Head, Turn);
+        if (Turn != Back && Next != INDEX_NONE && Grid.IsWalkableAt(Next))
+        {
+            Add(Next, 1, Owner);
+        }
+    }
+
+    int32 Current = Direction != INDEX_NONE ? Grid.GetNeighbour(Head, Direction) : INDEX_NONE;
+    if (Current == INDEX_NONE || !Grid.IsWalkableAt(Current))
+        return;
+
+    for (int32 Step = 2; Step <= FMath::Min(NumSteps, MaxSteps); Step++)
+    {
+        Current = Grid.GetNeighbour(Current, Direction);
+        if (Current == INDEX_NONE || !Grid.IsWalkableAt(Current))
+            break;
+        Add(Current, Step, Owner);
+    }
+}
+
+void FSnakeReservationTable::Release(int32 Owner)
+{
+    TArray<int32> Cells;
+    if (!OwnerCells.RemoveAndCopyValue(Owner, Cells))
+        return;
+
+    for (const int32 Index : Cells)
+    {
+        TArray<FClaim, TInlineAllocator<2>>* CellClaims = Claims.Find(Index);
+        if (!CellClaims)
+            continue;
+
+        CellClaims->RemoveAllSwap([Owner](const FClaim& Claim) { return Claim.Owner == Owner; }, EAllowShrinking::No);
+        if (CellClaims->IsEmpty())
+        {
+            Claims.Remove(Index);
+        }
+    }
+}
+
+int32 FSnakeReservationTable::GetReservation(int32 Index, int32 Step) const
+{
+    if (const TArray<FClaim, TInlineAllocator<2>>* CellClaims = Claims.Find(Index))
+    {
+        for (const FClaim& Claim : *CellClaims)
+        {
+            if (Claim.Step == Step)
+                return Claim.Owner;
+        }
+    }
+    return INDEX_NONE;
+}
+
+bool FSnakeReservationTable::IsClaimedByOther(int32 Index, int32 Step, int32 Owner) const
+{
+    if (const TArray<FClaim, TInlineAllocator<2>>* CellClaims = Claims.Find(Index))
+    {
+        for (const FClaim& Claim : *CellClaims)
+        {
+            if (Claim.Owner != Owner && Claim.Step <= Step)
+                return true;
+        }
+    }
+    return false;
+}
+
+bool FSnakeSpaceTimeSearch::FindPath(const FSnakeGrid& Grid, const FSnakeReservationTable& Table, int32 Start, int32 Goal, int32 Owner,
+                                     int32 BackDirection, int32 BodyLength, int32 Horizon, TArray<int32>& OutPath)
+{
+    OutPath.Reset();
+    Nodes.Reset();
+    if (Start < 0 || Start >= Grid.Num())
+        return false;
+
+    Horizon = FMath::Clamp(Horizon, 1, FSnakeReservationTable::MaxSteps);
+    if (Seen.Num() != Grid.Num() || SeenBase > MAX_uint32 - uint32(2 * (Horizon + 1)))
+    {
+        Seen.Init(0, Grid.Num());
+        SeenBase = 0;
+    }
+    SeenBase += uint32(Horizon + 1);
+
+    const int32 GoalRow = Goal != INDEX_NONE ? Goal / Grid.GetSizeY() : 0;
+    const int32 GoalColumn = Goal != INDEX_NONE ? Goal % Grid.GetSizeY() : 0;
+    auto GetDistance = [&Grid, Goal, GoalRow, GoalColumn](int32 Index)
+    {
+        return Goal != INDEX_NONE ? FMath::Abs(Index / Grid.GetSizeY() - GoalRow) + FMath::Abs(Index % Grid.GetSizeY() - GoalColumn) : 0;
+    };
+
+    Nodes.Add({ Start, INDEX_NONE });
+    Seen[Start] = SeenBase;
+
+    // Best partial path: deepest step first, then closest to the goal
+    int32 Best = INDEX_NONE;
+    int32 BestStep = 0;
+    int32 BestDistance = MAX_int32;
+
+    int32 LayerStart = 0;
+    for (int32 Step = 0; Step < Horizon; Step++)
+    {
+        const int32 LayerEnd = Nodes.Num();
+        const uint32 NextStamp = SeenBase + uint32(Step + 1);
+        for (int32 NodeIndex = LayerStart; NodeIndex < LayerEnd; NodeIndex++)
+        {
+            const int32 Cell = Nodes[NodeIndex].Cell;
+            const int32 Parent = Nodes[NodeIndex].Parent;
+            const int32 CameFrom = Parent != INDEX_NONE ? Nodes[Parent].Cell : INDEX_NONE;
+            for (int32 Direction = 0; Direction < FSnakeGrid::NumDirections; Direction++)
+            {
+                if (Step == 0 && Direction == BackDirection)
+                    continue;
+
+                const int32 Next = Grid.GetNeighbour(Cell, Direction);
+                if (Next == INDEX_NONE || Next == CameFrom || Seen[Next] == NextStamp || !Grid.IsWalkableAt(Next))
+                    continue;
+
+                // The live grid for the next tile. After that bodies must be gone a step before we get there,
+                // snakes aren't in step with each other and the step counts are only good to a tile.
+                if (Step == 0 ? !Grid.IsFreeAt(Next) : Step + 1 <= Table.GetVacatedStep(Next))
+                    continue;
+                if (Table.IsClaimedByOther(Next, Step + 1, Owner))
+                    continue;
+                // The body we started with is in the table, the cells the path put it on since aren't
+                if (IsUnderOwnBody(NodeIndex, Next, BodyLength))
+                    continue;
+
+                Seen[Next] = NextStamp;
+                const int32 NextNode = Nodes.Add({ Next, NodeIndex });
+                if (Next == Goal)
+                {
+                    BuildPath(NextNode, OutPath);
+                    return true;
+                }
+
+                const int32 Distance = GetDistance(Next);
+                if (Step + 1 > BestStep || Distance < BestDistance)
+                {
+                    Best = NextNode;
+                    BestStep = Step + 1;
+                    BestDistance = Distance;
+                }
+            }
+        }
+        if (Nodes.Num() == LayerEnd)
+            break;
+        LayerStart = LayerEnd;
+    }
+
+    if (Best != INDEX_NONE)
+    {
+        BuildPath(Best, OutPath);
+    }
+    return false;
+}
+
+bool FSnakeSpaceTimeSearch::IsUnderOwnBody(int32 Node, int32 Cell, int32 BodyLength) const
+{
+    for (int32 Covered = 0; Node != INDEX_NONE && Covered < BodyLength; Node = Nodes[Node].Parent, Covered++)
+    {
+        if (Nodes[Node].Cell == Cell)
+            return true;
+    }
+    return false;
+}
+
+void FSnakeSpaceTimeSearch::BuildPath(int32 Node, TArray<int32>& OutPath) const
+{
+    for (; Node != INDEX_NONE; Node = Nodes[Node].Parent)
+    {
+        OutPath.Add(Nodes[Node].Cell);
+    }
+    Algo::Reverse(OutPath);
+}
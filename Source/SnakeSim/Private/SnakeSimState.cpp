@@ -0,0 +1,302 @@
+#include "SnakeSimState.h"
+
+#include "SnakeGrid.h"
+
+void FSnakeSimState::Init(const FSnakeGrid& Grid)
+{
+    static_assert(OccupantMask == FSnakeGrid::OccupantMask, "Cells use FSnakeGrid's occupant count");
+
+    SizeX = Grid.GetSizeX();
+    SizeY = Grid.GetSizeY();
+    Cells.SetNumUninitialized(Grid.Num());
+    FoodCells.Reset();
+
+    TSharedPtr<TArray<int32>> Floor = MakeShared<TArray<int32>>();
+    Floor->Reserve(Grid.GetNumWalkable());
+    for (int32 Index = 0; Index < Grid.Num(); Index++)
+    {
+        uint8 Flags = 0;
+        if (Grid.IsWalkableAt(Index))
+        {
+            Flags |= Walkable;
+            Floor->Add(Index);
+        }
+        if (Grid.HasFlagAt(Index, ESnakeCell::Food))
+        {
+            Flags |= Food;
+            FoodCells.Add(Index);
+        }
+        Cells[Index] = Flags;
+    }
+    FloorCells = MoveTemp(Floor);
+
+    Capacity = MinCapacity;
+    Snakes.Reset();
+    Bodies.Reset();
+    FreeSnakes.Reset();
+    NumAlive = 0;
+}
+
+int32 FSnakeSimState::AddSnake(TConstArrayView<int32> Body, int32 Direction, int32 Growth)
+{
+    if ((Snakes.Num() == MaxSnakes && FreeSnakes.Num() == 0) || Body.Num() == 0 || !Cells.IsValidIndex(Body[0]))
+        return INDEX_NONE;
+
+    int32 Snake = INDEX_NONE;
+    if (FreeSnakes.Num() > 0)
+    {
+        Snake = FreeSnakes.Pop(EAllowShrinking::No);
+        Snakes[Snake] = FSnake();
+    }
+    else
+    {
+        Snake = Snakes.AddDefaulted();
+        Bodies.AddZeroed(Capacity);
+    }
+    ReserveLength(Body.Num());
+
+    FSnake& State = Snakes[Snake];
+    State.Direction = Direction;
+    State.Growth = Growth;
+    for (const int32 Index : Body)
+    {
+        if (!Cells.IsValidIndex(Index))
+            break;
+        Bodies[Snake * Capacity + State.Length++] = Index;
+        FSnakeGrid::AddOccupantTo(Cells[Index]);
+    }
+    NumAlive++;
+    return Snake;
+}
+
+void FSnakeSimState::RemoveSnake(int32 Snake)
+{
+    if (!Snakes.IsValidIndex(Snake) || FreeSnakes.Contains(Snake))
+        return;
+
+    Kill(Snake);
+    FreeSnakes.Add(Snake);
+}
+
+void FSnakeSimState::ReserveLength(int32 Length)
+{
+    if (Length <= Capacity)
+        return;
+
+    // Unrolled into the bigger blocks with every head at the front of its own
+    const int32 NewCapacity = int32(FMath::RoundUpToPowerOfTwo(uint32(Length)));
+    TArray<int32> NewBodies;
+    NewBodies.SetNumZeroed(Snakes.Num() * NewCapacity);
+    for (int32 Snake = 0; Snake < Snakes.Num(); Snake++)
+    {
+        for (int32 Offset = 0; Offset < Snakes[Snake].Length; Offset++)
+        {
+            NewBodies[Snake * NewCapacity + Offset] = GetBodyCell(Snake, Offset);
+        }
+        Snakes[Snake].Head = 0;
+    }
+    Bodies = MoveTemp(NewBodies);
+    Capacity = NewCapacity;
+}
+
+void FSnakeSimState::SetFood(int32 Index, bool bHasFood)
+{
+    if (!Cells.IsValidIndex(Index) || bHasFood == ((Cells[Index] & Food) != 0))
+        return;
+
+    if (bHasFood)
+    {
+        Cells[Index] |= Food;
+        FoodCells.Add(Index);
+    }
+    else
+    {
+        Cells[Index] &= ~Food;
+        FoodCells.RemoveSingleSwap(Index, EAllowShrinking::No);
+    }
+}
+
+int32 FSnakeSimState::GetNeighbour(int32 Index, int32 Direction) const
+{
+    const int32 Column = Index % SizeY;
+    switch (Direction)
+    {
+    case 0: return Index + SizeY < Cells.Num() ? Index + SizeY : INDEX_NONE;
+    case 1: return Column + 1 < SizeY ? Index + 1 : INDEX_NONE;
+    case 2: return Index >= SizeY ? Index - SizeY : INDEX_NONE;
+    case 3: return Column > 0 ? Index - 1 : INDEX_NONE;
+    default: return INDEX_NONE;
+    }
+}
+
+void FSnakeSimState::Step(TConstArrayView<int32> Moves, FRandomStream& Random)
+{
+    StepSnakes(Moves, &Random);
+}
+
+void FSnakeSimState::Step(TConstArrayView<int32> Moves)
+{
+    StepSnakes(Moves, nullptr);
+}
+
+void FSnakeSimState::StepSnakes(TConstArrayView<int32> Moves, FRandomStream* Random)
+{
+    int32 NewHeads[MaxSnakes];
+    bool bDies[MaxSnakes];
+    int32 LongestBody = 0;
+    for (int32 Snake = 0; Snake < Snakes.Num(); Snake++)
+    {
+        FSnake& State = Snakes[Snake];
+        NewHeads[Snake] = INDEX_NONE;
+        bDies[Snake] = false;
+        if (!State.bAlive)
+            continue;
+
+        const int32 Back = State.Direction != INDEX_NONE ? (State.Direction + 2) % FSnakeGrid::NumDirections : INDEX_NONE;
+        const int32 Move = Moves.IsValidIndex(Snake) ? Moves[Snake] : INDEX_NONE;
+        if (Move >= 0 && Move < FSnakeGrid::NumDirections && Move != Back)
+        {
+            State.Direction = Move;
+        }
+        // A snake that hasn't started moving stays where it is
+        if (State.Direction == INDEX_NONE)
+            continue;
+
+        NewHeads[Snake] = GetNeighbour(GetHead(Snake), State.Direction);
+        bDies[Snake] = NewHeads[Snake] == INDEX_NONE;
+
+        // Tails move on before heads arrive, a head may take the cell a tail just left
+        if (State.Growth > 0)
+        {
+            State.Growth--;
+        }
+        else if (State.Length > 0)
+        {
+            FSnakeGrid::RemoveOccupantFrom(Cells[GetBodyCell(Snake, State.Length - 1)]);
+            State.Length--;
+        }
+        LongestBody = FMath::Max(LongestBody, State.Length);
+    }
+
+    // Every head is about to be added in front of its body
+    ReserveLength(LongestBody + 1);
+
+    for (int32 Snake = 0; Snake < Snakes.Num(); Snake++)
+    {
+        const int32 NewHead = NewHeads[Snake];
+        if (NewHead == INDEX_NONE)
+            continue;
+
+        bDies[Snake] |= IsBlocked(NewHead);
+        for (int32 Other = Snake + 1; Other < Snakes.Num(); Other++)
+        {
+            if (NewHeads[Other] == NewHead)
+            {
+                bDies[Snake] = true;
+                bDies[Other] = true;
+            }
+        }
+    }
+
+    for (int32 Snake = 0; Snake < Snakes.Num(); Snake++)
+    {
+        if (bDies[Snake])
+        {
+            Kill(Snake);
+            continue;
+        }
+
+        const int32 NewHead = NewHeads[Snake];
+        if (NewHead == INDEX_NONE)
+            continue;
+
+        FSnake& State = Snakes[Snake];
+        State.Head = (State.Head - 1) & (Capacity - 1);
+        State.Length++;
+        Bodies[Snake * Capacity + State.Head] = NewHead;
+        FSnakeGrid::AddOccupantTo(Cells[NewHead]);
+
+        if (Cells[NewHead] & Food)
+        {
+            Cells[NewHead] &= ~Food;
+            FoodCells.RemoveSingleSwap(NewHead, EAllowShrinking::No);
+            State.FoodEaten++;
+            State.Growth++;
+            if (Random)
+            {
+                SpawnFood(*Random);
+            }
+        }
+    }
+}
+
+void FSnakeSimState::Kill(int32 Snake)
+{
+    FSnake& State = Snakes[Snake];
+    if (!State.bAlive)
+        return;
+
+    for (int32 Offset = 0; Offset < State.Length; Offset++)
+    {
+        FSnakeGrid::RemoveOccupantFrom(Cells[GetBodyCell(Snake, Offset)]);
+    }
+    State.Length = 0;
+    State.bAlive = false;
+    NumAlive--;
+}
+
+void FSnakeSimState::SpawnFood(FRandomStream& Random)
+{
+    const TArray<int32>& Floor = *FloorCells;
+    for (int32 Try = 0; Try < FoodSpawnTries && Floor.Num() > 0; Try++)
+    {
+        const int32 Index = Floor[Random.RandHelper(Floor.Num())];
+        if (Cells[Index] == Walkable)
+        {
+            Cells[Index] |= Food;
+            FoodCells.Add(Index);
+            return;
+        }
+    }
+}
+
+int32 FSnakeSimState::GetSafeMoves(int32 Snake, int32 (&OutMoves)[4]) const
+{
+    const FSnake& State = Snakes[Snake];
+    if (!State.bAlive)
+        return 0;
+
+    // The tail end moves away as we move, unless we've just eaten
+    const int32 Head = GetHead(Snake);
+    const int32 Tail = State.Growth == 0 && State.Length > 1 ? GetBodyCell(Snake, State.Length - 1) : INDEX_NONE;
+    const int32 Back = State.Direction != INDEX_NONE ? (State.Direction + 2) % FSnakeGrid::NumDirections : INDEX_NONE;
+
+    int32 NumMoves = 0;
+    for (int32 Direction = 0; Direction < FSnakeGrid::NumDirections; Direction++)
+    {
+        const int32 Next = GetNeighbour(Head, Direction);
+        if (Direction == Back || Next == INDEX_NONE)
+            continue;
+        if (!IsBlocked(Next) || (Next == Tail && (Cells[Next] >> FSnakeGrid::OccupantShift) == 1))
+        {
+            OutMoves[NumMoves++] = Direction;
+        }
+    }
+    return NumMoves;
+}
+
+int32 FSnakeSimState::FindNearestFood(int32 From) const
+{
+    int32 Nearest = INDEX_NONE;
+    int32 BestDistance = MAX_int32;
+    for (const int32 Index : FoodCells)
+    {
+        const int32 Distance = GetDistance(From, Index);
+        if (Distance < BestDistance)
+        {
+            BestDistance = Distance;
+            Nearest = Index;
+        }
+    }
+    return Nearest;
+}
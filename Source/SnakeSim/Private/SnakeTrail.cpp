@@ -0,0 +1,103 @@
+#include "SnakeTrail.h"
+
+void FSnakeTrail::Reset(const FVector& Head)
+{
+    Points.Reset();
+    Points.PushLast({ Head, 0.0 });
+}
+
+void FSnakeTrail::Add(const FVector& Head)
+{
+    if (Points.Num() == 0)
+    {
+        Reset(Head);
+        return;
+    }
+
+    const FPoint Last = Points.Last();
+    const double Step = FVector::Dist(Last.Position, Head);
+    if (Step < KINDA_SMALL_NUMBER)
+        return;
+
+    // Still going the same way along the last line, move its end instead of adding a point
+    if (Points.Num() >= 2)
+    {
+        const FPoint& Before = Points[Points.Num() - 2];
+        const FVector Line = Last.Position - Before.Position;
+        const double LineLength = Line.Size();
+        const FVector Offset = Head - Before.Position;
+        const double Along = LineLength > 0.0 ? (Offset | Line) / LineLength : 0.0;
+        if (Along >= LineLength && (Offset - Line * (Along / LineLength)).SizeSquared() <= Tolerance * Tolerance)
+        {
+            FPoint& End = Points.Last();
+            End.Position = Head;
+            End.Distance = Before.Distance + Offset.Size();
+            return;
+        }
+    }
+    Points.PushLast({ Head, Last.Distance + Step });
+}
+
+void FSnakeTrail::Trim(double Length)
+{
+    // The first point stays as long as the second one is still short of Length
+    const double Keep = Points.Num() > 0 ? Points.Last().Distance - Length : 0.0;
+    while (Points.Num() >= 2 && Points[1].Distance <= Keep)
+    {
+        Points.PopFirst();
+    }
+}
+
+FVector FSnakeTrail::Interpolate(int32 Index, double Distance) const
+{
+    // Between Points[Index - 1] and Points[Index]
+    const FPoint& From = Points[Index - 1];
+    const FPoint& To = Points[Index];
+    const double Length = To.Distance - From.Distance;
+    return Length > 0.0 ? FMath::Lerp(From.Position, To.Position, (Distance - From.Distance) / Length) : To.Position;
+}
+
+FVector FSnakeTrail::GetPointBehind(double Distance) const
+{
+    if (Points.Num() == 0)
+        return FVector::ZeroVector;
+
+    const double Target = Points.Last().Distance - Distance;
+    if (Target <= Points.First().Distance)
+        return Points.First().Position;
+
+    // First point at or past Target
+    int32 Low = 1;
+    int32 High = Points.Num() - 1;
+    while (Low < High)
+    {
+        const int32 Middle = (Low + High) / 2;
+        if (Points[Middle].Distance < Target)
+            Low = Middle + 1;
+        else
+            High = Middle;
+    }
+    return Interpolate(Low, Target);
+}
+
+void FSnakeTrail::Sample(double Spacing, int32 Count, TArray<FVector>& OutPoints) const
+{
+    OutPoints.Reset(Count);
+    if (Points.Num() == 0)
+    {
+        OutPoints.Init(FVector::ZeroVector, Count);
+        return;
+    }
+
+    // Targets only get further back, so the line we're on only moves towards the front
+    int32 Index = Points.Num() - 1;
+    for (int32 i = 1; i <= Count; i++)
+    {
+        const double Target = Points.Last().Distance - i * Spacing;
+        while (Index > 0 && Points[Index - 1].Distance > Target)
+        {
+            Index--;
+        }
+        OutPoints.Add(Index > 0 ? Interpolate(Index, Target) : Points.First().Position);
+    }
+}
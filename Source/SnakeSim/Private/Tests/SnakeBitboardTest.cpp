@@ -0,0 +1,109 @@
+#include "Misc/AutomationTest.h"
+#include "SnakeBitboard.h"
+#include "SnakeSimTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace SnakeSimTest
+{
+    /** Fills from a few free cells and checks the count and every cell's reached bit against breadth first search. */
+    static void CheckFills(FAutomationTestBase& Test, const FString& What, const FSnakeGrid& Grid, FSnakeBitboard& Bitboard, FRandomStream& Random)
+    {
+        TArray<int32> Distances;
+        for (int32 Fill = 0; Fill < 8; Fill++)
+        {
+            const int32 Start = Random.RandHelper(Grid.Num());
+            if (!Grid.IsFreeAt(Start))
+            {
+                Test.TestEqual(*FString::Printf(TEXT("%s: nothing from a blocked cell"), *What), Bitboard.FillFrom(Start), 0);
+                continue;
+            }
+
+            GetDistances(Grid, Start, Distances);
+            int32 Reachable = 0;
+            bool bSameCells = true;
+            const int32 Count = Bitboard.FillFrom(Start);
+            for (int32 Index = 0; Index < Grid.Num(); Index++)
+            {
+                Reachable += Distances[Index] != INDEX_NONE ? 1 : 0;
+                bSameCells &= Bitboard.IsReached(Index) == (Distances[Index] != INDEX_NONE);
+            }
+            Test.TestEqual(*FString::Printf(TEXT("%s: cells reached from %d"), *What, Start), Count, Reachable);
+            Test.TestTrue(*FString::Printf(TEXT("%s: same cells reached from %d"), *What, Start), bSameCells);
+
+            // A limit stops the fill early, but never short of the limit
+            const int32 Limit = FMath::Max(Reachable / 2, 1);
+            const int32 Limited = Bitboard.FillFrom(Start, Limit);
+            Test.TestTrue(*FString::Printf(TEXT("%s: limited fill from %d"), *What, Start), Limited >= Limit && Limited <= Reachable);
+        }
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeBitboardFillTest, "SnakeGame.SnakeSim.Bitboard.Fill", SnakeSimTest::Flags)
+
+bool FSnakeBitboardFillTest::RunTest(const FString& Parameters)
+{
+    // Rows of one, two and three words, dense enough to cut the level into pockets
+    FRandomStream Random(9);
+    for (const int32 Size : { 40, 100, 130 })
+    {
+        const FSnakeGrid Grid = SnakeSimTest::MakeRandomGrid(Size, 0.35f, Size);
+        FSnakeBitboard Bitboard;
+        Bitboard.Build(Grid);
+        SnakeSimTest::CheckFills(*this, FString::Printf(TEXT("%dx%d"), Size, Size), Grid, Bitboard, Random);
+    }
+
+    // One open corridor along a row, across the word boundary
+    const FSnakeGrid Corridor = SnakeSimTest::MakeGrid({
+        TEXT("######################################################################"),
+        TEXT("#....................................................................#"),
+        TEXT("######################################################################"),
+    });
+    FSnakeBitboard Bitboard;
+    Bitboard.Build(Corridor);
+    TestEqual(TEXT("Whole corridor"), Bitboard.FillFrom(Corridor.ToIndex(SnakeSimTest::CellAt(Corridor, 1, 1))), 68);
+    TestTrue(TEXT("Far end reached"), Bitboard.IsReached(Corridor.ToIndex(SnakeSimTest::CellAt(Corridor, 1, 68))));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeBitboardSyncTest, "SnakeGame.SnakeSim.Bitboard.Sync", SnakeSimTest::Flags)
+
+bool FSnakeBitboardSyncTest::RunTest(const FString& Parameters)
+{
+    // Bodies come and go through the journal, fills follow them without a rebuild
+    FSnakeGrid Grid = SnakeSimTest::MakeRandomGrid(100, 0.15f, 4);
+    FSnakeGridJournal Journal;
+    FSnakeBitboard Bitboard;
+    Bitboard.Sync(Grid, Journal);
+
+    FRandomStream Random(2);
+    TArray<int32> Occupied;
+    for (int32 Round = 0; Round < 6; Round++)
+    {
+        for (int32 Change = 0; Change < 200; Change++)
+        {
+            const int32 Cell = Random.RandHelper(Grid.Num());
+            if (Occupied.Num() > 0 && Random.FRand() < 0.3f)
+            {
+                SnakeSimTest::SetOccupied(Grid, Journal, Occupied.Pop(), false);
+            }
+            else if (Grid.IsFreeAt(Cell))
+            {
+                SnakeSimTest::SetOccupied(Grid, Journal, Cell, true);
+                Occupied.Add(Cell);
+            }
+        }
+        Bitboard.Sync(Grid, Journal);
+
+        bool bSameFree = true;
+        for (int32 Index = 0; Index < Grid.Num(); Index++)
+        {
+            bSameFree &= Bitboard.IsFree(Index) == Grid.IsFreeAt(Index);
+        }
+        TestTrue(*FString::Printf(TEXT("Round %d free cells"), Round), bSameFree);
+        SnakeSimTest::CheckFills(*this, FString::Printf(TEXT("Round %d"), Round), Grid, Bitboard, Random);
+    }
+    return true;
+}
+
+#endif
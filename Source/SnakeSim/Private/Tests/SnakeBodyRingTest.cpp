@@ -0,0 +1,130 @@
+#include "Misc/AutomationTest.h"
+#include "SnakeBodyRing.h"
+#include "SnakeSimTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeBodyRingOrderTest, "SnakeGame.SnakeSim.BodyRing.Order", SnakeSimTest::Flags)
+
+bool FSnakeBodyRingOrderTest::RunTest(const FString& Parameters)
+{
+    // Heads 1, 2, 3, ... growing on every other move, so the ring wraps and reallocates along the way
+    TSnakeBodyRing<int32> Body;
+    TArray<int32> Expected;
+    for (int32 Head = 1; Head <= 40; Head++)
+    {
+        Body.Advance(Head);
+        if (Expected.Num() > 0)
+        {
+            Expected.Insert(Head, 0);
+            Expected.Pop();
+        }
+        if (Head % 2 == 1)
+        {
+            Body.Grow(Head);
+            Expected.Add(Expected.Num() > 0 ? Expected.Last() : Head);
+        }
+
+        TArray<int32> Cells;
+        for (const int32 Cell : Body)
+        {
+            Cells.Add(Cell);
+        }
+        if (!TestTrue(FString::Printf(TEXT("Body after head %d"), Head), Cells == Expected))
+        {
+            break;
+        }
+    }
+    TestEqual(TEXT("Length"), Body.Num(), 20);
+    TestEqual(TEXT("First cell"), Body[0], 40);
+
+    Body.Reset();
+    TestTrue(TEXT("Empty after Reset"), Body.IsEmpty());
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeBodyRingGrowWithoutBodyTest, "SnakeGame.SnakeSim.BodyRing.GrowWithoutBody", SnakeSimTest::Flags)
+
+bool FSnakeBodyRingGrowWithoutBodyTest::RunTest(const FString& Parameters)
+{
+    FSnakeGrid Grid = SnakeSimTest::MakeGrid({
+        TEXT("######"),
+        TEXT("#....#"),
+        TEXT("######"),
+    });
+    const FIntPoint A = SnakeSimTest::CellAt(Grid, 1, 1);
+    const FIntPoint B = SnakeSimTest::CellAt(Grid, 1, 2);
+    const FIntPoint C = SnakeSimTest::CellAt(Grid, 1, 3);
+    const FIntPoint D = SnakeSimTest::CellAt(Grid, 1, 4);
+
+    FIntPoint Head = A;
+    TSnakeBodyRing<FIntPoint> Body;
+    Grid.AddOccupant(Head);
+
+    // First apple: the head just left A, that's where the new body cell goes
+    MoveSnake(Grid, Head, Body, B);
+    GrowSnake(Grid, A, Body);
+    TestEqual(TEXT("Body length after the first apple"), Body.Num(), 1);
+    TestTrue(TEXT("New body cell is the vacated cell"), Body.Last() == A);
+    TestEqual(TEXT("Occupants on the vacated cell"), Grid.GetOccupants(A), 1);
+    TestEqual(TEXT("Occupants on the head"), Grid.GetOccupants(B), 1);
+
+    MoveSnake(Grid, Head, Body, C);
+    TestEqual(TEXT("Occupants on the old tail end"), Grid.GetOccupants(A), 0);
+    TestEqual(TEXT("Occupants on the body"), Grid.GetOccupants(B), 1);
+    TestEqual(TEXT("Occupants on the head"), Grid.GetOccupants(C), 1);
+
+    // Second apple: the tail end B is doubled and stays put for one move
+    GrowSnake(Grid, B, Body);
+    TestEqual(TEXT("Occupants on the doubled tail end"), Grid.GetOccupants(B), 2);
+    MoveSnake(Grid, Head, Body, D);
+    TestEqual(TEXT("Body length after the second apple"), Body.Num(), 2);
+    TestTrue(TEXT("Tail end stayed put"), Body.Last() == B);
+    TestEqual(TEXT("Occupants on the tail end"), Grid.GetOccupants(B), 1);
+    TestEqual(TEXT("Occupants on the body"), Grid.GetOccupants(C), 1);
+    TestEqual(TEXT("Occupants on the head"), Grid.GetOccupants(D), 1);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeBodyRingFollowTailTest, "SnakeGame.SnakeSim.BodyRing.FollowTail", SnakeSimTest::Flags)
+
+bool FSnakeBodyRingFollowTailTest::RunTest(const FString& Parameters)
+{
+    FSnakeGrid Grid = SnakeSimTest::MakeGrid({
+        TEXT("####"),
+        TEXT("#..#"),
+        TEXT("#..#"),
+        TEXT("####"),
+    });
+    const FIntPoint Square[] = {
+        SnakeSimTest::CellAt(Grid, 1, 1), SnakeSimTest::CellAt(Grid, 1, 2),
+        SnakeSimTest::CellAt(Grid, 2, 2), SnakeSimTest::CellAt(Grid, 2, 1),
+    };
+
+    // Grows to fill the whole square going round it, then keeps going: the head always enters the
+    // cell the tail end leaves on the same move
+    FIntPoint Head = Square[0];
+    TSnakeBodyRing<FIntPoint> Body;
+    Grid.AddOccupant(Head);
+    for (int32 Move = 1; Move <= 12; Move++)
+    {
+        const FIntPoint Left = Head;
+        MoveSnake(Grid, Head, Body, Square[Move % 4]);
+        TestEqual(FString::Printf(TEXT("Occupants on the head after move %d"), Move), Grid.GetOccupants(Head), 1);
+        if (Body.Num() < 3)
+        {
+            GrowSnake(Grid, Left, Body);
+        }
+
+        int32 Occupants = 0;
+        for (const FIntPoint& Cell : Square)
+        {
+            Occupants += Grid.GetOccupants(Cell);
+        }
+        TestEqual(FString::Printf(TEXT("Occupants after move %d"), Move), Occupants, Body.Num() + 1);
+    }
+    TestEqual(TEXT("Body length"), Body.Num(), 3);
+    return true;
+}
+
+#endif
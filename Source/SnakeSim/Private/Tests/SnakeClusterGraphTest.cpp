@@ -0,0 +1,106 @@
+#include "Misc/AutomationTest.h"
+#include "SnakeClusterGraph.h"
+#include "SnakeSimTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeClusterGraphBreadthFirstTest, "SnakeGame.SnakeSim.ClusterGraph.BreadthFirst", SnakeSimTest::Flags)
+
+bool FSnakeClusterGraphBreadthFirstTest::RunTest(const FString& Parameters)
+{
+    // Four by four clusters. Without bodies every entrance is open, so HPA* finds whatever breadth first
+    // search finds, on a path a few moves longer at most.
+    FSnakeGrid Grid = SnakeSimTest::MakeRandomGrid(4 * FSnakeClusterGraph::ClusterSize, 0.2f, 3);
+    FSnakeGridJournal Journal;
+    FSnakeClusterGraph Graph;
+    Graph.Build(Grid, Journal);
+    TestTrue(TEXT("Built"), Graph.IsBuiltFor(Grid) && Graph.GetNumClusters() == 16);
+
+    TArray<int32> Free;
+    for (int32 Index = 0; Index < Grid.Num(); Index++)
+    {
+        if (Grid.IsFreeAt(Index))
+        {
+            Free.Add(Index);
+        }
+    }
+
+    FRandomStream Random(5);
+    TArray<int32> Path;
+    TArray<int32> Distances;
+    int64 TotalSteps = 0;
+    int64 TotalShortest = 0;
+    for (int32 Search = 0; Search < 50; Search++)
+    {
+        const int32 Start = Free[Random.RandHelper(Free.Num())];
+        const int32 Goal = Free[Random.RandHelper(Free.Num())];
+        SnakeSimTest::GetDistances(Grid, Start, Distances);
+
+        const bool bFound = Graph.FindPath(Grid, Journal, Start, Goal, Path);
+        TestTrue(*FString::Printf(TEXT("Search %d found as breadth first does"), Search), bFound == (Distances[Goal] != INDEX_NONE));
+        if (!bFound || Distances[Goal] == INDEX_NONE)
+        {
+            continue;
+        }
+        TestTrue(*FString::Printf(TEXT("Search %d valid path"), Search), SnakeSimTest::IsPathOnFreeCells(Grid, Path, Start, Goal));
+
+        const int32 Steps = Path.Num() - 1;
+        const int32 Shortest = Distances[Goal];
+        TestTrue(*FString::Printf(TEXT("Search %d no shorter than shortest (%d < %d)"), Search, Steps, Shortest), Steps >= Shortest);
+        TestTrue(*FString::Printf(TEXT("Search %d close to shortest (%d for %d)"), Search, Steps, Shortest), Steps <= Shortest + Shortest / 2 + FSnakeClusterGraph::ClusterSize);
+        TotalSteps += Steps;
+        TotalShortest += Shortest;
+    }
+    TestTrue(TEXT("Some searches found a way"), TotalShortest > 0);
+    TestTrue(*FString::Printf(TEXT("Within a tenth of shortest overall (%lld for %lld)"), TotalSteps, TotalShortest), TotalSteps * 10 <= TotalShortest * 11);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeClusterGraphBodiesTest, "SnakeGame.SnakeSim.ClusterGraph.Bodies", SnakeSimTest::Flags)
+
+bool FSnakeClusterGraphBodiesTest::RunTest(const FString& Parameters)
+{
+    // Two clusters side by side, a wall between them with a single gap in row 8
+    TArray<FString> Lines;
+    for (int32 Row = 0; Row < FSnakeClusterGraph::ClusterSize; Row++)
+    {
+        FString& Line = Lines.AddDefaulted_GetRef();
+        for (int32 Column = 0; Column < 2 * FSnakeClusterGraph::ClusterSize; Column++)
+        {
+            const bool bEdge = Row == 0 || Column == 0 || Row == FSnakeClusterGraph::ClusterSize - 1 || Column == 2 * FSnakeClusterGraph::ClusterSize - 1;
+            const bool bWall = Column == FSnakeClusterGraph::ClusterSize && Row != 8;
+            Line.AppendChar(bEdge || bWall ? TEXT('#') : TEXT('.'));
+        }
+    }
+    FSnakeGrid Grid = SnakeSimTest::MakeGrid(Lines);
+    FSnakeGridJournal Journal;
+    FSnakeClusterGraph Graph;
+    Graph.Build(Grid, Journal);
+
+    const int32 Start = Grid.ToIndex(SnakeSimTest::CellAt(Grid, 2, 2));
+    const int32 Goal = Grid.ToIndex(SnakeSimTest::CellAt(Grid, 2, 2 * FSnakeClusterGraph::ClusterSize - 3));
+    TArray<int32> Path;
+    TArray<int32> Distances;
+    SnakeSimTest::GetDistances(Grid, Start, Distances);
+    TestTrue(TEXT("Found through the gap"), Graph.FindPath(Grid, Journal, Start, Goal, Path));
+    TestTrue(TEXT("Valid path through the gap"), SnakeSimTest::IsPathOnFreeCells(Grid, Path, Start, Goal));
+    TestEqual(TEXT("Shortest through the gap"), Path.Num() - 1, Distances[Goal]);
+
+    // A body on the start cluster's side of the gap leaves no way through
+    const int32 Gap = Grid.ToIndex(SnakeSimTest::CellAt(Grid, 8, FSnakeClusterGraph::ClusterSize - 1));
+    SnakeSimTest::SetOccupied(Grid, Journal, Gap, true);
+    TestFalse(TEXT("Gap blocked"), Graph.FindPath(Grid, Journal, Start, Goal, Path));
+
+    // The gap frees up and a body lands off the way: the start cluster is dirty and refined on the search
+    SnakeSimTest::SetOccupied(Grid, Journal, Gap, false);
+    const int32 Aside = Grid.ToIndex(SnakeSimTest::CellAt(Grid, 12, 4));
+    SnakeSimTest::SetOccupied(Grid, Journal, Aside, true);
+    SnakeSimTest::GetDistances(Grid, Start, Distances);
+    TestTrue(TEXT("Found once freed"), Graph.FindPath(Grid, Journal, Start, Goal, Path));
+    TestTrue(TEXT("Dirty cluster refined"), Graph.GetNumRefined() > 0);
+    TestTrue(TEXT("Valid path once freed"), SnakeSimTest::IsPathOnFreeCells(Grid, Path, Start, Goal));
+    TestEqual(TEXT("Shortest once freed"), Path.Num() - 1, Distances[Goal]);
+    return true;
+}
+
+#endif
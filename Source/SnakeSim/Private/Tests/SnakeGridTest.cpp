@@ -0,0 +1,110 @@
+#include "Misc/AutomationTest.h"
+#include "SnakeGrid.h"
+#include "SnakeSimTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeGridInitTest, "SnakeGame.SnakeSim.Grid.Init", SnakeSimTest::Flags)
+
+bool FSnakeGridInitTest::RunTest(const FString& Parameters)
+{
+    const FSnakeGrid Grid = SnakeSimTest::MakeGrid({
+        TEXT("#####"),
+        TEXT("#..D#"),
+        TEXT("#. ##"),
+    });
+    TestEqual(TEXT("SizeX is the number of rows"), Grid.GetSizeX(), 3);
+    TestEqual(TEXT("SizeY is the longest row"), Grid.GetSizeY(), 5);
+    TestEqual(TEXT("Floor cells"), Grid.GetNumWalkable(), 3);
+
+    TestTrue(TEXT("Wall"), Grid.IsWall(SnakeSimTest::CellAt(Grid, 0, 0)));
+    TestTrue(TEXT("Floor"), Grid.IsWalkable(SnakeSimTest::CellAt(Grid, 1, 1)));
+    TestTrue(TEXT("Door"), Grid.IsDoor(SnakeSimTest::CellAt(Grid, 1, 3)));
+    TestFalse(TEXT("Doors aren't walkable"), Grid.IsWalkable(SnakeSimTest::CellAt(Grid, 1, 3)));
+    TestTrue(TEXT("Blank is empty"), Grid.GetFlags(SnakeSimTest::CellAt(Grid, 2, 2)) == ESnakeCell::None);
+
+    // Text row 0 is the far end of the level, +X
+    const int32 Near = Grid.ToIndex(SnakeSimTest::CellAt(Grid, 2, 1));
+    TestEqual(TEXT("Up from the near row"), Grid.GetNeighbour(Near, 0), Grid.ToIndex(SnakeSimTest::CellAt(Grid, 1, 1)));
+    TestEqual(TEXT("Right along the row"), Grid.GetNeighbour(Near, 1), Near + 1);
+    TestEqual(TEXT("Down off the grid"), Grid.GetNeighbour(Near, 2), int32(INDEX_NONE));
+    TestFalse(TEXT("Off the grid is empty space"), Grid.IsWalkable(Grid.GetOrigin() - FIntPoint(1, 1)));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeGridOccupancyTest, "SnakeGame.SnakeSim.Grid.Occupancy", SnakeSimTest::Flags)
+
+bool FSnakeGridOccupancyTest::RunTest(const FString& Parameters)
+{
+    FSnakeGrid Grid = SnakeSimTest::MakeGrid({
+        TEXT("###"),
+        TEXT("#.#"),
+        TEXT("###"),
+    });
+    const FIntPoint Cell = SnakeSimTest::CellAt(Grid, 1, 1);
+    TestTrue(TEXT("Free to start with"), Grid.IsFree(Cell));
+
+    TestTrue(TEXT("First occupant takes the cell"), Grid.AddOccupant(Cell));
+    TestFalse(TEXT("Second occupant doesn't"), Grid.AddOccupant(Cell));
+    TestEqual(TEXT("Two occupants"), Grid.GetOccupants(Cell), 2);
+    TestFalse(TEXT("Occupied isn't free"), Grid.IsFree(Cell));
+    TestFalse(TEXT("One of two leaving keeps it taken"), Grid.RemoveOccupant(Cell));
+    TestTrue(TEXT("Last one leaving frees it"), Grid.RemoveOccupant(Cell));
+    TestFalse(TEXT("Removing from an empty cell does nothing"), Grid.RemoveOccupant(Cell));
+    TestEqual(TEXT("No occupants"), Grid.GetOccupants(Cell), 0);
+
+    for (int32 Count = 0; Count < FSnakeGrid::MaxOccupants + 3; Count++)
+    {
+        Grid.AddOccupant(Cell);
+    }
+    TestEqual(TEXT("Saturates"), Grid.GetOccupants(Cell), int32(FSnakeGrid::MaxOccupants));
+    TestTrue(TEXT("Flags survive a full count"), Grid.IsWalkable(Cell));
+
+    Grid.SetFood(Cell, true);
+    TestTrue(TEXT("Food"), Grid.HasFood(Cell));
+    TestEqual(TEXT("Food keeps the occupants"), Grid.GetOccupants(Cell), int32(FSnakeGrid::MaxOccupants));
+    Grid.SetFood(Cell, false);
+    TestFalse(TEXT("Food eaten"), Grid.HasFood(Cell));
+
+    TestFalse(TEXT("Off the grid can't be occupied"), Grid.AddOccupant(Grid.GetOrigin() - FIntPoint(1, 1)));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeGridSaturationTest, "SnakeGame.SnakeSim.Grid.Saturation", SnakeSimTest::Flags)
+
+bool FSnakeGridSaturationTest::RunTest(const FString& Parameters)
+{
+    FSnakeGrid Grid = SnakeSimTest::MakeGrid({
+        TEXT("###"),
+        TEXT("#.#"),
+        TEXT("###"),
+    });
+    const FIntPoint Cell = SnakeSimTest::CellAt(Grid, 1, 1);
+
+    // More parts stacked than the count holds, then all of them leave again
+    const int32 NumParts = FSnakeGrid::MaxOccupants + 5;
+    for (int32 Part = 0; Part < NumParts; Part++)
+    {
+        Grid.AddOccupant(Cell);
+    }
+    for (int32 Part = 0; Part < NumParts - 1; Part++)
+    {
+        Grid.RemoveOccupant(Cell);
+        if (!TestFalse(TEXT("Taken while parts are left"), Grid.IsFree(Cell)))
+        {
+            break;
+        }
+    }
+    TestFalse(TEXT("The last part leaving doesn't free it either"), Grid.RemoveOccupant(Cell));
+    TestEqual(TEXT("Stays saturated"), Grid.GetOccupants(Cell), int32(FSnakeGrid::MaxOccupants));
+
+    uint8 CellBits = uint8(ESnakeCell::Floor);
+    TestTrue(TEXT("Byte helper takes an empty cell"), FSnakeGrid::AddOccupantTo(CellBits));
+    TestTrue(TEXT("Byte helper frees it"), FSnakeGrid::RemoveOccupantFrom(CellBits));
+    TestEqual(TEXT("Flags untouched"), int32(CellBits), int32(ESnakeCell::Floor));
+    TestFalse(TEXT("Nothing to remove"), FSnakeGrid::RemoveOccupantFrom(CellBits));
+    TestEqual(TEXT("No wrap below zero"), int32(CellBits), int32(ESnakeCell::Floor));
+    return true;
+}
+
+#endif
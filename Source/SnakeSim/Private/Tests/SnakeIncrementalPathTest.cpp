@@ -0,0 +1,121 @@
+#include "Misc/AutomationTest.h"
+#include "SnakeIncrementalPath.h"
+#include "SnakeSimTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeIncrementalPathRepairTest, "SnakeGame.SnakeSim.IncrementalPath.Repair", SnakeSimTest::Flags)
+
+bool FSnakeIncrementalPathRepairTest::RunTest(const FString& Parameters)
+{
+    FSnakeGrid Grid = SnakeSimTest::MakeGrid({
+        TEXT("#########"),
+        TEXT("#.......#"),
+        TEXT("#.#####.#"),
+        TEXT("#.#...#.#"),
+        TEXT("#.#.#.#.#"),
+        TEXT("#...#...#"),
+        TEXT("#########"),
+    });
+    FSnakeGridJournal Journal;
+    const int32 Start = Grid.ToIndex(SnakeSimTest::CellAt(Grid, 3, 3));
+    const int32 Goal = Grid.ToIndex(SnakeSimTest::CellAt(Grid, 1, 1));
+    const int32 LeftSide = Grid.ToIndex(SnakeSimTest::CellAt(Grid, 5, 2));
+    FSnakeIncrementalPath Search;
+    TArray<int32> Path;
+
+    // Down and round the left side is 8 moves, the right side 16
+    TestTrue(TEXT("Found"), Search.FindPath(Grid, Journal, Start, Goal, Path));
+    TestEqual(TEXT("Shortest way"), Path.Num(), 9);
+    TestTrue(TEXT("Valid path"), SnakeSimTest::IsPathOnFreeCells(Grid, Path, Start, Goal));
+
+    // A body across the left side: repaired to the long way round
+    SnakeSimTest::SetOccupied(Grid, Journal, LeftSide, true);
+    TestTrue(TEXT("Found around a body"), Search.FindPath(Grid, Journal, Start, Goal, Path));
+    TestEqual(TEXT("The long way"), Path.Num(), 17);
+    TestTrue(TEXT("Valid path around a body"), SnakeSimTest::IsPathOnFreeCells(Grid, Path, Start, Goal));
+
+    // Both ways blocked
+    const int32 RightSide = Grid.ToIndex(SnakeSimTest::CellAt(Grid, 1, 4));
+    SnakeSimTest::SetOccupied(Grid, Journal, RightSide, true);
+    TestFalse(TEXT("No way through"), Search.FindPath(Grid, Journal, Start, Goal, Path));
+    TestEqual(TEXT("No path"), Path.Num(), 0);
+
+    // The body moves on and the short way opens again
+    SnakeSimTest::SetOccupied(Grid, Journal, LeftSide, false);
+    TestTrue(TEXT("Found once freed"), Search.FindPath(Grid, Journal, Start, Goal, Path));
+    TestEqual(TEXT("Short way again"), Path.Num(), 9);
+    TestTrue(TEXT("Valid path once freed"), SnakeSimTest::IsPathOnFreeCells(Grid, Path, Start, Goal));
+
+    // A step along the path keeps the search, one move shorter
+    const int32 Next = Path[1];
+    TestTrue(TEXT("Found from the next cell"), Search.FindPath(Grid, Journal, Next, Goal, Path));
+    TestEqual(TEXT("One move shorter"), Path.Num(), 8);
+    TestTrue(TEXT("Valid path from the next cell"), SnakeSimTest::IsPathOnFreeCells(Grid, Path, Next, Goal));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeIncrementalPathBreadthFirstTest, "SnakeGame.SnakeSim.IncrementalPath.BreadthFirst", SnakeSimTest::Flags)
+
+bool FSnakeIncrementalPathBreadthFirstTest::RunTest(const FString& Parameters)
+{
+    // Bodies come and go and the head walks on; every repaired path is as long as breadth first search's
+    FSnakeGrid Grid = SnakeSimTest::MakeRandomGrid(32, 0.2f, 7);
+    FSnakeGridJournal Journal;
+    FRandomStream Random(11);
+
+    TArray<int32> Free;
+    for (int32 Index = 0; Index < Grid.Num(); Index++)
+    {
+        if (Grid.IsFreeAt(Index))
+        {
+            Free.Add(Index);
+        }
+    }
+    int32 Start = Free[Random.RandHelper(Free.Num())];
+    int32 Goal = Start;
+
+    FSnakeIncrementalPath Search;
+    TArray<int32> Path;
+    TArray<int32> Distances;
+    TArray<int32> Occupied;
+    for (int32 Round = 0; Round < 60; Round++)
+    {
+        while (Start == Goal || !Grid.IsFreeAt(Goal))
+        {
+            Goal = Free[Random.RandHelper(Free.Num())];
+        }
+        for (int32 Change = 0; Change < 4; Change++)
+        {
+            const int32 Cell = Free[Random.RandHelper(Free.Num())];
+            if (Occupied.Num() > 0 && Random.FRand() < 0.5f)
+            {
+                SnakeSimTest::SetOccupied(Grid, Journal, Occupied.Pop(), false);
+            }
+            else if (Cell != Start && Cell != Goal && Grid.IsFreeAt(Cell))
+            {
+                SnakeSimTest::SetOccupied(Grid, Journal, Cell, true);
+                Occupied.Add(Cell);
+            }
+        }
+
+        SnakeSimTest::GetDistances(Grid, Start, Distances);
+        const bool bFound = Search.FindPath(Grid, Journal, Start, Goal, Path);
+        TestTrue(*FString::Printf(TEXT("Round %d found as breadth first does"), Round), bFound == (Distances[Goal] != INDEX_NONE));
+        if (!bFound || Distances[Goal] == INDEX_NONE)
+        {
+            continue;
+        }
+        TestEqual(*FString::Printf(TEXT("Round %d length"), Round), Path.Num(), Distances[Goal] + 1);
+        TestTrue(*FString::Printf(TEXT("Round %d valid path"), Round), SnakeSimTest::IsPathOnFreeCells(Grid, Path, Start, Goal));
+
+        // Every other round the head moves on, a new goal once it's there
+        if (Round % 2 == 1)
+        {
+            Start = Path[1];
+        }
+    }
+    return true;
+}
+
+#endif
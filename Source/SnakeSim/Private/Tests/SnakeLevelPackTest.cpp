@@ -0,0 +1,79 @@
+#include "Misc/AutomationTest.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "SnakeLevelPack.h"
+#include "SnakeSimTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeLevelPackValidateTest, "SnakeGame.SnakeSim.LevelPack.Validate", SnakeSimTest::Flags)
+
+bool FSnakeLevelPackValidateTest::RunTest(const FString& Parameters)
+{
+    const FString PackPath = FPaths::AutomationTransientDir() / TEXT("SnakeLevelPackTest.snakepack");
+    const FString SourcePath = FPaths::AutomationTransientDir() / TEXT("SnakeLevelPackTest.txt");
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+    TArray<FSnakeLevelData> Levels;
+    FSnakeLevelData& Level = Levels.AddDefaulted_GetRef();
+    Level.LevelIndex = 1;
+    Level.ParseText({ TEXT("####"), TEXT("#.D#"), TEXT("####") }, 100.0f);
+    TestTrue(TEXT("Written"), FSnakeLevelPack::Write(PackPath, Levels, 100.0f));
+    {
+        FSnakeLevelPack Pack;
+        FSnakeLevelView View;
+        TestTrue(TEXT("Opens"), Pack.Open(PackPath));
+        TestEqual(TEXT("Tile size"), Pack.GetTileSize(), 100.0f);
+        TestTrue(TEXT("Has the level"), Pack.FindLevel(1, View) && View.Width == 4 && View.Height == 3);
+
+        // A source written after the pack makes it stale
+        FFileHelper::SaveStringToFile(TEXT("####"), *SourcePath);
+        PlatformFile.SetTimeStamp(*SourcePath, PlatformFile.GetTimeStamp(*PackPath) + FTimespan::FromMinutes(1.0));
+        TestTrue(TEXT("Older than a newer source"), Pack.IsOlderThan(SourcePath));
+        PlatformFile.SetTimeStamp(*SourcePath, PlatformFile.GetTimeStamp(*PackPath) - FTimespan::FromMinutes(1.0));
+        TestFalse(TEXT("Newer than an older source"), Pack.IsOlderThan(SourcePath));
+        TestFalse(TEXT("A missing source isn't newer"), Pack.IsOlderThan(SourcePath + TEXT(".missing")));
+    }
+
+    TArray64<uint8> Bytes;
+    TestTrue(TEXT("Read back"), FFileHelper::LoadFileToArray(Bytes, *PackPath));
+    const uint64 IndexOffset = reinterpret_cast<const FSnakeLevelPackHeader*>(Bytes.GetData())->IndexOffset;
+
+    // Every broken field on its own has to be refused rather than read out of bounds
+    const auto OpensWith = [&](TFunctionRef<void(FSnakeLevelPackHeader&, FSnakeLevelPackEntry&)> Break)
+    {
+        TArray64<uint8> Broken = Bytes;
+        Break(*reinterpret_cast<FSnakeLevelPackHeader*>(Broken.GetData()), *reinterpret_cast<FSnakeLevelPackEntry*>(Broken.GetData() + IndexOffset));
+        FFileHelper::SaveArrayToFile(Broken, *PackPath);
+        FSnakeLevelPack Pack;
+        return Pack.Open(PackPath);
+    };
+    TestFalse(TEXT("Zero width"), OpensWith([](FSnakeLevelPackHeader&, FSnakeLevelPackEntry& Entry) { Entry.Width = 0; }));
+    TestFalse(TEXT("Negative height"), OpensWith([](FSnakeLevelPackHeader&, FSnakeLevelPackEntry& Entry) { Entry.Height = -3; }));
+    TestFalse(TEXT("No words per row"), OpensWith([](FSnakeLevelPackHeader&, FSnakeLevelPackEntry& Entry) { Entry.WordsPerRow = 0; }));
+    TestFalse(TEXT("Rows wider than their words"), OpensWith([](FSnakeLevelPackHeader&, FSnakeLevelPackEntry& Entry) { Entry.Width = 65; }));
+    TestFalse(TEXT("Negative instance count"), OpensWith([](FSnakeLevelPackHeader&, FSnakeLevelPackEntry& Entry) { Entry.NumFloors = -1; }));
+    TestFalse(TEXT("No tile size"), OpensWith([](FSnakeLevelPackHeader& Header, FSnakeLevelPackEntry&) { Header.TileSize = 0.0f; }));
+    TestFalse(TEXT("Plane offset that wraps past the end"), OpensWith([](FSnakeLevelPackHeader&, FSnakeLevelPackEntry& Entry) { Entry.WallPlaneOffset = ~uint64(0) - 15; }));
+    TestFalse(TEXT("Plane larger than the file"), OpensWith([](FSnakeLevelPackHeader&, FSnakeLevelPackEntry& Entry) { Entry.Height = MAX_int32; Entry.WordsPerRow = MAX_int32; }));
+    TestFalse(TEXT("Index offset that wraps past the end"), OpensWith([](FSnakeLevelPackHeader& Header, FSnakeLevelPackEntry&) { Header.IndexOffset = ~uint64(0) - 7; }));
+    TestFalse(TEXT("Misaligned index"), OpensWith([](FSnakeLevelPackHeader& Header, FSnakeLevelPackEntry&) { Header.IndexOffset += 4; }));
+    TestTrue(TEXT("Unbroken"), OpensWith([](FSnakeLevelPackHeader&, FSnakeLevelPackEntry&) {}));
+
+    // Cut short with a header that agrees, the index written last runs past the end
+    {
+        TArray64<uint8> Truncated = Bytes;
+        Truncated.SetNum(Bytes.Num() - 8);
+        reinterpret_cast<FSnakeLevelPackHeader*>(Truncated.GetData())->FileSize = Truncated.Num();
+        FFileHelper::SaveArrayToFile(Truncated, *PackPath);
+        FSnakeLevelPack Pack;
+        TestFalse(TEXT("Truncated"), Pack.Open(PackPath));
+    }
+
+    PlatformFile.DeleteFile(*PackPath);
+    PlatformFile.DeleteFile(*SourcePath);
+    return true;
+}
+
+#endif
@@ -0,0 +1,72 @@
+#include "Misc/AutomationTest.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "SnakeNextHopTable.h"
+#include "SnakeSimTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeNextHopTableLoadTest, "SnakeGame.SnakeSim.NextHopTable.Load", SnakeSimTest::Flags)
+
+bool FSnakeNextHopTableLoadTest::RunTest(const FString& Parameters)
+{
+    const FString TablePath = FPaths::AutomationTransientDir() / TEXT("SnakeNextHopTableTest.nexthop");
+    const FSnakeGrid Grid = SnakeSimTest::MakeGrid({
+        TEXT("#######"),
+        TEXT("#.....#"),
+        TEXT("#.#.#.#"),
+        TEXT("#.....#"),
+        TEXT("#######"),
+    });
+    FSnakeNextHopTable Built;
+    Built.Build(Grid);
+    TestTrue(TEXT("Saved"), Built.SaveToFile(TablePath));
+
+    {
+        FSnakeNextHopTable Loaded;
+        TestTrue(TEXT("Loads"), Loaded.LoadFromFile(TablePath, Grid));
+        bool bSameMoves = Loaded.GetNumRuns() == Built.GetNumRuns();
+        for (int32 From = 0; From < Grid.Num(); From++)
+        {
+            for (int32 To = 0; To < Grid.Num(); To++)
+            {
+                bSameMoves &= Loaded.GetFirstMove(From, To) == Built.GetFirstMove(From, To);
+            }
+        }
+        TestTrue(TEXT("Same moves as built"), bSameMoves);
+
+        const FSnakeGrid Walled = SnakeSimTest::MakeGrid({
+            TEXT("#######"),
+            TEXT("#.....#"),
+            TEXT("#.###.#"),
+            TEXT("#.....#"),
+            TEXT("#######"),
+        });
+        TestFalse(TEXT("Made for other walls"), Loaded.LoadFromFile(TablePath, Walled));
+    }
+
+    TArray<uint8> Bytes;
+    TestTrue(TEXT("Read back"), FFileHelper::LoadFileToArray(Bytes, *TablePath));
+
+    // Runs are written last: the final one belongs to the last cell's row, after its first run
+    const auto LoadsWith = [&](TFunctionRef<uint32(uint32)> Break)
+    {
+        TArray<uint8> Broken = Bytes;
+        uint32& LastRun = *reinterpret_cast<uint32*>(Broken.GetData() + Broken.Num() - sizeof(uint32));
+        LastRun = Break(LastRun);
+        FFileHelper::SaveArrayToFile(Broken, *TablePath);
+        FSnakeNextHopTable Table;
+        return Table.LoadFromFile(TablePath, Grid);
+    };
+    const uint32 NumCells = Built.GetNumCells();
+    TestFalse(TEXT("Move out of range"), LoadsWith([](uint32 Run) { return Run | 7; }));
+    TestFalse(TEXT("Run starting before the one ahead of it"), LoadsWith([](uint32 Run) { return Run & 7; }));
+    TestFalse(TEXT("Run starting past the last cell"), LoadsWith([NumCells](uint32 Run) { return (NumCells << 3) | (Run & 7); }));
+    TestTrue(TEXT("Unbroken"), LoadsWith([](uint32 Run) { return Run; }));
+
+    FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*TablePath);
+    return true;
+}
+
+#endif
@@ -0,0 +1,169 @@
+#include "Misc/AutomationTest.h"
+#include "SnakePathfinder.h"
+#include "SnakeSimTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace SnakeSimTest
+{
+    static FSnakeGrid MakeMaze()
+    {
+        return MakeGrid({
+            TEXT("#########"),
+            TEXT("#.......#"),
+            TEXT("#.#####.#"),
+            TEXT("#.#...#.#"),
+            TEXT("#.#.#.#.#"),
+            TEXT("#...#...#"),
+            TEXT("#########"),
+        });
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakePathfinderShortestTest, "SnakeGame.SnakeSim.Pathfinder.Shortest", SnakeSimTest::Flags)
+
+bool FSnakePathfinderShortestTest::RunTest(const FString& Parameters)
+{
+    FSnakeGrid Grid = SnakeSimTest::MakeMaze();
+    const int32 Start = Grid.ToIndex(SnakeSimTest::CellAt(Grid, 3, 3));
+    const int32 Goal = Grid.ToIndex(SnakeSimTest::CellAt(Grid, 1, 1));
+    FSnakePathfinder Pathfinder;
+    TArray<int32> Path;
+
+    // Down and round the left side is 8 moves, the right side 16
+    TestTrue(TEXT("Found"), Pathfinder.FindPath(Grid, Start, Goal, Path));
+    TestEqual(TEXT("Shortest way"), Path.Num(), 9);
+    TestTrue(TEXT("Valid path"), SnakeSimTest::IsPathOnFreeCells(Grid, Path, Start, Goal));
+
+    // A body across the left side, and the head on the start cell
+    Grid.AddOccupant(Grid.ToCell(Start));
+    Grid.AddOccupant(SnakeSimTest::CellAt(Grid, 5, 2));
+    TestTrue(TEXT("Found around a body"), Pathfinder.FindPath(Grid, Start, Goal, Path));
+    TestEqual(TEXT("The long way"), Path.Num(), 17);
+    TestTrue(TEXT("Valid path around a body"), SnakeSimTest::IsPathOnFreeCells(Grid, Path, Start, Goal));
+
+    // Both ways blocked
+    Grid.AddOccupant(SnakeSimTest::CellAt(Grid, 1, 4));
+    TestFalse(TEXT("No way through"), Pathfinder.FindPath(Grid, Start, Goal, Path));
+    TestEqual(TEXT("No path"), Path.Num(), 0);
+
+    TestTrue(TEXT("Start is the goal"), Pathfinder.FindPath(Grid, Start, Start, Path));
+    TestEqual(TEXT("Start is the goal, one cell"), Path.Num(), 1);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakePathfinderNearestTest, "SnakeGame.SnakeSim.Pathfinder.Nearest", SnakeSimTest::Flags)
+
+bool FSnakePathfinderNearestTest::RunTest(const FString& Parameters)
+{
+    FSnakeGrid Grid = SnakeSimTest::MakeMaze();
+    const int32 Start = Grid.ToIndex(SnakeSimTest::CellAt(Grid, 3, 3));
+    const int32 Behind = Grid.ToIndex(SnakeSimTest::CellAt(Grid, 1, 3));
+    const int32 Around = Grid.ToIndex(SnakeSimTest::CellAt(Grid, 5, 5));
+    Grid.SetFood(Grid.ToCell(Behind), true);
+    Grid.SetFood(Grid.ToCell(Around), true);
+
+    // The apple behind the wall is closer as the crow flies, the other one by walking
+    FSnakePathfinder Pathfinder;
+    TArray<int32> Path;
+    TestTrue(TEXT("Found"), Pathfinder.FindPathToNearest(Grid, Start, ESnakeCell::Food, Path));
+    TestTrue(TEXT("Nearest by walking"), Path.Num() > 0 && Path.Last() == Around);
+    TestEqual(TEXT("Length"), Path.Num(), 5);
+    TestTrue(TEXT("Valid path"), SnakeSimTest::IsPathOnFreeCells(Grid, Path, Start, Around));
+
+    // Jump point search agrees on the length of the other one
+    TArray<int32> JumpPath;
+    TestTrue(TEXT("Breadth first to the far apple"), Pathfinder.FindPath(Grid, Start, Behind, Path));
+    TestTrue(TEXT("Jump point to the far apple"), Pathfinder.FindPathJumpPoint(Grid, Start, Behind, JumpPath));
+    TestEqual(TEXT("Same length"), JumpPath.Num(), Path.Num());
+    TestTrue(TEXT("Valid jump point path"), SnakeSimTest::IsPathOnFreeCells(Grid, JumpPath, Start, Behind));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakePathfinderJumpPointTest, "SnakeGame.SnakeSim.Pathfinder.JumpPointMatchesBreadthFirst", SnakeSimTest::Flags)
+
+bool FSnakePathfinderJumpPointTest::RunTest(const FString& Parameters)
+{
+    FRandomStream Random(1234);
+    FSnakePathfinder BreadthFirst;
+    FSnakePathfinder JumpPoint;
+    TArray<int32> Path;
+    TArray<int32> JumpPath;
+    int32 NumFound = 0;
+
+    for (int32 Layout = 0; Layout < 200; Layout++)
+    {
+        // Walls and doors at random, from open fields to near mazes, in and out of the level's border
+        const int32 Width = Random.RandRange(2, 40);
+        const int32 Height = Random.RandRange(2, 40);
+        const float WallChance = Random.FRandRange(0.0f, 0.4f);
+        const float DoorChance = Random.FRandRange(0.0f, 0.1f);
+        TArray<FString> Lines;
+        for (int32 Row = 0; Row < Height; Row++)
+        {
+            FString& Line = Lines.AddDefaulted_GetRef();
+            for (int32 Column = 0; Column < Width; Column++)
+            {
+                const float Roll = Random.FRand();
+                Line.AppendChar(Roll < WallChance ? TEXT('#') : Roll < WallChance + DoorChance ? TEXT('D') : TEXT('.'));
+            }
+        }
+        FSnakeLevelData Level;
+        Level.ParseText(Lines, 100.0f);
+        FSnakeGrid Grid;
+        Grid.Init(Level.GetView());
+
+        TArray<int32> Floor;
+        for (int32 Index = 0; Index < Grid.Num(); Index++)
+        {
+            if (Grid.IsWalkableAt(Index))
+            {
+                Floor.Add(Index);
+            }
+        }
+        if (Floor.Num() < 2)
+        {
+            continue;
+        }
+
+        // Snake bodies as random walks over the floor
+        const int32 NumSnakes = Random.RandRange(0, 4);
+        for (int32 Snake = 0; Snake < NumSnakes; Snake++)
+        {
+            int32 Cell = Floor[Random.RandHelper(Floor.Num())];
+            for (int32 Part = Random.RandRange(1, 30); Part > 0 && Cell != INDEX_NONE; Part--)
+            {
+                Grid.AddOccupant(Grid.ToCell(Cell));
+                const int32 Next = Grid.GetNeighbour(Cell, Random.RandHelper(FSnakeGrid::NumDirections));
+                Cell = Next != INDEX_NONE && Grid.IsFreeAt(Next) ? Next : INDEX_NONE;
+            }
+        }
+
+        for (int32 Query = 0; Query < 10; Query++)
+        {
+            // The start is where a head is, it may be on a body cell
+            const int32 Start = Floor[Random.RandHelper(Floor.Num())];
+            const int32 Goal = Floor[Random.RandHelper(Floor.Num())];
+            const bool bFound = BreadthFirst.FindPath(Grid, Start, Goal, Path);
+            const bool bJumpFound = JumpPoint.FindPathJumpPoint(Grid, Start, Goal, JumpPath);
+
+            const FString What = FString::Printf(TEXT("Layout %d (%dx%d), %d to %d"), Layout, Width, Height, Start, Goal);
+            if (!TestTrue(What + TEXT(": found by both or neither"), bJumpFound == bFound))
+            {
+                continue;
+            }
+            if (bFound)
+            {
+                NumFound++;
+                TestEqual(What + TEXT(": length"), JumpPath.Num(), Path.Num());
+                TestTrue(What + TEXT(": valid jump point path"), SnakeSimTest::IsPathOnFreeCells(Grid, JumpPath, Start, Goal));
+            }
+        }
+    }
+
+    // The layouts aren't all walled in, most queries have a path to compare
+    TestTrue(TEXT("Enough paths compared"), NumFound > 500);
+    return true;
+}
+
+#endif
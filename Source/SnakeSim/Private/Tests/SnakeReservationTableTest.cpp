@@ -0,0 +1,47 @@
+#include "Misc/AutomationTest.h"
+#include "SnakeReservationTable.h"
+#include "SnakeSimTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeSpaceTimeOwnBodyTest, "SnakeGame.SnakeSim.SpaceTime.OwnBody", SnakeSimTest::Flags)
+
+bool FSnakeSpaceTimeOwnBodyTest::RunTest(const FString& Parameters)
+{
+    // A ring of eight cells round a wall, no food: the search goes round for as long as it can
+    const FSnakeGrid Grid = SnakeSimTest::MakeGrid({
+        TEXT("#####"),
+        TEXT("#...#"),
+        TEXT("#.#.#"),
+        TEXT("#...#"),
+        TEXT("#####"),
+    });
+    FSnakeReservationTable Table;
+    Table.Reset(Grid.Num());
+    FSnakeSpaceTimeSearch Search;
+    TArray<int32> Path;
+    const int32 Start = Grid.ToIndex(SnakeSimTest::CellAt(Grid, 1, 1));
+    const int32 Horizon = 12;
+
+    for (const int32 BodyLength : { 0, 7, 8 })
+    {
+        Search.FindPath(Grid, Table, Start, INDEX_NONE, 0, INDEX_NONE, BodyLength, Horizon, Path);
+
+        // Seven cells behind the head still leave the one it's heading for free, eight fill the ring
+        const int32 Expected = BodyLength < 8 ? Horizon + 1 : 8;
+        TestEqual(FString::Printf(TEXT("Path length with a body of %d"), BodyLength), Path.Num(), Expected);
+        for (int32 Step = 1; Step < Path.Num(); Step++)
+        {
+            for (int32 Behind = 1; Behind <= BodyLength && Step - Behind >= 0; Behind++)
+            {
+                if (Path[Step] == Path[Step - Behind])
+                {
+                    AddError(FString::Printf(TEXT("Body of %d: step %d runs into the path %d steps back"), BodyLength, Step, Behind));
+                }
+            }
+        }
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,293 @@
+#include "Misc/AutomationTest.h"
+#include "SnakeSimState.h"
+#include "SnakeSimTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace SnakeSimTest
+{
+    /** Cell indices of text cells, head first. */
+    static TArray<int32> MakeBody(const FSnakeGrid& Grid, std::initializer_list<FIntPoint> RowsAndColumns)
+    {
+        TArray<int32> Body;
+        for (const FIntPoint& At : RowsAndColumns)
+        {
+            Body.Add(Grid.ToIndex(CellAt(Grid, At.X, At.Y)));
+        }
+        return Body;
+    }
+
+    // Text rows read top down and Up (0) is +X, so going up a row is direction 0, right along a row 1.
+    constexpr int32 Up = 0;
+    constexpr int32 Right = 1;
+    constexpr int32 Down = 2;
+    constexpr int32 Left = 3;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeSimStateMoveTest, "SnakeGame.SnakeSim.SimState.Move", SnakeSimTest::Flags)
+
+bool FSnakeSimStateMoveTest::RunTest(const FString& Parameters)
+{
+    const FSnakeGrid Grid = SnakeSimTest::MakeGrid({
+        TEXT("#######"),
+        TEXT("#.....#"),
+        TEXT("#######"),
+    });
+    FSnakeSimState State;
+    State.Init(Grid);
+    const TArray<int32> Body = SnakeSimTest::MakeBody(Grid, { {1, 3}, {1, 2}, {1, 1} });
+    const int32 Snake = State.AddSnake(Body, SnakeSimTest::Right);
+    TestEqual(TEXT("Snake number"), Snake, 0);
+    TestTrue(TEXT("Body blocks its cells"), State.IsBlocked(Body[1]) && State.IsBlocked(Body[2]));
+
+    FRandomStream Random(1);
+    const int32 Moves[] = { INDEX_NONE };
+    State.Step(Moves, Random);
+    TestEqual(TEXT("Head moved on"), State.GetHead(Snake), Body[0] + 1);
+    TestEqual(TEXT("Length"), State.GetLength(Snake), 3);
+    TestFalse(TEXT("Tail end left its cell"), State.IsBlocked(Body[2]));
+
+    // Going back the way it came is ignored, it keeps going straight
+    const int32 Back[] = { SnakeSimTest::Left };
+    State.Step(Back, Random);
+    TestEqual(TEXT("Kept going straight"), State.GetHead(Snake), Body[0] + 2);
+    TestTrue(TEXT("Still alive"), State.IsAlive(Snake));
+
+    // Into the wall
+    State.Step(Moves, Random);
+    TestFalse(TEXT("Died on the wall"), State.IsAlive(Snake));
+    TestEqual(TEXT("Nobody left"), State.GetNumAlive(), 0);
+    TestFalse(TEXT("Body taken off the board"), State.IsBlocked(Body[0] + 1));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeSimStateCollisionTest, "SnakeGame.SnakeSim.SimState.Collisions", SnakeSimTest::Flags)
+
+bool FSnakeSimStateCollisionTest::RunTest(const FString& Parameters)
+{
+    const FSnakeGrid Grid = SnakeSimTest::MakeGrid({
+        TEXT("#######"),
+        TEXT("#.....#"),
+        TEXT("#.....#"),
+        TEXT("#######"),
+    });
+    FRandomStream Random(1);
+
+    // Head on: both heads reach the middle cell on the same step
+    {
+        FSnakeSimState State;
+        State.Init(Grid);
+        State.AddSnake(SnakeSimTest::MakeBody(Grid, { {1, 2}, {1, 1} }), SnakeSimTest::Right);
+        State.AddSnake(SnakeSimTest::MakeBody(Grid, { {1, 4}, {1, 5} }), SnakeSimTest::Left);
+        const int32 Moves[] = { INDEX_NONE, INDEX_NONE };
+        State.Step(Moves, Random);
+        TestFalse(TEXT("Head on, first snake"), State.IsAlive(0));
+        TestFalse(TEXT("Head on, second snake"), State.IsAlive(1));
+    }
+
+    // Into another snake's body, which stays put while its head moves away
+    {
+        FSnakeSimState State;
+        State.Init(Grid);
+        State.AddSnake(SnakeSimTest::MakeBody(Grid, { {2, 2}, {2, 1} }), SnakeSimTest::Right);
+        State.AddSnake(SnakeSimTest::MakeBody(Grid, { {1, 3}, {2, 3}, {2, 4} }), SnakeSimTest::Up);
+        const int32 Moves[] = { INDEX_NONE, SnakeSimTest::Right };
+        State.Step(Moves, Random);
+        TestFalse(TEXT("Ran into a body"), State.IsAlive(0));
+        TestTrue(TEXT("The other one lives"), State.IsAlive(1));
+        TestEqual(TEXT("One left"), State.GetNumAlive(), 1);
+    }
+
+    // Onto the cell another snake's tail end leaves on the same step
+    {
+        FSnakeSimState State;
+        State.Init(Grid);
+        State.AddSnake(SnakeSimTest::MakeBody(Grid, { {2, 2}, {2, 1} }), SnakeSimTest::Right);
+        State.AddSnake(SnakeSimTest::MakeBody(Grid, { {1, 4}, {1, 3}, {2, 3} }), SnakeSimTest::Right);
+        const int32 Moves[] = { INDEX_NONE, INDEX_NONE };
+        State.Step(Moves, Random);
+        TestTrue(TEXT("Followed a tail"), State.IsAlive(0));
+        TestTrue(TEXT("Tail's snake lives"), State.IsAlive(1));
+    }
+
+    // A snake going round in a square as long as the square, its head always taking its own tail's cell
+    {
+        FSnakeSimState State;
+        State.Init(Grid);
+        State.AddSnake(SnakeSimTest::MakeBody(Grid, { {1, 2}, {1, 1}, {2, 1}, {2, 2} }), SnakeSimTest::Right);
+        const int32 Turns[] = { SnakeSimTest::Down, SnakeSimTest::Left, SnakeSimTest::Up, SnakeSimTest::Right };
+        for (int32 Turn = 0; Turn < 8; Turn++)
+        {
+            const int32 Moves[] = { Turns[Turn % 4] };
+            State.Step(Moves, Random);
+        }
+        TestTrue(TEXT("Chased its own tail"), State.IsAlive(0));
+        TestEqual(TEXT("Length"), State.GetLength(0), 4);
+    }
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeSimStateSaturationTest, "SnakeGame.SnakeSim.SimState.Saturation", SnakeSimTest::Flags)
+
+bool FSnakeSimStateSaturationTest::RunTest(const FString& Parameters)
+{
+    const FSnakeGrid Grid = SnakeSimTest::MakeGrid({
+        TEXT("########################"),
+        TEXT("#......................#"),
+        TEXT("########################"),
+    });
+    FSnakeSimState State;
+    State.Init(Grid);
+
+    // A tail end with more parts stacked on it than the count holds, one leaves on every step
+    const int32 NumStacked = FSnakeGrid::MaxOccupants + 2;
+    TArray<int32> Body = SnakeSimTest::MakeBody(Grid, { {1, 2} });
+    const int32 Stacked = Grid.ToIndex(SnakeSimTest::CellAt(Grid, 1, 1));
+    for (int32 Part = 0; Part < NumStacked; Part++)
+    {
+        Body.Add(Stacked);
+    }
+    State.AddSnake(Body, SnakeSimTest::Right);
+
+    FRandomStream Random(1);
+    const int32 Moves[] = { INDEX_NONE };
+    for (int32 Step = 0; Step < FSnakeGrid::MaxOccupants; Step++)
+    {
+        State.Step(Moves, Random);
+    }
+    TestTrue(TEXT("Still alive"), State.IsAlive(0));
+    TestTrue(TEXT("Parts left on the stacked cell keep it taken"), State.IsBlocked(Stacked));
+    TestEqual(TEXT("Two parts left there"), State.GetLength(0), NumStacked + 1);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeSimStateEatTest, "SnakeGame.SnakeSim.SimState.Eat", SnakeSimTest::Flags)
+
+bool FSnakeSimStateEatTest::RunTest(const FString& Parameters)
+{
+    FSnakeGrid Grid = SnakeSimTest::MakeGrid({
+        TEXT("#######"),
+        TEXT("#.....#"),
+        TEXT("#######"),
+    });
+    Grid.SetFood(SnakeSimTest::CellAt(Grid, 1, 2), true);
+
+    FSnakeSimState State;
+    State.Init(Grid);
+    const TArray<int32> Body = SnakeSimTest::MakeBody(Grid, { {1, 1} });
+    State.AddSnake(Body, SnakeSimTest::Right);
+    TestEqual(TEXT("Nearest food"), State.FindNearestFood(Body[0]), Body[0] + 1);
+
+    FRandomStream Random(1);
+    const int32 Moves[] = { INDEX_NONE };
+    State.Step(Moves, Random);
+    TestEqual(TEXT("Ate"), State.GetFoodEaten(0), 1);
+    TestEqual(TEXT("Length right after eating"), State.GetLength(0), 1);
+
+    // The tail stays put for one step
+    State.Step(Moves, Random);
+    TestEqual(TEXT("Grown"), State.GetLength(0), 2);
+    TestTrue(TEXT("Body on the cell the apple was on"), State.IsBlocked(Body[0] + 1));
+    TestTrue(TEXT("Food spawned again"), State.FindNearestFood(State.GetHead(0)) != INDEX_NONE);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeSimStateRemoveTest, "SnakeGame.SnakeSim.SimState.Remove", SnakeSimTest::Flags)
+
+bool FSnakeSimStateRemoveTest::RunTest(const FString& Parameters)
+{
+    const FSnakeGrid Grid = SnakeSimTest::MakeGrid({
+        TEXT("#######"),
+        TEXT("#.....#"),
+        TEXT("#.....#"),
+        TEXT("#######"),
+    });
+    FSnakeSimState State;
+    State.Init(Grid);
+    const TArray<int32> First = SnakeSimTest::MakeBody(Grid, { {1, 2}, {1, 1} });
+    const TArray<int32> Second = SnakeSimTest::MakeBody(Grid, { {2, 2}, {2, 1} });
+    State.AddSnake(First, SnakeSimTest::Right);
+    State.AddSnake(Second, SnakeSimTest::Right);
+
+    State.RemoveSnake(0);
+    TestFalse(TEXT("Removed snake is dead"), State.IsAlive(0));
+    TestEqual(TEXT("One left"), State.GetNumAlive(), 1);
+    TestFalse(TEXT("Its cells are free"), State.IsBlocked(First[0]) || State.IsBlocked(First[1]));
+
+    // Removing it twice doesn't hand its number out twice
+    State.RemoveSnake(0);
+    const TArray<int32> Third = SnakeSimTest::MakeBody(Grid, { {1, 4} });
+    TestEqual(TEXT("Number reused"), State.AddSnake(Third, INDEX_NONE, 2), 0);
+    TestEqual(TEXT("No more snakes than before"), State.GetNumSnakes(), 2);
+    TestTrue(TEXT("New snake alive"), State.IsAlive(0));
+    TestEqual(TEXT("New snake's head"), State.GetHead(0), Third[0]);
+    TestEqual(TEXT("New snake's growth"), State.GetGrowth(0), 2);
+    TestEqual(TEXT("Fresh food count"), State.GetFoodEaten(0), 0);
+    TestTrue(TEXT("Other snake untouched"), State.GetHead(1) == Second[0] && State.GetLength(1) == 2);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeSimStateLongTest, "SnakeGame.SnakeSim.SimState.Long", SnakeSimTest::Flags)
+
+bool FSnakeSimStateLongTest::RunTest(const FString& Parameters)
+{
+    // Longer than a body block starts out, both snakes' blocks grow and keep their cells in order
+    const FSnakeGrid Grid = SnakeSimTest::MakeGrid({
+        TEXT("##################################"),
+        TEXT("#................................#"),
+        TEXT("#................................#"),
+        TEXT("##################################"),
+    });
+    FSnakeSimState State;
+    State.Init(Grid);
+    State.AddSnake(SnakeSimTest::MakeBody(Grid, { {1, 1} }), SnakeSimTest::Right, 24);
+    State.AddSnake(SnakeSimTest::MakeBody(Grid, { {2, 1} }), SnakeSimTest::Right);
+
+    const int32 Moves[] = { INDEX_NONE, INDEX_NONE };
+    for (int32 Step = 0; Step < 30; Step++)
+    {
+        State.Step(Moves);
+    }
+    TestTrue(TEXT("Both alive"), State.IsAlive(0) && State.IsAlive(1));
+    TestEqual(TEXT("Grew by its growth"), State.GetLength(0), 25);
+    TestEqual(TEXT("Other one didn't grow"), State.GetLength(1), 1);
+
+    bool bInOrder = true;
+    for (int32 Offset = 0; Offset < State.GetLength(0); Offset++)
+    {
+        bInOrder &= State.GetBodyCell(0, Offset) == Grid.ToIndex(SnakeSimTest::CellAt(Grid, 1, 31 - Offset));
+    }
+    TestTrue(TEXT("Body lies behind the head, tail end last"), bInOrder);
+    TestEqual(TEXT("Other head"), State.GetHead(1), Grid.ToIndex(SnakeSimTest::CellAt(Grid, 2, 31)));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnakeSimStateOwnerFoodTest, "SnakeGame.SnakeSim.SimState.OwnerFood", SnakeSimTest::Flags)
+
+bool FSnakeSimStateOwnerFoodTest::RunTest(const FString& Parameters)
+{
+    const FSnakeGrid Grid = SnakeSimTest::MakeGrid({
+        TEXT("#######"),
+        TEXT("#.....#"),
+        TEXT("#######"),
+    });
+    FSnakeSimState State;
+    State.Init(Grid);
+    const TArray<int32> Body = SnakeSimTest::MakeBody(Grid, { {1, 1} });
+    State.AddSnake(Body, SnakeSimTest::Right);
+    State.SetFood(Body[0] + 1, true);
+    TestEqual(TEXT("Placed food"), State.GetFoodCells().Num(), 1);
+
+    // Without a random stream the board's owner places food, eaten food isn't replaced
+    const int32 Moves[] = { INDEX_NONE };
+    State.Step(Moves);
+    TestEqual(TEXT("Ate"), State.GetFoodEaten(0), 1);
+    TestEqual(TEXT("No food spawned"), State.GetFoodCells().Num(), 0);
+
+    State.SetFood(Body[0] + 3, true);
+    State.SetFood(Body[0] + 3, false);
+    TestEqual(TEXT("Food taken away again"), State.FindNearestFood(State.GetHead(0)), INDEX_NONE);
+    return true;
+}
+
+#endif
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "SnakeGrid.h"
+#include "SnakeGridJournal.h"
+#include "SnakeLevelPack.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace SnakeSimTest
+{
+    constexpr EAutomationTestFlags Flags = EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter;
+
+    /** A grid from level text rows, '#' wall, '.' floor, 'D' door. Row 0 is the far end, like the shipped levels. */
+    inline FSnakeGrid MakeGrid(const TArray<FString>& Lines)
+    {
+        FSnakeLevelData Level;
+        Level.ParseText(Lines, 100.0f);
+
+        FSnakeGrid Grid;
+        Grid.Init(Level.GetView());
+        return Grid;
+    }
+
+    inline FSnakeGrid MakeGrid(std::initializer_list<const TCHAR*> Rows)
+    {
+        TArray<FString> Lines;
+        for (const TCHAR* Row : Rows)
+        {
+            Lines.Add(Row);
+        }
+        return MakeGrid(Lines);
+    }
+
+    /** Square level walled round the edge, with walls scattered over about Density of the inside. */
+    inline FSnakeGrid MakeRandomGrid(int32 Size, float Density, int32 Seed)
+    {
+        FRandomStream Random(Seed);
+        TArray<FString> Lines;
+        for (int32 Row = 0; Row < Size; Row++)
+        {
+            FString& Line = Lines.AddDefaulted_GetRef();
+            for (int32 Column = 0; Column < Size; Column++)
+            {
+                const bool bEdge = Row == 0 || Column == 0 || Row == Size - 1 || Column == Size - 1;
+                Line.AppendChar(bEdge || Random.FRand() < Density ? TEXT('#') : TEXT('.'));
+            }
+        }
+        return MakeGrid(Lines);
+    }
+
+    /** The cell at a text row and column, which is how the rows above read. */
+    inline FIntPoint CellAt(const FSnakeGrid& Grid, int32 Row, int32 Column)
+    {
+        return Grid.ToCell((Grid.GetSizeX() - 1 - Row) * Grid.GetSizeY() + Column);
+    }
+
+    /** Path runs from Start to Goal through neighbouring cells, all free except Start. */
+    inline bool IsPathOnFreeCells(const FSnakeGrid& Grid, TConstArrayView<int32> Path, int32 Start, int32 Goal)
+    {
+        if (Path.Num() == 0 || Path[0] != Start || Path.Last() != Goal)
+        {
+            return false;
+        }
+        for (int32 Step = 1; Step < Path.Num(); Step++)
+        {
+            if (Grid.GetDirectionTo(Path[Step - 1], Path[Step]) == INDEX_NONE || !Grid.IsFreeAt(Path[Step]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** Plain breadth first search: steps from Start to every cell over free cells, INDEX_NONE where there's no way. Start may be occupied. */
+    inline void GetDistances(const FSnakeGrid& Grid, int32 Start, TArray<int32>& OutDistances)
+    {
+        OutDistances.Init(INDEX_NONE, Grid.Num());
+        OutDistances[Start] = 0;
+        TArray<int32> Queue = { Start };
+        for (int32 Next = 0; Next < Queue.Num(); Next++)
+        {
+            const int32 Cell = Queue[Next];
+            for (int32 Direction = 0; Direction < FSnakeGrid::NumDirections; Direction++)
+            {
+                const int32 Neighbour = Grid.GetNeighbour(Cell, Direction);
+                if (Neighbour != INDEX_NONE && OutDistances[Neighbour] == INDEX_NONE && Grid.IsFreeAt(Neighbour))
+                {
+                    OutDistances[Neighbour] = OutDistances[Cell] + 1;
+                    Queue.Add(Neighbour);
+                }
+            }
+        }
+    }
+
+    /** A body part on or off a cell, written down in the journal the way ASnakeWorld does. */
+    inline void SetOccupied(FSnakeGrid& Grid, FSnakeGridJournal& Journal, int32 Index, bool bOccupied)
+    {
+        if (bOccupied)
+        {
+            Grid.AddOccupant(Grid.ToCell(Index));
+        }
+        else
+        {
+            Grid.RemoveOccupant(Grid.ToCell(Index));
+        }
+        Journal.Record(Index);
+    }
+}
+
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FSnakeGrid;
+class FSnakeGridJournal;
+
+/**
+ * Free cells of an FSnakeGrid as bits, one grid row (along Y) per run of 64-bit words, for flood fills
+ * that move whole words at a time. Rows are filled sideways with a shift-and-mask fill of six steps per
+ * word, then grown into the rows above and below, sweeping up and down until nothing changes.
+ *
+ * Kept in step with the grid through the world's FSnakeGridJournal, so an update costs as many bits as
+ * cells changed. Not thread safe.
+ */
+class SNAKESIM_API FSnakeBitboard
+{
+public:
+	void Build(const FSnakeGrid& Grid);
+
+	/** Catches up on cells changed since the last Build or Sync, rebuilds when the journal can't tell. */
+	void Sync(const FSnakeGrid& Grid, const FSnakeGridJournal& Journal);
+
+	bool IsFree(int32 Index) const { return TestBit(Free, Index); }
+
+	/**
+	 * Flood fills the free cells connected to Start and returns how many there are, Start included.
+	 * Stops early once at least Limit are found. Returns 0 when Start isn't free.
+	 */
+	int32 FillFrom(int32 Start, int32 Limit = MAX_int32);
+
+	/** Whether the last fill reached a cell, or one of its neighbours. */
+	bool IsReached(int32 Index) const { return TestBit(Reach, Index); }
+	bool IsNextToReached(int32 Index) const;
+
+	SIZE_T GetAllocatedSize() const { return Free.GetAllocatedSize() + Reach.GetAllocatedSize(); }
+
+private:
+	bool TestBit(const TArray<uint64>& Plane, int32 Index) const
+	{
+		if (Index < 0 || Index >= SizeX * SizeY)
+		{
+			return false;
+		}
+		const int32 Row = Index / SizeY;
+		const int32 Column = Index % SizeY;
+		return (Plane[Row * WordsPerRow + (Column >> 6)] >> (Column & 63)) & 1;
+	}
+
+	void SetFree(int32 Index, bool bFree);
+
+	// Fills a row of Reach sideways through its free cells, across word boundaries.
+	void FillRow(int32 Row);
+
+	// Seeds Row from the reached cells of the row next to it, returns whether anything new was reached.
+	bool GrowRow(int32 Row, int32 FromRow);
+
+	int32 CountReached(int32 FirstRow, int32 LastRow) const;
+
+	TArray<uint64> Free;
+	TArray<uint64> Reach;
+	int32 SizeX = 0;
+	int32 SizeY = 0;
+	int32 WordsPerRow = 0;
+	uint64 Serial = 0;
+};
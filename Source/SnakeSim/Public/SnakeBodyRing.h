@@ -0,0 +1,112 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Cells of a snake's body behind the head, in a ring so that moving on a tile writes one cell and
+ * growing bumps a length, however long the snake is. Index 0 is the cell right behind the head, the
+ * last one the tail end.
+ */
+template <typename CellType>
+class TSnakeBodyRing
+{
+public:
+	int32 Num() const { return Length; }
+	bool IsEmpty() const { return Length == 0; }
+
+	const CellType& operator[](int32 Index) const
+	{
+		checkSlow(Index >= 0 && Index < Length);
+		return Cells[(Start + Index) & (Cells.Num() - 1)];
+	}
+
+	const CellType& Last() const { return (*this)[Length - 1]; }
+
+	/** The head moved on from PreviousHead: it becomes the first body cell and the tail end drops off. */
+	void Advance(const CellType& PreviousHead)
+	{
+		if (Length == 0)
+		{
+			return;
+		}
+		Start = (Start - 1) & (Cells.Num() - 1);
+		Cells[Start] = PreviousHead;
+	}
+
+	/** One more cell on the tail end, on top of the current tail end (or At for an empty body) until the next Advance leaves it behind. */
+	void Grow(const CellType& At)
+	{
+		if (Length + 1 > Cells.Num())
+		{
+			Reallocate(FMath::Max(Cells.Num() * 2, 4));
+		}
+		// The slot past the tail end still holds the cell that dropped off last, it only needs the right value
+		Cells[(Start + Length) & (Cells.Num() - 1)] = Length > 0 ? Last() : At;
+		Length++;
+	}
+
+	void Reset()
+	{
+		Start = 0;
+		Length = 0;
+	}
+
+	struct FConstIterator
+	{
+		const TSnakeBodyRing* Ring;
+		int32 Index;
+
+		const CellType& operator*() const { return (*Ring)[Index]; }
+		FConstIterator& operator++() { Index++; return *this; }
+		bool operator!=(const FConstIterator& Other) const { return Index != Other.Index; }
+	};
+
+	FConstIterator begin() const { return { this, 0 }; }
+	FConstIterator end() const { return { this, Length }; }
+
+	SIZE_T GetAllocatedSize() const { return Cells.GetAllocatedSize(); }
+
+private:
+	void Reallocate(int32 NewCapacity)
+	{
+		// Unrolled to the front again, capacity stays a power of two for the index masks
+		TArray<CellType> NewCells;
+		NewCells.SetNum(NewCapacity);
+		for (int32 Index = 0; Index < Length; Index++)
+		{
+			NewCells[Index] = (*this)[Index];
+		}
+		Cells = MoveTemp(NewCells);
+		Start = 0;
+	}
+
+	TArray<CellType> Cells;
+	int32 Start = 0;
+	int32 Length = 0;
+};
+
+/**
+ * Moves a snake one cell on a board that counts occupants, like FSnakeGrid. The tail end (the head
+ * itself while there is no body) leaves its cell first so a head may follow its own tail, then the
+ * head takes NewHead and the cell it left joins the body. A head that ran into a body finds more than
+ * one occupant on NewHead afterwards.
+ */
+template <typename BoardType, typename CellType>
+void MoveSnake(BoardType& Board, CellType& Head, TSnakeBodyRing<CellType>& Body, const CellType& NewHead)
+{
+	Board.RemoveOccupant(Body.IsEmpty() ? Head : Body.Last());
+	Board.AddOccupant(NewHead);
+	Body.Advance(Head);
+	Head = NewHead;
+}
+
+/**
+ * One more body cell after a move, on the tail end so that it stays put on the next move. A snake
+ * without a body grows on PreviousHead, the cell its head gave up on that move.
+ */
+template <typename BoardType, typename CellType>
+void GrowSnake(BoardType& Board, const CellType& PreviousHead, TSnakeBodyRing<CellType>& Body)
+{
+	Body.Grow(PreviousHead);
+	Board.AddOccupant(Body.Last());
+}
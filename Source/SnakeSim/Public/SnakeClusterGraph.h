@@ -0,0 +1,126 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FSnakeGrid;
+class FSnakeGridJournal;
+
+/**
+ * Hierarchical path search (HPA*) for big levels. The grid is cut into square clusters; wherever the
+ * walls let a snake cross from one cluster to the next there are entrance cells, which become the nodes
+ * of a small graph. Each cluster keeps the walking distances between its own entrances, so a search
+ * runs over entrances instead of cells and only the cells of the clusters it passes through are
+ * walked again to turn the result into a path.
+ *
+ * Entrances follow the walls and are found once per level. The distances inside a cluster follow the
+ * snakes as well: clusters with cells in the journal are marked dirty and refined the next time a
+ * search reaches them. Paths are close to shortest, not always shortest.
+ *
+ * Not thread safe, searches refine clusters and share buffers.
+ */
+class SNAKESIM_API FSnakeClusterGraph
+{
+public:
+	static constexpr int32 ClusterSize = 16;
+
+	/** Finds the entrances of a level and the distances inside every cluster, spread over the task graph. */
+	void Build(const FSnakeGrid& Grid, const FSnakeGridJournal& Journal);
+	void Reset();
+
+	bool IsBuiltFor(const FSnakeGrid& Grid) const { return Clusters.Num() > 0 && SizeX == Grid.GetSizeX() && SizeY == Grid.GetSizeY(); }
+
+	/**
+	 * Path over free cells from Start (which may be occupied) to Goal. Only the first MaxSteps cells are
+	 * worked out, the path is guaranteed to continue from there.
+	 */
+	bool FindPath(const FSnakeGrid& Grid, const FSnakeGridJournal& Journal, int32 Start, int32 Goal, TArray<int32>& OutPath, int32 MaxSteps = MAX_int32);
+
+	int32 GetNumNodes() const { return NodeCell.Num(); }
+	int32 GetNumClusters() const { return Clusters.Num(); }
+
+	/** Graph nodes taken off the open list, and dirty clusters refined, by the last search. */
+	int32 GetNumExpanded() const { return NumExpanded; }
+	int32 GetNumRefined() const { return NumRefined; }
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	static constexpr uint16 Unreachable = MAX_uint16;
+
+	struct FCluster
+	{
+		// First grid row and column, and how many of each, smaller at the far edges.
+		int32 Row = 0;
+		int32 Column = 0;
+		int32 NumRows = 0;
+		int32 NumColumns = 0;
+
+		int32 FirstNode = 0;
+		int32 NumNodes = 0;
+
+		// NumNodes x NumNodes walking distances between the entrances, through free cells of this cluster.
+		TArray<uint16> Distances;
+		bool bDirty = true;
+	};
+
+	// Breadth first search confined to one cluster, indexed by cell within the cluster.
+	struct FLocalSearch
+	{
+		TArray<uint16> Distance;
+		TArray<int16> Parent;
+		TArray<int32> Queue;
+	};
+
+	struct FOpenNode
+	{
+		uint32 Cost;
+		uint32 Distance;
+		int32 Node;
+	};
+
+	int32 GetClusterOf(int32 Index) const
+	{
+		return ((Index / SizeY) / ClusterSize) * ClustersY + (Index % SizeY) / ClusterSize;
+	}
+
+	int32 ToLocal(const FCluster& Cluster, int32 Index) const
+	{
+		return (Index / SizeY - Cluster.Row) * Cluster.NumColumns + (Index % SizeY - Cluster.Column);
+	}
+
+	void SearchCluster(const FSnakeGrid& Grid, const FCluster& Cluster, int32 From, FLocalSearch& Search) const;
+	void RefineCluster(const FSnakeGrid& Grid, FCluster& Cluster, FLocalSearch& Search) const;
+	bool AppendLocalPath(const FSnakeGrid& Grid, int32 From, int32 To, TArray<int32>& OutPath);
+	void Sync(const FSnakeGridJournal& Journal);
+	void Relax(int32 Node, int32 From, uint32 Distance, int32 Goal);
+
+	int32 SizeX = 0;
+	int32 SizeY = 0;
+	int32 ClustersX = 0;
+	int32 ClustersY = 0;
+	TArray<FCluster> Clusters;
+
+	// Entrance cells; the nodes of a cluster are contiguous and sorted by cell.
+	TArray<int32> NodeCell;
+	TArray<int32> NodeCluster;
+
+	// Entrances on the other side of a cluster border, one step away. Links of a node are
+	// Links[LinkOffsets[Node]] up to LinkOffsets[Node + 1].
+	TArray<int32> LinkOffsets;
+	TArray<int32> Links;
+
+	uint64 Serial = 0;
+	int32 NumExpanded = 0;
+	int32 NumRefined = 0;
+
+	// Search buffers, two extra nodes at the end stand for the start and goal cells.
+	FLocalSearch Local;
+	TArray<uint16> StartDistance;
+	TArray<uint16> GoalDistance;
+	TArray<uint32> Cost;
+	TArray<int32> Parent;
+	TArray<uint32> Visited;
+	uint32 Generation = 0;
+	TArray<FOpenNode> Open;
+	TArray<int32> AbstractPath;
+};
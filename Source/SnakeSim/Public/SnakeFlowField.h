@@ -0,0 +1,35 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FSnakeGrid;
+
+/**
+ * Distance in steps from every cell to the nearest source cell (food), from one multi-source breadth first
+ * search. Any number of snakes can then move towards food by looking at their four neighbours.
+ */
+class SNAKESIM_API FSnakeFlowField
+{
+public:
+	static constexpr uint32 Unreachable = MAX_uint32;
+
+	/** Recomputes the field. With bAvoidOccupied, cells with a snake part on them block the search. */
+	void Build(const FSnakeGrid& Grid, TConstArrayView<int32> Sources, bool bAvoidOccupied);
+	void Reset();
+
+	bool IsBuilt() const { return Distance.Num() > 0; }
+
+	uint32 GetDistance(int32 Index) const { return Distance.IsValidIndex(Index) ? Distance[Index] : Unreachable; }
+
+	/**
+	 * Direction (0..3) of the free neighbour closest to a source, skipping ExcludedDirection.
+	 * INDEX_NONE when no free neighbour leads to one.
+	 */
+	int32 GetBestDirection(const FSnakeGrid& Grid, int32 Index, int32 ExcludedDirection = INDEX_NONE) const;
+
+	SIZE_T GetAllocatedSize() const { return Distance.GetAllocatedSize() + Frontier.GetAllocatedSize(); }
+
+private:
+	TArray<uint32> Distance;
+	TArray<int32> Frontier;
+};
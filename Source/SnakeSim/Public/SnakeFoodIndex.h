@@ -0,0 +1,50 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * All food on the board, kept in square buckets of cells so the nearest food can be found by looking
+ * at a few buckets around a cell rather than at every apple. Maintained by ASnakeWorld as food spawns
+ * and gets eaten.
+ *
+ * Cells are FSnakeGrid indices; distances are Manhattan, the shortest a snake could possibly walk.
+ */
+class SNAKESIM_API FSnakeFoodIndex
+{
+public:
+	static constexpr int32 BucketShift = 3;
+	static constexpr int32 BucketSize = 1 << BucketShift;
+
+	void Init(int32 InSizeX, int32 InSizeY);
+	void Reset();
+
+	void Add(int32 Index);
+	void Remove(int32 Index);
+
+	bool Contains(int32 Index) const { return Slots.IsValidIndex(Index) && Slots[Index] != INDEX_NONE; }
+	int32 Num() const { return Cells.Num(); }
+	TConstArrayView<int32> GetCells() const { return Cells; }
+
+	/** Food closest to From, INDEX_NONE when there is none. Rings of buckets are searched until no closer food can exist. */
+	int32 FindNearest(int32 From) const;
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	// Below this many apples a plain scan is quicker than walking buckets.
+	static constexpr int32 LinearScanThreshold = 8;
+
+	int32 GetDistance(int32 A, int32 B) const
+	{
+		return FMath::Abs(A / SizeY - B / SizeY) + FMath::Abs(A % SizeY - B % SizeY);
+	}
+
+	int32 SizeX = 0;
+	int32 SizeY = 0;
+	int32 BucketsX = 0;
+	int32 BucketsY = 0;
+
+	TArray<TArray<int32, TInlineAllocator<4>>> Buckets;
+	TArray<int32> Cells;
+	TArray<int32> Slots;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FSnakeGrid;
+
+/**
+ * Set of grid cells food may spawn on (walkable, no snake part, no food), with O(1) add, remove and
+ * uniform sampling. Cells with floor on all four sides are kept in a second, preferred pool; which cells
+ * qualify only depends on the level so it is worked out once in Init.
+ *
+ * Cells are FSnakeGrid indices. The owner keeps it in sync with the grid as snakes move and food comes and goes.
+ */
+class SNAKESIM_API FSnakeFreeCellIndex
+{
+public:
+	void Init(const FSnakeGrid& Grid);
+	void Reset();
+
+	void Add(int32 Index);
+	void Remove(int32 Index);
+
+	bool Contains(int32 Index) const { return Free.Contains(Index); }
+	int32 Num() const { return Free.Cells.Num(); }
+	int32 NumPreferred() const { return PreferredFree.Cells.Num(); }
+
+	/** A uniformly random free cell, from the preferred pool when it isn't empty. INDEX_NONE when the board is full. */
+	int32 Sample(FRandomStream& Random) const;
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	/** Dense array of cells plus each cell's slot in it, so removal is a swap with the last element. */
+	struct FPool
+	{
+		TArray<int32> Cells;
+		TArray<int32> Slots;
+
+		void Init(int32 NumGridCells);
+		bool Contains(int32 Index) const { return Slots[Index] != INDEX_NONE; }
+		void Add(int32 Index);
+		void Remove(int32 Index);
+	};
+
+	FPool Free;
+	FPool PreferredFree;
+	TBitArray<> Preferred;
+};
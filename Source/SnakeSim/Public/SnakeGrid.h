@@ -0,0 +1,195 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FSnakeLevelView;
+
+/** Static cell contents, packed into the low bits of a grid cell. */
+enum class ESnakeCell : uint8
+{
+	None  = 0,
+	Wall  = 1 << 0,
+	Floor = 1 << 1,
+	Door  = 1 << 2,
+	Food  = 1 << 3,
+};
+ENUM_CLASS_FLAGS(ESnakeCell)
+
+/**
+ * Dense level grid owned by ASnakeWorld. One byte per cell: ESnakeCell flags in the low nibble and
+ * the number of snake parts on the cell in the high nibble. The count saturates at 15; a full count no
+ * longer says how many parts are left, so such a cell stays occupied until the grid is rebuilt.
+ *
+ * Cells use the same integer coordinates as WorldToCell in Definitions.h, relative to the world actor.
+ * Directions are indexed like ESnakeDirection: 0 Up (+X), 1 Right (+Y), 2 Down (-X), 3 Left (-Y).
+ */
+class SNAKESIM_API FSnakeGrid
+{
+public:
+	static constexpr int32 NumDirections = 4;
+	static constexpr uint8 FlagMask = 0x0F;
+	static constexpr uint8 OccupantMask = 0xF0;
+	static constexpr uint8 OccupantShift = 4;
+	static constexpr uint8 MaxOccupants = 15;
+
+	void Init(const FSnakeLevelView& Level);
+	void Reset();
+
+	int32 GetSizeX() const { return SizeX; }
+	int32 GetSizeY() const { return SizeY; }
+	int32 Num() const { return Cells.Num(); }
+	FIntPoint GetOrigin() const { return Origin; }
+
+	bool IsInside(const FIntPoint& Cell) const
+	{
+		return Cell.X >= Origin.X && Cell.X < Origin.X + SizeX && Cell.Y >= Origin.Y && Cell.Y < Origin.Y + SizeY;
+	}
+
+	int32 ToIndex(const FIntPoint& Cell) const
+	{
+		return IsInside(Cell) ? (Cell.X - Origin.X) * SizeY + (Cell.Y - Origin.Y) : INDEX_NONE;
+	}
+
+	FIntPoint ToCell(int32 Index) const
+	{
+		return FIntPoint(Origin.X + Index / SizeY, Origin.Y + Index % SizeY);
+	}
+
+	/** Neighbouring cell index in a direction, INDEX_NONE off the grid. */
+	int32 GetNeighbour(int32 Index, int32 Direction) const
+	{
+		const int32 Column = Index % SizeY;
+		switch (Direction)
+		{
+		case 0: return Index + SizeY < Cells.Num() ? Index + SizeY : INDEX_NONE;
+		case 1: return Column + 1 < SizeY ? Index + 1 : INDEX_NONE;
+		case 2: return Index >= SizeY ? Index - SizeY : INDEX_NONE;
+		case 3: return Column > 0 ? Index - 1 : INDEX_NONE;
+		default: return INDEX_NONE;
+		}
+	}
+
+	/** Direction from a cell to one of its neighbours, INDEX_NONE if they aren't neighbours. */
+	int32 GetDirectionTo(int32 From, int32 To) const
+	{
+		for (int32 Direction = 0; Direction < NumDirections; Direction++)
+		{
+			if (GetNeighbour(From, Direction) == To)
+			{
+				return Direction;
+			}
+		}
+		return INDEX_NONE;
+	}
+
+	/** The cell of Cells closest to From by Manhattan distance, INDEX_NONE entries are skipped. */
+	int32 FindClosest(int32 From, TConstArrayView<int32> Cells) const
+	{
+		const FIntPoint FromCell = ToCell(From);
+		int32 Closest = INDEX_NONE;
+		int32 BestDistance = MAX_int32;
+		for (const int32 Cell : Cells)
+		{
+			if (Cell == INDEX_NONE)
+			{
+				continue;
+			}
+			const FIntPoint Delta = ToCell(Cell) - FromCell;
+			const int32 Distance = FMath::Abs(Delta.X) + FMath::Abs(Delta.Y);
+			if (Distance < BestDistance)
+			{
+				BestDistance = Distance;
+				Closest = Cell;
+			}
+		}
+		return Closest;
+	}
+
+	static FIntPoint GetDirectionOffset(int32 Direction)
+	{
+		switch (Direction)
+		{
+		case 0: return FIntPoint(1, 0);
+		case 1: return FIntPoint(0, 1);
+		case 2: return FIntPoint(-1, 0);
+		case 3: return FIntPoint(0, -1);
+		default: return FIntPoint::ZeroValue;
+		}
+	}
+
+	// Index based queries, for hot loops that already work in indices.
+	ESnakeCell GetFlagsAt(int32 Index) const { return ESnakeCell(Cells[Index] & FlagMask); }
+	bool HasFlagAt(int32 Index, ESnakeCell Flag) const { return EnumHasAnyFlags(GetFlagsAt(Index), Flag); }
+	int32 GetOccupantsAt(int32 Index) const { return Cells[Index] >> OccupantShift; }
+	bool IsWalkableAt(int32 Index) const { return HasFlagAt(Index, ESnakeCell::Floor); }
+	bool IsFreeAt(int32 Index) const { return (Cells[Index] & (OccupantMask | uint8(ESnakeCell::Floor))) == uint8(ESnakeCell::Floor); }
+
+	// Cell based queries, anything off the grid is empty space.
+	ESnakeCell GetFlags(const FIntPoint& Cell) const
+	{
+		const int32 Index = ToIndex(Cell);
+		return Index != INDEX_NONE ? GetFlagsAt(Index) : ESnakeCell::None;
+	}
+	bool IsWall(const FIntPoint& Cell) const { return EnumHasAnyFlags(GetFlags(Cell), ESnakeCell::Wall); }
+	bool IsDoor(const FIntPoint& Cell) const { return EnumHasAnyFlags(GetFlags(Cell), ESnakeCell::Door); }
+	bool HasFood(const FIntPoint& Cell) const { return EnumHasAnyFlags(GetFlags(Cell), ESnakeCell::Food); }
+
+	/** Floor tiles, what the AI and food spawning may use. Doors are rendered as floor but aren't walkable. */
+	bool IsWalkable(const FIntPoint& Cell) const { return EnumHasAnyFlags(GetFlags(Cell), ESnakeCell::Floor); }
+
+	/** Walkable and not covered by any snake. */
+	bool IsFree(const FIntPoint& Cell) const
+	{
+		const int32 Index = ToIndex(Cell);
+		return Index != INDEX_NONE && IsFreeAt(Index);
+	}
+
+	int32 GetOccupants(const FIntPoint& Cell) const
+	{
+		const int32 Index = ToIndex(Cell);
+		return Index != INDEX_NONE ? GetOccupantsAt(Index) : 0;
+	}
+	bool IsOccupied(const FIntPoint& Cell) const { return GetOccupants(Cell) > 0; }
+
+	/** Returns true when the cell went from empty to occupied. */
+	bool AddOccupant(const FIntPoint& Cell);
+
+	/** Returns true when the cell went from occupied to empty. */
+	bool RemoveOccupant(const FIntPoint& Cell);
+
+	/** AddOccupant on a cell byte, for boards that pack their cells the same way (FSnakeSimState). */
+	static bool AddOccupantTo(uint8& CellBits)
+	{
+		const int32 Count = CellBits >> OccupantShift;
+		if (Count < MaxOccupants)
+		{
+			CellBits = uint8((CellBits & FlagMask) | ((Count + 1) << OccupantShift));
+		}
+		return Count == 0;
+	}
+
+	/** RemoveOccupant on a cell byte. A saturated count is left as it is. */
+	static bool RemoveOccupantFrom(uint8& CellBits)
+	{
+		const int32 Count = CellBits >> OccupantShift;
+		if (Count == 0 || Count == MaxOccupants)
+		{
+			return false;
+		}
+		CellBits = uint8((CellBits & FlagMask) | ((Count - 1) << OccupantShift));
+		return Count == 1;
+	}
+
+	void SetFood(const FIntPoint& Cell, bool bHasFood);
+
+	int32 GetNumWalkable() const { return NumWalkable; }
+
+	SIZE_T GetAllocatedSize() const { return Cells.GetAllocatedSize(); }
+
+private:
+	TArray<uint8> Cells;
+	FIntPoint Origin = FIntPoint::ZeroValue;
+	int32 SizeX = 0;
+	int32 SizeY = 0;
+	int32 NumWalkable = 0;
+};
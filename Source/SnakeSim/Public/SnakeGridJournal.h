@@ -0,0 +1,51 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Log of grid cells whose free state changed, so searches that keep state between tiles can catch up
+ * on what happened instead of starting over. Readers remember GetSerial() and later ask for everything
+ * recorded since. Old entries are dropped once the log is full; a reader that fell that far behind,
+ * or read before the grid was replaced, gets false and has to search from scratch.
+ */
+class FSnakeGridJournal
+{
+public:
+	static constexpr int32 MaxEntries = 16384;
+
+	void Record(int32 Index)
+	{
+		if (Entries.Num() >= MaxEntries)
+		{
+			const int32 Dropped = MaxEntries / 2;
+			Entries.RemoveAt(0, Dropped, EAllowShrinking::No);
+			Base += Dropped;
+		}
+		Entries.Add(Index);
+	}
+
+	/** The grid was replaced, nothing recorded so far describes it. */
+	void Invalidate()
+	{
+		// One past the end, so even a reader that was fully caught up is behind.
+		Base += Entries.Num() + 1;
+		Entries.Reset();
+	}
+
+	uint64 GetSerial() const { return Base + Entries.Num(); }
+
+	/** Cells changed since Serial, possibly more than once. False when those changes are no longer known. */
+	bool GetChangesSince(uint64 Serial, TConstArrayView<int32>& OutCells) const
+	{
+		if (Serial < Base || Serial > GetSerial())
+		{
+			return false;
+		}
+		OutCells = TConstArrayView<int32>(Entries.GetData() + (Serial - Base), int32(GetSerial() - Serial));
+		return true;
+	}
+
+private:
+	TArray<int32> Entries;
+	uint64 Base = 0;
+};
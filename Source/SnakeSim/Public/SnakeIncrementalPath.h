@@ -0,0 +1,75 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SnakeGrid.h"
+
+class FSnakeGridJournal;
+
+/**
+ * Shortest path to one goal that is repaired between tiles rather than searched again (D* Lite).
+ * Distances are kept from the goal backwards, so as the head moves and cells get blocked or freed
+ * only the distances those changes affect are recomputed. A new goal, or a journal that can't say
+ * what changed, starts a fresh search.
+ *
+ * Costs are the same as FSnakePathfinder::FindPath: free cells cost one step, anything else is
+ * blocked, and the start may be occupied.
+ */
+class SNAKESIM_API FSnakeIncrementalPath
+{
+public:
+	bool FindPath(const FSnakeGrid& Grid, const FSnakeGridJournal& Journal, int32 Start, int32 NewGoal, TArray<int32>& OutPath);
+
+	/** Forget the search, the next FindPath starts from scratch. */
+	void Reset();
+
+	int32 GetGoal() const { return Goal; }
+
+	/** Cells taken off the open list by the last FindPath, repairs included. */
+	int32 GetNumExpanded() const { return NumExpanded; }
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	static constexpr uint32 Unreachable = MAX_uint32;
+
+	struct FKey
+	{
+		uint64 Primary;
+		uint32 Secondary;
+	};
+
+	struct FOpenNode
+	{
+		FKey Key;
+		int32 Index;
+	};
+
+	void Restart(const FSnakeGrid& Grid, int32 Start, int32 NewGoal, uint64 JournalSerial);
+	void ComputeShortestPath(const FSnakeGrid& Grid, int32 Start);
+
+	FKey CalculateKey(int32 Index, int32 Start) const;
+	uint32 ComputeRhs(const FSnakeGrid& Grid, int32 Index) const;
+	void UpdateVertex(int32 Index, int32 Start);
+	void Touch(int32 Index);
+
+	uint32 GetG(int32 Index) const { return Stamp[Index] == Generation ? G[Index] : Unreachable; }
+	uint32 GetRhs(int32 Index) const { return Stamp[Index] == Generation ? Rhs[Index] : Unreachable; }
+	void SetG(int32 Index, uint32 Value) { Touch(Index); G[Index] = Value; }
+	void SetRhs(int32 Index, uint32 Value) { Touch(Index); Rhs[Index] = Value; }
+
+	int32 Goal = INDEX_NONE;
+	int32 LastStart = INDEX_NONE;
+	int32 SizeY = 0;
+	uint64 Km = 0;
+	uint64 Serial = 0;
+	int32 NumExpanded = 0;
+
+	// g and rhs only hold values for cells stamped with the current generation, the rest are unreachable.
+	TArray<uint32> Stamp;
+	TArray<uint32> G;
+	TArray<uint32> Rhs;
+	uint32 Generation = 0;
+
+	// Entries aren't removed when a cell's key changes; stale ones are skipped or requeued when popped.
+	TArray<FOpenNode> Open;
+};
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Compiled level pack (Content/Levels/Levels.snakepack).
+ *
+ * Layout: FSnakeLevelPackHeader, then one FSnakeLevelPackEntry per level (sorted by level index),
+ * then per level three cell bitplanes (wall, floor, door) and three arrays of precomputed instance
+ * translations. Every section is 16 byte aligned so the file can be mapped and read in place.
+ */
+struct FSnakeLevelPackHeader
+{
+	static constexpr uint32 ExpectedMagic = 0x504B4E53; // "SNKP"
+	static constexpr uint32 CurrentVersion = 1;
+
+	uint32 Magic = ExpectedMagic;
+	uint32 Version = CurrentVersion;
+	uint32 NumLevels = 0;
+	float TileSize = 0.0f;
+	uint64 IndexOffset = 0;
+	uint64 FileSize = 0;
+};
+static_assert(sizeof(FSnakeLevelPackHeader) == 32, "Level pack header layout changed");
+
+struct FSnakeLevelPackEntry
+{
+	int32 LevelIndex = 0;
+	int32 Width = 0;
+	int32 Height = 0;
+	int32 WordsPerRow = 0;
+
+	int32 NumWalls = 0;
+	int32 NumFloors = 0;
+	int32 NumDoors = 0;
+	int32 Padding = 0;
+
+	uint64 WallPlaneOffset = 0;
+	uint64 FloorPlaneOffset = 0;
+	uint64 DoorPlaneOffset = 0;
+
+	uint64 WallTranslationsOffset = 0;
+	uint64 FloorTranslationsOffset = 0;
+	uint64 DoorTranslationsOffset = 0;
+};
+static_assert(sizeof(FSnakeLevelPackEntry) == 80, "Level pack entry layout changed");
+
+/** Non-owning view of one level, either inside a mapped pack or inside an FSnakeLevelData. */
+struct FSnakeLevelView
+{
+	int32 Width = 0;
+	int32 Height = 0;
+	int32 WordsPerRow = 0;
+
+	// Bitplanes, row-major by text row, WordsPerRow words per row.
+	TConstArrayView<uint64> WallPlane;
+	TConstArrayView<uint64> FloorPlane;
+	TConstArrayView<uint64> DoorPlane;
+
+	// Instance translations relative to the ASnakeWorld actor. Floors are '.' tiles only,
+	// doors ('D') are rendered as floor too but are not walkable.
+	TConstArrayView<FVector3f> WallTranslations;
+	TConstArrayView<FVector3f> FloorTranslations;
+	TConstArrayView<FVector3f> DoorTranslations;
+
+	bool IsValid() const { return Width > 0 && Height > 0; }
+
+	static bool TestBit(TConstArrayView<uint64> Plane, int32 WordsPerRow, int32 Row, int32 Column)
+	{
+		return (Plane[Row * WordsPerRow + (Column >> 6)] >> (Column & 63)) & 1;
+	}
+};
+
+/** A level parsed from its .txt source, owning its own buffers. */
+struct SNAKESIM_API FSnakeLevelData
+{
+	int32 LevelIndex = 0;
+	int32 Width = 0;
+	int32 Height = 0;
+	int32 WordsPerRow = 0;
+
+	TArray<uint64> WallPlane;
+	TArray<uint64> FloorPlane;
+	TArray<uint64> DoorPlane;
+
+	TArray<FVector3f> WallTranslations;
+	TArray<FVector3f> FloorTranslations;
+	TArray<FVector3f> DoorTranslations;
+
+	/** Parses the text format: '#' wall, '.' floor, 'D' door, anything else is empty. */
+	bool ParseText(const TArray<FString>& Lines, float InTileSize);
+
+	bool LoadFromTextFile(const FString& FilePath, float InTileSize);
+
+	FSnakeLevelView GetView() const;
+};
+
+/** Read-only, memory mapped level pack. Falls back to a single read when the platform can't map the file. */
+class SNAKESIM_API FSnakeLevelPack
+{
+public:
+	FSnakeLevelPack();
+	~FSnakeLevelPack();
+
+	FSnakeLevelPack(const FSnakeLevelPack&) = delete;
+	FSnakeLevelPack& operator=(const FSnakeLevelPack&) = delete;
+
+	bool Open(const FString& FilePath);
+	bool IsOpen() const { return Data != nullptr; }
+
+	bool HasLevel(int32 LevelIndex) const { return FindEntry(LevelIndex) != nullptr; }
+	bool FindLevel(int32 LevelIndex, FSnakeLevelView& OutView) const;
+	float GetTileSize() const { return Header ? Header->TileSize : 0.0f; }
+
+	/** Whether the file at SourcePath changed after the pack was written, so the pack's copy of it is out of date. */
+	bool IsOlderThan(const FString& SourcePath) const;
+
+	static bool Write(const FString& FilePath, const TArray<FSnakeLevelData>& Levels, float InTileSize);
+
+	/** Default pack location, next to the .txt sources. */
+	static FString GetDefaultPackPath();
+
+private:
+	const FSnakeLevelPackEntry* FindEntry(int32 LevelIndex) const;
+	bool Validate();
+
+	TUniquePtr<IMappedFileHandle> MappedHandle;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	TArray64<uint8> FallbackBuffer;
+
+	const uint8* Data = nullptr;
+	int64 DataSize = 0;
+	const FSnakeLevelPackHeader* Header = nullptr;
+	TConstArrayView<FSnakeLevelPackEntry> Entries;
+	FDateTime TimeStamp;
+};
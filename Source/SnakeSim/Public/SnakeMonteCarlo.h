@@ -0,0 +1,71 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SnakeSimState.h"
+
+/**
+ * Monte Carlo tree search over one snake's moves, for an opponent that looks ahead instead of heading
+ * straight for the nearest apple. Each iteration plays the board forward from the current state: down
+ * the tree by UCB1, then a quick random game where every snake leans towards food, scored by whether
+ * our snake lives and how much more it ate than the others.
+ *
+ * Nodes are sequences of our own moves, the other snakes' moves are played out afresh every time, so
+ * the tree stays small and after a tile the subtree of the move we made is still good. One tree per
+ * worker (root parallel), their root statistics are added up to pick the move.
+ */
+class SNAKESIM_API FSnakeMonteCarlo
+{
+public:
+	struct FSettings
+	{
+		// Wall time for one decision, all workers search until then.
+		double TimeBudget = 0.004;
+		int32 RolloutDepth = 30;
+		int32 MaxNodesPerTree = 1 << 16;
+		float Exploration = 0.7f;
+	};
+
+	/** Best direction for Snake from Root, INDEX_NONE if it has no way to go. Grows the trees kept from earlier calls. */
+	int32 Search(const FSnakeSimState& Root, int32 Snake, const FSettings& Settings);
+
+	/** Our snake made Move, keep that part of the trees for the next search. */
+	void Advance(int32 Move);
+
+	void Reset();
+
+	/** The move played for Snake during rollouts: mostly towards the nearest apple, sometimes any safe way. INDEX_NONE when none is safe. */
+	static int32 ChooseRolloutMove(const FSnakeSimState& State, int32 Snake, FRandomStream& Random);
+
+	/** Games played out by the last search, over all workers. */
+	int32 GetNumRollouts() const { return NumRollouts; }
+	int32 GetNumNodes() const;
+
+private:
+	static constexpr int32 NumMoves = 4;
+
+	struct FNode
+	{
+		// Children are NumMoves nodes in a row, one per direction
+		int32 FirstChild = INDEX_NONE;
+		int32 Visits = 0;
+		float Value = 0.0f;
+	};
+
+	struct FTree
+	{
+		TArray<FNode> Nodes;
+		TArray<FNode> Scratch;
+		TArray<int32> Visited;
+		FSnakeSimState State;
+		FRandomStream Random;
+		int32 NumRollouts = 0;
+	};
+
+	static void RunIteration(FTree& Tree, const FSnakeSimState& Root, int32 Snake, const FSettings& Settings);
+	static int32 SelectMove(FTree& Tree, int32 Node, int32 Snake, float Exploration);
+	static float Evaluate(const FSnakeSimState& State, const FSnakeSimState& Root, int32 Snake);
+	static void KeepSubtree(FTree& Tree, int32 NewRoot);
+
+	TArray<FTree> Trees;
+	int32 NumRollouts = 0;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FSnakeGrid;
+
+/**
+ * First move of a shortest path between every pair of walkable cells of a level, ignoring snakes.
+ * Built once per level from one breadth first search per cell, on worker threads, since walls never
+ * change during play. Cells are numbered in grid order, and each source stores its first moves as runs
+ * over target numbers: neighbouring targets usually share a first move, so a row of thousands of
+ * targets shrinks to a few dozen runs. A lookup is a binary search in one row.
+ *
+ * O(cells^2) to build, only meant for small and medium levels. Immutable once built, safe to share
+ * between threads.
+ */
+class SNAKESIM_API FSnakeNextHopTable
+{
+public:
+	static constexpr uint8 NoMove = 4;
+
+	/** Builds the table for the walkable cells of Grid, spread over the task graph. */
+	void Build(const FSnakeGrid& Grid);
+
+	/** Loads a table written by SaveToFile, false if there is none or it was made for other walls. */
+	bool LoadFromFile(const FString& FilePath, const FSnakeGrid& Grid);
+	bool SaveToFile(const FString& FilePath);
+
+	bool IsBuilt() const { return CellToNode.Num() > 0; }
+	int32 GetNumCells() const { return NodeToCell.Num(); }
+	int32 GetNumRuns() const { return Runs.Num(); }
+
+	/** Direction of the first step from one grid cell to another, INDEX_NONE if either isn't walkable or there is no way. */
+	int32 GetFirstMove(int32 From, int32 To) const;
+
+	/**
+	 * Shortest path from Start to Goal through the walls, accepted only if no snake is on it. Start may
+	 * be occupied. False means searching is needed: a snake blocks the route, or there is no route at all.
+	 */
+	bool FindFreePath(const FSnakeGrid& Grid, int32 Start, int32 Goal, TArray<int32>& OutPath) const;
+
+	SIZE_T GetAllocatedSize() const
+	{
+		return CellToNode.GetAllocatedSize() + NodeToCell.GetAllocatedSize() + RowOffsets.GetAllocatedSize() + Runs.GetAllocatedSize();
+	}
+
+private:
+	static constexpr uint32 FileMagic = 0x504F484E; // 'NHOP'
+	static constexpr uint32 FileVersion = 1;
+	static constexpr uint32 MoveBits = 3;
+
+	// Numbers the walkable cells, returns a hash of which cells those are.
+	uint32 MapCells(const FSnakeGrid& Grid);
+
+	// Grid index to cell number and back, INDEX_NONE for cells that aren't walkable.
+	TArray<int32> CellToNode;
+	TArray<int32> NodeToCell;
+
+	// Runs of one source are Runs[RowOffsets[Source]] up to RowOffsets[Source + 1]. Each run is the
+	// first target number it covers shifted up by MoveBits, or'd with the move.
+	TArray<uint32> RowOffsets;
+	TArray<uint32> Runs;
+
+	int32 SizeX = 0;
+	int32 SizeY = 0;
+	uint32 WallsHash = 0;
+};
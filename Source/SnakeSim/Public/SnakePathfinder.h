@@ -0,0 +1,80 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SnakeGrid.h"
+
+/**
+ * Shortest paths over FSnakeGrid cell indices: plain breadth first search, or jump point search for open
+ * levels. The frontier, parent and visited buffers are sized once per grid and reused; visited marks are
+ * stamped with a generation so nothing is cleared between searches. After the first search on a grid,
+ * searching doesn't allocate.
+ *
+ * Not thread safe, give every thread its own instance.
+ */
+class SNAKESIM_API FSnakePathfinder
+{
+public:
+	/** Sizes the buffers for a grid with this many cells. Called by the searches, only reallocates when the size changes. */
+	void Reserve(int32 NumCells);
+
+	/**
+	 * Shortest path over free cells (walkable, no snake part) from Start to Goal. Start may be occupied,
+	 * it's where the head is. OutPath receives the cells from Start to Goal, both included.
+	 */
+	bool FindPath(const FSnakeGrid& Grid, int32 Start, int32 Goal, TArray<int32>& OutPath);
+
+	/**
+	 * Shortest path to the nearest cell with a flag, by walking distance. Stops at the first such cell,
+	 * so it's one search however many of them there are.
+	 */
+	bool FindPathToNearest(const FSnakeGrid& Grid, int32 Start, ESnakeCell Flag, TArray<int32>& OutPath);
+
+	/**
+	 * Same as FindPath, and finds paths of the same length, but with A* over jump points. Straight runs
+	 * are scanned instead of queued, so open areas expand far fewer cells.
+	 *
+	 * Jump points on a 4-connected grid: a horizontal run (along Y) stops wherever a vertical run from it
+	 * would reach a jump point; a vertical run stops where a side cell is free but the side cell one step
+	 * back isn't, as any other turn could have been taken earlier at the same length.
+	 */
+	bool FindPathJumpPoint(const FSnakeGrid& Grid, int32 Start, int32 Goal, TArray<int32>& OutPath);
+
+	/** Cells taken off the frontier or open list by the last search. */
+	int32 GetNumExpanded() const { return NumExpanded; }
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	struct FOpenNode
+	{
+		int32 Cost;
+		int32 Distance;
+		int32 Index;
+		// Directions the cell was entered from at this distance, each allows different turns.
+		uint8 Entries;
+	};
+
+	uint32 NextGeneration();
+
+	// Returns the first cell IsGoal accepts, Parent then leads back to Start.
+	template <typename GoalPredicate>
+	int32 SearchBreadthFirst(const FSnakeGrid& Grid, int32 Start, GoalPredicate IsGoal);
+	void BuildPath(int32 Start, int32 End, TArray<int32>& OutPath) const;
+
+	int32 JumpHorizontal(const FSnakeGrid& Grid, int32 From, int32 Direction, int32 Goal) const;
+	int32 JumpVertical(const FSnakeGrid& Grid, int32 From, int32 Direction, int32 Goal) const;
+	void ExpandJumpPoint(const FSnakeGrid& Grid, int32 From, int32 Direction, int32 Goal, uint32 Mark);
+
+	TArray<int32> Frontier;
+	TArray<int32> Parent;
+	TArray<uint32> Visited;
+	uint32 Generation = 0;
+	int32 NumExpanded = 0;
+
+	// Jump point search only: best distance so far, the direction of the run from Parent, and every
+	// direction the cell was reached from at that distance.
+	TArray<int32> Distance;
+	TArray<uint8> EnteredFrom;
+	TArray<uint8> EntryMask;
+	TArray<FOpenNode> Open;
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FSnakeGrid;
+
+/**
+ * Where every snake will be over the next few tile steps, shared by all AI snakes in a match. Time is
+ * counted in steps from now; all snakes move at the same speed, so one step is one tile for everyone.
+ *
+ * Bodies say when their cells become free: the tail end leaves after one step, the cell before it
+ * after two, and so on up to the head. Heads reserve the cells they are headed for, either from the
+ * path their controller published or from a guess along their current direction.
+ */
+class SNAKESIM_API FSnakeReservationTable
+{
+public:
+	// Reservations further ahead than this are dropped, searches never look that far.
+	static constexpr int32 MaxSteps = 64;
+
+	/** Forgets all bodies and reservations. */
+	void Reset(int32 NumCells);
+
+	/** Cells of one snake, head first. */
+	void AddBody(TConstArrayView<int32> Body);
+
+	/** Path[Step] is the cell Owner's head will be on after Step steps, Path[0] being where it is now. Replaces Owner's earlier reservations. */
+	void Reserve(TConstArrayView<int32> Path, int32 Owner);
+
+	/** Guess for a snake that didn't say where it's going: any cell it can turn into next, then straight on. */
+	void ReserveAhead(const FSnakeGrid& Grid, int32 Head, int32 Direction, int32 Owner, int32 NumSteps);
+
+	void Release(int32 Owner);
+
+	/** Steps until no body is left on the cell, 0 if there is none now. */
+	int32 GetVacatedStep(int32 Index) const { return VacatedStep.IsValidIndex(Index) ? VacatedStep[Index] : 0; }
+
+	/** Whose head is expected on the cell at Step, INDEX_NONE if nobody's. */
+	int32 GetReservation(int32 Index, int32 Step) const;
+
+	/**
+	 * Whether a head other than Owner's gets to the cell at or before Step. Its body follows it in and
+	 * stays longer than anyone looks ahead, so the cell is taken from then on.
+	 */
+	bool IsClaimedByOther(int32 Index, int32 Step, int32 Owner) const;
+
+	int32 GetNumClaimedCells() const { return Claims.Num(); }
+
+private:
+	struct FClaim
+	{
+		int32 Step;
+		int32 Owner;
+	};
+
+	void Add(int32 Index, int32 Step, int32 Owner);
+
+	TArray<uint16> VacatedStep;
+	// Cells with a body on them, cleared by the next Reset.
+	TArray<int32> BodyCells;
+
+	// Heads expected on a cell, and the cells each owner claimed so they can be released.
+	TMap<int32, TArray<FClaim, TInlineAllocator<2>>> Claims;
+	TMap<int32, TArray<int32>> OwnerCells;
+};
+
+/**
+ * Breadth first search through cells and time (space-time A* without the heuristic, every move costs
+ * one step). A cell can be entered once the bodies on it are gone and while no other head is expected
+ * there, so a path may run through a tail that will have moved on by then. Snakes can't wait or turn
+ * back, so every step of the path is a move to a new cell. The body follows the head along the path,
+ * so the path can't cross its own last BodyLength cells either; the first way found to a cell at a
+ * step is the only one kept.
+ *
+ * Bounded by Horizon steps: when the goal is further, the path leads to the cell closest to it among
+ * those reachable in the most steps, which is also the way to stay alive the longest.
+ */
+class SNAKESIM_API FSnakeSpaceTimeSearch
+{
+public:
+	/**
+	 * True when the path reaches Goal. Otherwise OutPath is the best partial path, empty when every move
+	 * runs into something. Owner's own reservations don't block, BackDirection is never the first move.
+	 * BodyLength is the number of cells behind the head.
+	 */
+	bool FindPath(const FSnakeGrid& Grid, const FSnakeReservationTable& Table, int32 Start, int32 Goal, int32 Owner,
+	              int32 BackDirection, int32 BodyLength, int32 Horizon, TArray<int32>& OutPath);
+
+	/** Cell and step pairs visited by the last search. */
+	int32 GetNumExpanded() const { return Nodes.Num(); }
+
+	SIZE_T GetAllocatedSize() const { return Nodes.GetAllocatedSize() + Seen.GetAllocatedSize(); }
+
+private:
+	struct FNode
+	{
+		int32 Cell;
+		int32 Parent;
+	};
+
+	void BuildPath(int32 Node, TArray<int32>& OutPath) const;
+
+	// Whether the body covers Cell once the head moves on from Node: Node's cell and the ones before it on the path.
+	bool IsUnderOwnBody(int32 Node, int32 Cell, int32 BodyLength) const;
+
+	// Nodes of step t are contiguous, layer after layer.
+	TArray<FNode> Nodes;
+
+	// Seen[Cell] == SeenBase + Step once the cell has been reached at that step.
+	TArray<uint32> Seen;
+	uint32 SeenBase = 0;
+};
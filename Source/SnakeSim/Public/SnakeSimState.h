@@ -0,0 +1,120 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FSnakeGrid;
+
+/**
+ * The whole board in a few flat arrays, walls, food and every snake's body as a ring of cells. It is
+ * the rules of the game: USnakeSimSubsystem steps one for the level being played and the pawns show
+ * what it did, Monte Carlo search and the headless program play copies of it forward. Copying one onto
+ * another of the same level reuses its memory, so a search can restart from a saved state thousands of
+ * times a second.
+ *
+ * Snakes move together, one cell per step. A snake dies running into a wall or a body, or meeting
+ * another head on the same cell; its body is taken off the board. Eating makes the tail stay put on
+ * the next step. New food appears on a random free cell, unless the board's owner places it (SetFood).
+ *
+ * Bodies share one array, a block per snake as long as the longest body rounded up to a power of two,
+ * which grows as the snakes do.
+ */
+class SNAKESIM_API FSnakeSimState
+{
+public:
+	// Enough for the arena's crowd; searches keep a move per snake on the stack.
+	static constexpr int32 MaxSnakes = 256;
+
+	/** Walls and food from the grid, no snakes. */
+	void Init(const FSnakeGrid& Grid);
+
+	/**
+	 * Cells head first, Direction is the way it's going or INDEX_NONE, Growth how many more steps the tail
+	 * stays put. Returns the snake's number, INDEX_NONE when full; numbers of removed snakes are given out again.
+	 */
+	int32 AddSnake(TConstArrayView<int32> Body, int32 Direction, int32 Growth = 0);
+
+	/** Takes a snake off the board for good, AddSnake may reuse its number. */
+	void RemoveSnake(int32 Snake);
+
+	/** Moves every living snake one cell, Moves[Snake] being a direction; INDEX_NONE or back keeps going straight. */
+	void Step(TConstArrayView<int32> Moves, FRandomStream& Random);
+
+	/** The same for boards whose owner places the food: eaten food isn't replaced. */
+	void Step(TConstArrayView<int32> Moves);
+
+	void SetFood(int32 Index, bool bHasFood);
+
+	/** The tail stays put for Steps more steps, as if the snake had eaten. */
+	void AddGrowth(int32 Snake, int32 Steps) { Snakes[Snake].Growth += Steps; }
+
+	int32 GetNumSnakes() const { return Snakes.Num(); }
+	int32 GetNumAlive() const { return NumAlive; }
+	bool IsAlive(int32 Snake) const { return Snakes[Snake].bAlive; }
+	int32 GetHead(int32 Snake) const { return Bodies[Snake * Capacity + Snakes[Snake].Head]; }
+	int32 GetDirection(int32 Snake) const { return Snakes[Snake].Direction; }
+	int32 GetLength(int32 Snake) const { return Snakes[Snake].Length; }
+	int32 GetFoodEaten(int32 Snake) const { return Snakes[Snake].FoodEaten; }
+	int32 GetGrowth(int32 Snake) const { return Snakes[Snake].Growth; }
+	TConstArrayView<int32> GetFoodCells() const { return FoodCells; }
+
+	/** Offset 0 is the head, GetLength() - 1 the tail end. */
+	int32 GetBodyCell(int32 Snake, int32 Offset) const { return Bodies[Snake * Capacity + ((Snakes[Snake].Head + Offset) & (Capacity - 1))]; }
+
+	/** Directions a snake can take without dying on the next step, as far as this snake alone can tell. */
+	int32 GetSafeMoves(int32 Snake, int32 (&OutMoves)[4]) const;
+
+	/** Food closest to From by Manhattan distance, INDEX_NONE when there is none. */
+	int32 FindNearestFood(int32 From) const;
+
+	int32 GetDistance(int32 A, int32 B) const { return FMath::Abs(A / SizeY - B / SizeY) + FMath::Abs(A % SizeY - B % SizeY); }
+	int32 GetNeighbour(int32 Index, int32 Direction) const;
+	int32 GetSizeX() const { return SizeX; }
+	int32 GetSizeY() const { return SizeY; }
+
+	bool IsBlocked(int32 Index) const { return (Cells[Index] & (Walkable | OccupantMask)) != Walkable; }
+
+private:
+	static constexpr uint8 Walkable = 1 << 0;
+	static constexpr uint8 Food = 1 << 1;
+	// The occupant count sits where FSnakeGrid keeps it and goes through its helpers.
+	static constexpr uint8 OccupantMask = 0xF0;
+
+	// Spawning food tries this many random cells, a full board just has less food.
+	static constexpr int32 FoodSpawnTries = 16;
+
+	static constexpr int32 MinCapacity = 16;
+
+	struct FSnake
+	{
+		int32 Head = 0;
+		int32 Length = 0;
+		int32 Direction = INDEX_NONE;
+		int32 Growth = 0;
+		int32 FoodEaten = 0;
+		bool bAlive = true;
+	};
+
+	void StepSnakes(TConstArrayView<int32> Moves, FRandomStream* Random);
+	void Kill(int32 Snake);
+	void SpawnFood(FRandomStream& Random);
+
+	// Makes every snake's block hold at least Length cells.
+	void ReserveLength(int32 Length);
+
+	int32 SizeX = 0;
+	int32 SizeY = 0;
+
+	// Cell flags, with the number of body parts on the cell in the high bits.
+	TArray<uint8> Cells;
+	TArray<int32> FoodCells;
+	// Same for every copy, shared rather than copied.
+	TSharedPtr<const TArray<int32>> FloorCells;
+
+	// Capacity cells per snake, the head at FSnake::Head and the body behind it at increasing offsets.
+	TArray<FSnake, TInlineAllocator<4>> Snakes;
+	TArray<int32> Bodies;
+	int32 Capacity = 0;
+	int32 NumAlive = 0;
+	// Numbers of removed snakes, for AddSnake to reuse.
+	TArray<int32> FreeSnakes;
+};
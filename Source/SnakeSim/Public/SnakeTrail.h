@@ -0,0 +1,48 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Deque.h"
+
+/**
+ * The path the head has taken, as a polyline through the points where it turned, each with the
+ * distance travelled up to it. Straight runs are one line however long, so the trail holds a point per
+ * turn rather than per frame, and dropping the far end as the snake moves on is a pop off the front.
+ *
+ * Positions along it are asked for by distance behind the head.
+ */
+class SNAKESIM_API FSnakeTrail
+{
+public:
+	void Reset(const FVector& Head);
+
+	/** The head has moved to Head, the straight line it's on grows or a new line starts. */
+	void Add(const FVector& Head);
+
+	/** Drops the points no longer needed to reach Length behind the head. */
+	void Trim(double Length);
+
+	/** Where the head was Distance ago, the far end of the trail when it isn't that long. */
+	FVector GetPointBehind(double Distance) const;
+
+	/** Count points Spacing apart, starting one Spacing behind the head. A single walk down the trail. */
+	void Sample(double Spacing, int32 Count, TArray<FVector>& OutPoints) const;
+
+	double GetLength() const { return Points.Num() > 0 ? Points.Last().Distance - Points.First().Distance : 0.0; }
+	int32 GetNumPoints() const { return Points.Num(); }
+
+private:
+	// How far off the line the head may wander (in a jump, say) before it counts as a turn.
+	static constexpr double Tolerance = 1.0;
+
+	struct FPoint
+	{
+		FVector Position;
+		// Travelled up to this point since the last Reset
+		double Distance;
+	};
+
+	FVector Interpolate(int32 Index, double Distance) const;
+
+	// Oldest first, the last point is the head
+	TDeque<FPoint> Points;
+};
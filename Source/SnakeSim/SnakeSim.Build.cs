@@ -0,0 +1,13 @@
+using UnrealBuildTool;
+
+// Grid, searches, level packs and the board simulation. Core only, no UObjects, so it also builds into
+// the SnakeSimHeadless program.
+public class SnakeSim : ModuleRules
+{
+	public SnakeSim(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(new string[] { "Core" });
+	}
+}
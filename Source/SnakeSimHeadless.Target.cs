@@ -0,0 +1,26 @@
+using UnrealBuildTool;
+using System.Collections.Generic;
+
+[SupportedPlatforms(UnrealPlatformClass.Desktop)]
+public class SnakeSimHeadlessTarget : TargetRules
+{
+	public SnakeSimHeadlessTarget(TargetInfo Target) : base(Target)
+	{
+		Type = TargetType.Program;
+		DefaultBuildSettings = BuildSettingsVersion.V5;
+		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_5;
+		LinkType = TargetLinkType.Monolithic;
+		LaunchModuleName = "SnakeSimHeadless";
+
+		// A console program on Core and SnakeSim only, starts in milliseconds
+		bBuildDeveloperTools = false;
+		bCompileAgainstEngine = false;
+		bCompileAgainstCoreUObject = false;
+		bCompileAgainstApplicationCore = false;
+		bCompileICU = false;
+		bIsBuildingConsoleApplication = true;
+
+		// -Test runs the SnakeSim automation tests, keep them compiled in whatever the configuration
+		bForceCompileDevelopmentAutomationTests = true;
+	}
+}
@@ -0,0 +1,233 @@
+#include "RequiredProgramMainCPPInclude.h"
+#include "Misc/AutomationTest.h"
+#include "SnakeGrid.h"
+#include "SnakeLevelPack.h"
+#include "SnakeMonteCarlo.h"
+#include "SnakeSimState.h"
+
+IMPLEMENT_APPLICATION(SnakeSimHeadless, "SnakeSimHeadless");
+
+/**
+ * Plays seeded games on one level with FSnakeSimState, no engine or world, and prints how they went
+ * and how fast they ran. Every snake plays the rollout policy; with -BudgetMs the first one searches
+ * with FSnakeMonteCarlo instead.
+ *
+ * SnakeSimHeadless -Level=<LevelN.txt> [-Games=100] [-Snakes=2] [-Food=3] [-Steps=2000] [-Seed=1] [-BudgetMs=0]
+ *
+ * With -Test it runs the SnakeGame.SnakeSim automation tests instead and exits with 1 if any fails.
+ */
+namespace
+{
+    struct FRunSettings
+    {
+        int32 NumGames = 100;
+        int32 NumSnakes = 2;
+        int32 NumFood = 3;
+        int32 MaxSteps = 2000;
+        int32 Seed = 1;
+        float BudgetMs = 0.0f;
+    };
+
+    // A random floor cell nothing else was put on yet, INDEX_NONE after a few misses
+    int32 TakeFreeCell(const TArray<int32>& Floor, TSet<int32>& Taken, FRandomStream& Random)
+    {
+        for (int32 Try = 0; Try < 64 && Floor.Num() > 0; Try++)
+        {
+            const int32 Index = Floor[Random.RandHelper(Floor.Num())];
+            if (!Taken.Contains(Index))
+            {
+                Taken.Add(Index);
+                return Index;
+            }
+        }
+        return INDEX_NONE;
+    }
+
+    int32 Run(const FSnakeGrid& LevelGrid, const FRunSettings& Settings)
+    {
+        TArray<int32> Floor;
+        for (int32 Index = 0; Index < LevelGrid.Num(); Index++)
+        {
+            if (LevelGrid.IsWalkableAt(Index))
+            {
+                Floor.Add(Index);
+            }
+        }
+        if (Floor.Num() < Settings.NumSnakes + Settings.NumFood)
+        {
+            UE_LOG(LogTemp, Error, TEXT("Level has %d floor cells, too few for %d snakes and %d food"), Floor.Num(), Settings.NumSnakes, Settings.NumFood);
+            return 1;
+        }
+
+        FRandomStream Random(Settings.Seed);
+        FSnakeSimState State;
+        FSnakeMonteCarlo MonteCarlo;
+        FSnakeMonteCarlo::FSettings SearchSettings;
+        SearchSettings.TimeBudget = Settings.BudgetMs / 1000.0;
+
+        int64 TotalSteps = 0;
+        int64 TotalFood = 0;
+        int64 SearcherFood = 0;
+        int64 SearcherSteps = 0;
+        int32 SearcherWins = 0;
+        int32 Moves[FSnakeSimState::MaxSnakes];
+        TSet<int32> Taken;
+
+        const double StartTime = FPlatformTime::Seconds();
+        for (int32 Game = 0; Game < Settings.NumGames; Game++)
+        {
+            FSnakeGrid Grid = LevelGrid;
+            Taken.Reset();
+            for (int32 Food = 0; Food < Settings.NumFood; Food++)
+            {
+                const int32 Index = TakeFreeCell(Floor, Taken, Random);
+                if (Index != INDEX_NONE)
+                {
+                    Grid.SetFood(Grid.ToCell(Index), true);
+                }
+            }
+
+            State.Init(Grid);
+            for (int32 Snake = 0; Snake < FMath::Min(Settings.NumSnakes, FSnakeSimState::MaxSnakes); Snake++)
+            {
+                const int32 Head = TakeFreeCell(Floor, Taken, Random);
+                if (Head != INDEX_NONE)
+                {
+                    State.AddSnake(MakeArrayView(&Head, 1), INDEX_NONE);
+                }
+            }
+            MonteCarlo.Reset();
+
+            const TConstArrayView<int32> MoveView(Moves, State.GetNumSnakes());
+            int32 Step = 0;
+            for (; Step < Settings.MaxSteps && State.GetNumAlive() > 0; Step++)
+            {
+                const bool bSearching = Settings.BudgetMs > 0.0f && State.IsAlive(0);
+                for (int32 Snake = 0; Snake < State.GetNumSnakes(); Snake++)
+                {
+                    Moves[Snake] = bSearching && Snake == 0
+                        ? MonteCarlo.Search(State, 0, SearchSettings)
+                        : FSnakeMonteCarlo::ChooseRolloutMove(State, Snake, Random);
+                }
+                State.Step(MoveView, Random);
+                if (bSearching)
+                {
+                    MonteCarlo.Advance(Moves[0]);
+                    SearcherSteps++;
+                }
+            }
+
+            TotalSteps += Step;
+            int32 MostOthersAte = 0;
+            for (int32 Snake = 0; Snake < State.GetNumSnakes(); Snake++)
+            {
+                TotalFood += State.GetFoodEaten(Snake);
+                if (Snake > 0)
+                {
+                    MostOthersAte = FMath::Max(MostOthersAte, State.GetFoodEaten(Snake));
+                }
+            }
+            SearcherFood += State.GetNumSnakes() > 0 ? State.GetFoodEaten(0) : 0;
+            SearcherWins += State.GetNumSnakes() > 1 && State.GetFoodEaten(0) > MostOthersAte ? 1 : 0;
+        }
+        const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+        UE_LOG(LogTemp, Display, TEXT("%d games, %lld steps in %.3f s (%.0f ns per step)"),
+               Settings.NumGames, TotalSteps, Seconds, TotalSteps > 0 ? Seconds * 1.0e9 / TotalSteps : 0.0);
+        UE_LOG(LogTemp, Display, TEXT("%.2f steps and %.2f food per game"),
+               double(TotalSteps) / Settings.NumGames, double(TotalFood) / Settings.NumGames);
+        if (Settings.BudgetMs > 0.0f)
+        {
+            UE_LOG(LogTemp, Display, TEXT("Searching snake: %.2f food per game, ate most in %d of %d games, %lld searches"),
+                   double(SearcherFood) / Settings.NumGames, SearcherWins, Settings.NumGames, SearcherSteps);
+        }
+        return 0;
+    }
+
+    int32 RunTests()
+    {
+        FAutomationTestFramework& Framework = FAutomationTestFramework::Get();
+        Framework.SetRequestedTestFilter(EAutomationTestFlags::ProductFilter);
+        TArray<FAutomationTestInfo> Tests;
+        Framework.GetValidTestNames(Tests);
+
+        int32 NumRun = 0;
+        int32 NumFailed = 0;
+        for (const FAutomationTestInfo& Test : Tests)
+        {
+            if (!Test.GetFullTestPath().StartsWith(TEXT("SnakeGame.SnakeSim.")))
+            {
+                continue;
+            }
+
+            Framework.StartTestByName(Test.GetTestName(), 0);
+            FAutomationTestExecutionInfo Info;
+            const bool bPassed = Framework.StopTest(Info);
+            for (const FAutomationExecutionEntry& Entry : Info.GetEntries())
+            {
+                if (Entry.Event.Type == EAutomationEventType::Error)
+                {
+                    UE_LOG(LogTemp, Error, TEXT("%s: %s"), *Test.GetFullTestPath(), *Entry.Event.Message);
+                }
+            }
+            UE_LOG(LogTemp, Display, TEXT("%s %s"), bPassed ? TEXT("Passed") : TEXT("Failed"), *Test.GetFullTestPath());
+            NumRun++;
+            NumFailed += bPassed ? 0 : 1;
+        }
+
+        UE_LOG(LogTemp, Display, TEXT("%d tests, %d failed"), NumRun, NumFailed);
+        return NumRun > 0 && NumFailed == 0 ? 0 : 1;
+    }
+}
+
+INT32_MAIN_INT32_ARGC_TCHAR_ARGV()
+{
+    FTaskTagScope Scope(ETaskTag::EGameThread);
+    ON_SCOPE_EXIT
+    {
+        RequestEngineExit(TEXT("Exiting"));
+        FEngineLoop::AppPreExit();
+        FModuleManager::Get().UnloadModulesAtShutdown();
+        FEngineLoop::AppExit();
+    };
+
+    if (const int32 Result = GEngineLoop.PreInit(ArgC, ArgV))
+    {
+        return Result;
+    }
+
+    const TCHAR* CommandLine = FCommandLine::Get();
+    if (FParse::Param(CommandLine, TEXT("Test")))
+    {
+        return RunTests();
+    }
+
+    FString LevelPath;
+    if (!FParse::Value(CommandLine, TEXT("Level="), LevelPath))
+    {
+        UE_LOG(LogTemp, Error, TEXT("Usage: SnakeSimHeadless -Level=<LevelN.txt> [-Games=100] [-Snakes=2] [-Food=3] [-Steps=2000] [-Seed=1] [-BudgetMs=0]"));
+        return 1;
+    }
+
+    FRunSettings Settings;
+    FParse::Value(CommandLine, TEXT("Games="), Settings.NumGames);
+    FParse::Value(CommandLine, TEXT("Snakes="), Settings.NumSnakes);
+    FParse::Value(CommandLine, TEXT("Food="), Settings.NumFood);
+    FParse::Value(CommandLine, TEXT("Steps="), Settings.MaxSteps);
+    FParse::Value(CommandLine, TEXT("Seed="), Settings.Seed);
+    FParse::Value(CommandLine, TEXT("BudgetMs="), Settings.BudgetMs);
+    Settings.NumGames = FMath::Max(Settings.NumGames, 1);
+
+    // The tile size only scales the instance translations, which nothing here looks at
+    FSnakeLevelData Level;
+    if (!Level.LoadFromTextFile(LevelPath, 100.0f))
+    {
+        UE_LOG(LogTemp, Error, TEXT("Failed to load %s"), *LevelPath);
+        return 1;
+    }
+
+    FSnakeGrid Grid;
+    Grid.Init(Level.GetView());
+    UE_LOG(LogTemp, Display, TEXT("%s: %dx%d, %d floor cells"), *LevelPath, Grid.GetSizeX(), Grid.GetSizeY(), Grid.GetNumWalkable());
+    return Run(Grid, Settings);
+}
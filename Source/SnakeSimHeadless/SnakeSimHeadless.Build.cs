@@ -0,0 +1,14 @@
+using System.IO;
+using UnrealBuildTool;
+
+public class SnakeSimHeadless : ModuleRules
+{
+	public SnakeSimHeadless(ReadOnlyTargetRules Target) : base(Target)
+	{
+		// RequiredProgramMainCPPInclude.h pulls in the engine loop
+		PublicIncludePaths.Add(Path.Combine(EngineDirectory, "Source/Runtime/Launch/Public"));
+		PrivateIncludePaths.Add(Path.Combine(EngineDirectory, "Source/Runtime/Launch/Private"));
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "Core", "Projects", "SnakeSim" });
+	}
+}